@@ -36,6 +36,7 @@ option(EGL_API "Use EGL on ZZogl/GSdx (experimental/developer option)")
 option(REBUILD_SHADER "Rebuild GLSL/CG shader (developer option)")
 option(BUILD_REPLAY_LOADERS "Build GS replayer to ease testing (developer option)")
 option(GSDX_LEGACY "Build a GSdx legacy plugin compatible with GL3.3")
+option(GSDX_X64_AVX2 "Use the AVX2 paths of a x86_64 GSdx when ARCH_FLAG enables AVX2 (experimental/developer option)")
 
 #-------------------------------------------------------------------------------
 # Path and lib option
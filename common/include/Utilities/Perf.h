@@ -28,7 +28,7 @@ namespace Perf {
 
 		Info(uptr x86, u32 size, const char* symbol);
 		Info(uptr x86, u32 size, const char* symbol, u32 pc);
-		void Print(FILE* fp);
+		void Print();
 	};
 
 	class InfoVector
@@ -40,13 +40,19 @@ namespace Perf {
 
 		InfoVector(const char* prefix);
 
-		void print(FILE* fp);
+		void print();
 		void map(uptr x86, u32 size, const char* symbol);
 		void map(uptr x86, u32 size, u32 pc);
 		void reset();
 
 	};
 
+	// Linux only: when enabled, /tmp/perf-<pid>.map and /tmp/jit-<pid>.dump are written
+	// as the code is generated, so 'perf report' (after 'perf inject --jit' for the
+	// jitdump) can name every recompiled block.  Off by default.
+	void enable(bool enabled);
+	bool is_enabled();
+
 	void dump();
 	void dump_and_reset();
 
@@ -68,6 +68,10 @@ struct xImpl_JmpCall
 // yes it is awful. Due to template code is in a header with a nice circular dep.
 extern const xImpl_Mov			xMOV;
 extern const xImpl_JmpCall		xCALL;
+#ifdef __x86_64__
+// mov r64, imm64 (xMOV only takes 32 bits immediates)
+extern void xMOV64( const xRegister64& to, s64 imm64 );
+#endif
 
 struct xImpl_FastCall
 {
@@ -168,6 +172,19 @@ struct xImpl_FastCall
 #endif
 	}
 
+	// Pointer sized argument: the u32 forms would truncate it on x86_64.
+	template< typename T > __fi __always_inline_tmpl_fail
+	void operator()( T* func, const void* a1) const
+	{
+#ifdef __x86_64__
+		xMOV64(rdi, (sptr)a1);
+		xCALL(func);
+#else
+		xMOV(ecx, (uptr)a1);
+		xCALL(func);
+#endif
+	}
+
 	void operator()(const xIndirect32& func, const xRegisterLong& a1 = xEmptyReg, const xRegisterLong& a2 = xEmptyReg) const
 	{
 #ifdef __x86_64__
@@ -17,20 +17,157 @@
 
 #include "Perf.h"
 
-//#define ProfileWithPerf
-#define MERGE_BLOCK_RESULT
+#include "Threading.h"
 
+#ifdef __linux__
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 
 namespace Perf
 {
-	// Warning object aren't thread safe
 	InfoVector any("");
 	InfoVector ee("EE");
 	InfoVector iop("IOP");
 	InfoVector vu("VU");
 
 // Perf is only supported on linux
-#if defined(__linux__) && defined(ProfileWithPerf)
+#if defined(__linux__)
+
+	////////////////////////////////////////////////////////////////////////////////
+	// Output files
+	////////////////////////////////////////////////////////////////////////////////
+
+	// See tools/perf/Documentation/jitdump-specification.txt in the kernel tree
+	struct JitHeader
+	{
+		u32 magic;
+		u32 version;
+		u32 total_size;
+		u32 elf_mach;
+		u32 pad1;
+		u32 pid;
+		u64 timestamp;
+		u64 flags;
+	};
+
+	struct JitCodeLoad
+	{
+		u32 id;			// record header
+		u32 total_size;
+		u64 timestamp;
+		u32 pid;
+		u32 tid;
+		u64 vma;
+		u64 code_addr;
+		u64 code_size;
+		u64 code_index;
+		// followed by the name and the code
+	};
+
+	static const u32 JIT_CODE_LOAD = 0;
+
+	// The recompilers map on their own thread, but the VU one may run on the MTVU thread.
+	static Threading::Mutex s_lock;
+
+	static bool  s_enabled = false;
+	static FILE* s_map = NULL;
+	static FILE* s_jit = NULL;
+	static void* s_jit_marker = NULL;
+	static u64   s_code_index = 0;
+
+	// Same clock as 'perf record -k mono'
+	static u64 timestamp()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+
+	static void open_files()
+	{
+		char file[256];
+
+		snprintf(file, sizeof(file), "/tmp/perf-%d.map", getpid());
+		s_map = fopen(file, "w");
+		if (s_map)
+			setvbuf(s_map, NULL, _IOLBF, 0);
+
+		snprintf(file, sizeof(file), "/tmp/jit-%d.dump", getpid());
+		int fd = open(file, O_CREAT | O_TRUNC | O_RDWR, 0666);
+		if (fd < 0)
+			return;
+
+		// perf finds the jitdump through this (executable) mapping of it
+		s_jit_marker = mmap(NULL, __pagesize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+		if (s_jit_marker == MAP_FAILED)
+			s_jit_marker = NULL;
+
+		s_jit = fdopen(fd, "wb");
+		if (!s_jit) {
+			close(fd);
+			return;
+		}
+
+		JitHeader header = {};
+		header.magic = 0x4A695444;
+		header.version = 1;
+		header.total_size = sizeof(header);
+#ifdef __x86_64__
+		header.elf_mach = EM_X86_64;
+#else
+		header.elf_mach = EM_386;
+#endif
+		header.pid = getpid();
+		header.timestamp = timestamp();
+		fwrite(&header, sizeof(header), 1, s_jit);
+		fflush(s_jit);
+	}
+
+	static void close_files()
+	{
+		if (s_map)
+			fclose(s_map);
+		if (s_jit)
+			fclose(s_jit);
+		if (s_jit_marker)
+			munmap(s_jit_marker, __pagesize);
+
+		s_map = NULL;
+		s_jit = NULL;
+		s_jit_marker = NULL;
+	}
+
+	static void write_symbol(uptr x86, u32 size, const char* symbol)
+	{
+		if (s_map)
+			fprintf(s_map, "%lx %x %s\n", (unsigned long)x86, size, symbol);
+
+		if (!s_jit)
+			return;
+
+		size_t name_size = strlen(symbol) + 1;
+
+		JitCodeLoad record = {};
+		record.id = JIT_CODE_LOAD;
+		record.total_size = sizeof(record) + name_size + size;
+		record.timestamp = timestamp();
+		record.pid = getpid();
+		record.tid = syscall(SYS_gettid);
+		record.vma = x86;
+		record.code_addr = x86;
+		record.code_size = size;
+		record.code_index = s_code_index++;
+
+		fwrite(&record, sizeof(record), 1, s_jit);
+		fwrite(symbol, name_size, 1, s_jit);
+		fwrite((void*)x86, size, 1, s_jit);
+		fflush(s_jit);
+	}
 
 	////////////////////////////////////////////////////////////////////////////////
 	// Implementation of the Info object
@@ -39,6 +176,7 @@ namespace Perf
 	Info::Info(uptr x86, u32 size, const char* symbol) : m_x86(x86), m_size(size), m_dynamic(false)
 	{
 		strncpy(m_symbol, symbol, sizeof(m_symbol));
+		m_symbol[sizeof(m_symbol) - 1] = 0;
 	}
 
 	Info::Info(uptr x86, u32 size, const char* symbol, u32 pc) : m_x86(x86), m_size(size), m_dynamic(true)
@@ -46,9 +184,9 @@ namespace Perf
 		snprintf(m_symbol, sizeof(m_symbol), "%s_0x%08x", symbol, pc);
 	}
 
-	void Info::Print(FILE* fp)
+	void Info::Print()
 	{
-		fprintf(fp, "%x %x %s\n", m_x86, m_size, m_symbol);
+		write_symbol(m_x86, m_size, m_symbol);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -60,30 +198,36 @@ namespace Perf
 		strncpy(m_prefix, prefix, sizeof(m_prefix));
 	}
 
-	void InfoVector::print(FILE* fp)
+	void InfoVector::print()
 	{
-		for(auto&& it : m_v) it.Print(fp);
+		for(auto&& it : m_v) it.Print();
 	}
 
 	void InfoVector::map(uptr x86, u32 size, const char* symbol)
 	{
 		// This function is typically used for dispatcher and recompiler.
 		// Dispatchers are on a page and must always be kept.
-		// Recompilers are much bigger (TODO check VIF) and are only
-		// useful when MERGE_BLOCK_RESULT is defined
+		// Recompilers are much bigger (TODO check VIF) and would hide the
+		// blocks, besides most of their reserve isn't even committed.
+		if (size >= 8 * _1kb)
+			return;
 
-#ifdef MERGE_BLOCK_RESULT
+		// Kept so they can be written out if perf is enabled later on
+		Threading::ScopedLock lock(s_lock);
 		m_v.emplace_back(x86, size, symbol);
-#else
-		if (size < 8 * _1kb) m_v.emplace_back(x86, size, symbol);
-#endif
+		if (s_enabled)
+			m_v.back().Print();
 	}
 
 	void InfoVector::map(uptr x86, u32 size, u32 pc)
 	{
-#ifndef MERGE_BLOCK_RESULT
-		m_v.emplace_back(x86, size, m_prefix, pc);
-#endif
+		if (!s_enabled)
+			return;
+
+		// Blocks are written as they come, the perf tools sort out the address reuse
+		// (the jitdump is timestamped).
+		Threading::ScopedLock lock(s_lock);
+		Info(x86, size, m_prefix, pc).Print();
 	}
 
 	void InfoVector::reset()
@@ -96,19 +240,41 @@ namespace Perf
 	// Global function
 	////////////////////////////////////////////////////////////////////////////////
 
-	void dump()
+	void enable(bool enabled)
 	{
-		char file[256];
-		snprintf(file, 250, "/tmp/perf-%d.map", getpid());
-		FILE* fp = fopen(file, "w");
+		Threading::ScopedLock lock(s_lock);
+
+		if (enabled == s_enabled)
+			return;
+
+		s_enabled = enabled;
+		if (!enabled) {
+			close_files();
+			return;
+		}
 
-		any.print(fp);
-		ee.print(fp);
-		iop.print(fp);
-		vu.print(fp);
+		open_files();
 
-		if (fp)
-			fclose(fp);
+		any.print();
+		ee.print();
+		iop.print();
+		vu.print();
+	}
+
+	bool is_enabled()
+	{
+		return s_enabled;
+	}
+
+	void dump()
+	{
+		// Everything is already written, make sure perf sees it.
+		Threading::ScopedLock lock(s_lock);
+
+		if (s_map)
+			fflush(s_map);
+		if (s_jit)
+			fflush(s_jit);
 	}
 
 	void dump_and_reset()
@@ -132,6 +298,9 @@ namespace Perf
 	void InfoVector::map(uptr x86, u32 size, u32 pc) {}
 	void InfoVector::reset() {}
 
+	void enable(bool enabled) {}
+	bool is_enabled() { return false; }
+
 	void dump() {}
 	void dump_and_reset() {}
 
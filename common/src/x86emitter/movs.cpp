@@ -112,6 +112,14 @@ void xImpl_Mov::operator()( const xRegisterInt& to, int imm, bool preserve_flags
 
 const xImpl_Mov xMOV;
 
+#ifdef __x86_64__
+void xMOV64( const xRegister64& to, s64 imm64 )
+{
+	xOpAccWrite( 0, 0xb8 | (to.Id & 7), 0, to );
+	xWrite64( imm64 );
+}
+#endif
+
 // --------------------------------------------------------------------------------------
 //  CMOVcc
 // --------------------------------------------------------------------------------------
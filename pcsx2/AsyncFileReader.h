@@ -25,6 +25,13 @@
 #endif
 #include <memory>
 
+struct AsyncReadRequest
+{
+	void* buffer;
+	uint sector;
+	uint count;
+};
+
 class AsyncFileReader
 {
 protected:
@@ -46,6 +53,18 @@ public:
 	virtual int FinishRead(void)=0;
 	virtual void CancelRead(void)=0;
 
+	// Number of reads which can be in flight at once.  BeginRead can be called that many
+	// times before FinishRead, which then completes the reads in the order they were begun.
+	// CancelRead drops all of them.
+	virtual uint GetQueueDepth(void) const { return 1; }
+
+	// Begins several reads at once (no more than GetQueueDepth), each one still needs its FinishRead.
+	virtual void BeginReads(const AsyncReadRequest* requests, uint count)
+	{
+		for (uint i = 0; i < count; i++)
+			BeginRead(requests[i].buffer, requests[i].sector, requests[i].count);
+	}
+
 	virtual void Close(void)=0;
 
 	virtual uint GetBlockCount(void) const=0;
@@ -65,17 +84,29 @@ class FlatFileReader : public AsyncFileReader
 {
 	DeclareNoncopyableObject( FlatFileReader );
 
+#if defined(_WIN32) || defined(__linux__)
+	static const uint MaxQueueDepth = 4;
+
+	// Reads in flight, oldest at m_queue_head
+	uint m_queue_head;
+	uint m_queue_count;
+#endif
+
 #ifdef _WIN32
 	HANDLE hOverlappedFile;
 
-	OVERLAPPED asyncOperationContext;
-
-	HANDLE hEvent;
+	OVERLAPPED asyncOperationContext[MaxQueueDepth];
 
-	bool asyncInProgress;
+	HANDLE hEvent[MaxQueueDepth];
 #elif defined(__linux__)
 	int m_fd; // FIXME don't know if overlap as an equivalent on linux
 	io_context_t m_aio_context;
+
+	struct iocb m_iocbs[MaxQueueDepth];
+	long m_results[MaxQueueDepth];
+	bool m_done[MaxQueueDepth];
+
+	void WaitForEvents(uint min_nr);
 #elif defined(__POSIX__)
 	int m_fd; // TODO OSX don't know if overlap as an equivalent on OSX
 	struct aiocb m_aio_context;
@@ -95,6 +126,13 @@ public:
 	virtual int FinishRead(void);
 	virtual void CancelRead(void);
 
+#if defined(_WIN32) || defined(__linux__)
+	virtual uint GetQueueDepth(void) const { return MaxQueueDepth; }
+#endif
+#ifdef __linux__
+	virtual void BeginReads(const AsyncReadRequest* requests, uint count);
+#endif
+
 	virtual void Close(void);
 
 	virtual uint GetBlockCount(void) const;
@@ -112,11 +150,16 @@ class MultipartFileReader : public AsyncFileReader
 	struct Part {
 		uint start;
 		uint end; // exclusive
-		bool isReading;
 		AsyncFileReader* reader;
 	} m_parts[MaxParts];
 	uint m_numparts;
 
+	// One bit per part touched by each read in flight, oldest at m_pending_head
+	static const uint MaxQueueDepth = 4;
+	u8 m_pending[MaxQueueDepth];
+	uint m_pending_head;
+	uint m_pending_count;
+
 	uint GetFirstPart(uint lsn);
 	void FindParts();
 
@@ -132,6 +175,8 @@ public:
 	virtual int FinishRead(void);
 	virtual void CancelRead(void);
 
+	virtual uint GetQueueDepth(void) const;
+
 	virtual void Close(void);
 
 	virtual uint GetBlockCount(void) const;
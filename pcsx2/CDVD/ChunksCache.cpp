@@ -16,37 +16,289 @@
 #include "PrecompiledHeader.h"
 #include "ChunksCache.h"
 
-void ChunksCache::SetLimit(uint megabytes) {
-	m_limit = (PX_off_t)megabytes * 1024 * 1024;
-	MatchLimit();
+using namespace Threading;
+
+static const u32 CHUNKSCACHE_MAX_SHARDS = 8;
+
+ChunksCache::ChunksCache(uint limitMb, uint chunkSize) :
+	m_chunkSize(chunkSize),
+	m_slabs(0),
+	m_arena(NULL),
+	m_entries(NULL),
+	m_shards(NULL),
+	m_shardCount(0) {
+	pxAssertDev((chunkSize & (__pagesize - 1)) == 0, "ChunksCache: chunk size must be a multiple of the page size");
+
+	m_slabs = std::max<u32>(1, (u32)(((u64)limitMb * 1024 * 1024) / chunkSize));
+
+	// Only reserved here, each shard commits its part when it's first written to.
+	m_arena = (u8*)HostSys::MmapReservePtr(NULL, (size_t)m_slabs * m_chunkSize);
+	if (!m_arena) {
+		Console.Warning(L"Warning: Can't reserve %u MB for the chunks cache, reading without it.", limitMb);
+		m_slabs = 0;
+	}
+	m_shardCount = std::min(CHUNKSCACHE_MAX_SHARDS, m_slabs);
+
+	m_entries = new Entry[std::max<u32>(1, m_slabs)];
+	m_shards = new Shard[m_shardCount];
+
+	u32 first = 0;
+	for (u32 i = 0; i < m_shardCount; i++) {
+		Shard& shard = m_shards[i];
+		shard.first = first;
+		shard.count = m_slabs / m_shardCount + (i < m_slabs % m_shardCount ? 1 : 0);
+		first += shard.count;
+
+		// Twice as many buckets as slabs keeps the chains short.
+		u32 buckets = 1;
+		while (buckets < shard.count * 2)
+			buckets <<= 1;
+		shard.buckets = new u32[buckets];
+		shard.bucketMask = buckets - 1;
+		shard.committed = false;
+	}
+
+	Clear();
+}
+
+ChunksCache::~ChunksCache() {
+	for (u32 i = 0; i < m_shardCount; i++)
+		delete[] m_shards[i].buckets;
+	delete[] m_shards;
+	delete[] m_entries;
+
+	if (m_arena)
+		HostSys::Munmap(m_arena, (size_t)m_slabs * m_chunkSize);
 }
 
-void ChunksCache::MatchLimit(bool removeAll) {
-	std::list<CacheEntry*>::reverse_iterator rit;
-	while (m_entries.size() && (removeAll || m_size > m_limit)) {
-		rit = m_entries.rbegin();
-		m_size -= (*rit)->size;
-		delete(*rit);
-		m_entries.pop_back();
+void ChunksCache::Clear() {
+	for (u32 i = 0; i < m_shardCount; i++) {
+		Shard& shard = m_shards[i];
+		ScopedLock lock(shard.lock);
+		shard.used = 0;
+		shard.head = NONE;
+		shard.tail = NONE;
+		shard.hits = 0;
+		shard.misses = 0;
+		memset(shard.buckets, 0xff, (shard.bucketMask + 1) * sizeof(u32));
 	}
 }
 
-void ChunksCache::Take(void* pMallocedSrc, PX_off_t offset, int length, int coverage) {
-	m_entries.push_front(new CacheEntry(pMallocedSrc, offset, length, coverage));
-	m_size += length;
-	MatchLimit();
+u64 ChunksCache::GetHits() const {
+	u64 hits = 0;
+	for (u32 i = 0; i < m_shardCount; i++) {
+		ScopedLock lock(m_shards[i].lock);
+		hits += m_shards[i].hits;
+	}
+	return hits;
 }
 
-// By design, succeed only if the entire request is in a single cached chunk
-int ChunksCache::Read(void* pDest, PX_off_t offset, int length) {
-	for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
-		CacheEntry* e = *it;
-		if (e && offset >= e->offset && (offset + length) <= (e->offset + e->coverage)) {
-			if (it != m_entries.begin())
-				m_entries.splice(m_entries.begin(), m_entries, it); // Move to top (MRU)
-			return CopyAvailable(e->data, e->offset, e->size, pDest, offset, length);
+u64 ChunksCache::GetMisses() const {
+	u64 misses = 0;
+	for (u32 i = 0; i < m_shardCount; i++) {
+		ScopedLock lock(m_shards[i].lock);
+		misses += m_shards[i].misses;
+	}
+	return misses;
+}
+
+ChunksCache::Shard& ChunksCache::ShardOf(PX_off_t offset, u32& bucket) const {
+	// Fibonacci hashing of the chunk number, consecutive chunks end up in different shards.
+	u64 hash = (u64)(offset / m_chunkSize) * 0x9E3779B97F4A7C15ull;
+	u32 h = (u32)(hash >> 32);
+	Shard& shard = m_shards[h % m_shardCount];
+	bucket = (h / m_shardCount) & shard.bucketMask;
+	return shard;
+}
+
+u32 ChunksCache::Find(Shard& shard, u32 bucket, PX_off_t offset) const {
+	for (u32 slab = shard.buckets[bucket]; slab != NONE; slab = m_entries[slab].hashNext) {
+		if (m_entries[slab].offset == offset)
+			return slab;
+	}
+	return NONE;
+}
+
+void ChunksCache::Unlink(Shard& shard, u32 slab) {
+	Entry& e = m_entries[slab];
+	if (e.prev != NONE)
+		m_entries[e.prev].next = e.next;
+	else
+		shard.head = e.next;
+	if (e.next != NONE)
+		m_entries[e.next].prev = e.prev;
+	else
+		shard.tail = e.prev;
+}
+
+void ChunksCache::LinkBack(Shard& shard, u32 slab) {
+	Entry& e = m_entries[slab];
+	e.prev = shard.tail;
+	e.next = NONE;
+	if (shard.tail != NONE)
+		m_entries[shard.tail].next = slab;
+	else
+		shard.head = slab;
+	shard.tail = slab;
+}
+
+void ChunksCache::LinkFront(Shard& shard, u32 slab) {
+	Entry& e = m_entries[slab];
+	e.prev = NONE;
+	e.next = shard.head;
+	if (shard.head != NONE)
+		m_entries[shard.head].prev = slab;
+	else
+		shard.tail = slab;
+	shard.head = slab;
+}
+
+void ChunksCache::Hash(Shard& shard, u32 bucket, u32 slab) {
+	m_entries[slab].hashNext = shard.buckets[bucket];
+	shard.buckets[bucket] = slab;
+}
+
+void ChunksCache::Unhash(Shard& shard, u32 slab) {
+	u32 bucket;
+	ShardOf(m_entries[slab].offset, bucket);
+	for (u32* link = &shard.buckets[bucket]; *link != NONE; link = &m_entries[*link].hashNext) {
+		if (*link == slab) {
+			*link = m_entries[slab].hashNext;
+			return;
 		}
 	}
-	return -1;
 }
 
+bool ChunksCache::CommitPages(Shard& shard) {
+	if (!shard.committed)
+		shard.committed = HostSys::MmapCommitPtr(Slab(shard.first), (size_t)shard.count * m_chunkSize, PageAccess_ReadWrite());
+	return shard.committed;
+}
+
+// A slab which isn't in the LRU list nor hashed, NONE if every slab is taken.
+u32 ChunksCache::Take(Shard& shard) {
+	if (shard.used < shard.count)
+		return shard.first + shard.used++;
+
+	// Recycle the least recently used chunk.
+	u32 slab = shard.tail;
+	if (slab != NONE) {
+		Unlink(shard, slab);
+		Unhash(shard, slab);
+	}
+	return slab;
+}
+
+void ChunksCache::Insert(PX_off_t offset, const void* pSrc, int length, int coverage) {
+	pxAssertDev(offset % m_chunkSize == 0 && length <= (int)m_chunkSize, "ChunksCache: chunk not aligned");
+	if (!m_slabs)
+		return;
+
+	u32 bucket;
+	Shard& shard = ShardOf(offset, bucket);
+	ScopedLock lock(shard.lock);
+
+	if (!CommitPages(shard))
+		return;
+
+	u32 slab = Find(shard, bucket, offset);
+	if (slab != NONE) {
+		// Someone else (a prefetcher or the reader) got here first, refresh it.
+		Unlink(shard, slab);
+	} else {
+		slab = Take(shard);
+		if (slab == NONE)
+			return;
+		m_entries[slab].offset = offset;
+		Hash(shard, bucket, slab);
+	}
+
+	Entry& e = m_entries[slab];
+	e.size = length;
+	e.coverage = coverage;
+	memcpy(Slab(slab), pSrc, length);
+	LinkFront(shard, slab);
+}
+
+u8* ChunksCache::Acquire(PX_off_t offset) {
+	pxAssertDev(offset % m_chunkSize == 0, "ChunksCache: chunk not aligned");
+	if (!m_slabs)
+		return NULL;
+
+	u32 bucket;
+	Shard& shard = ShardOf(offset, bucket);
+	ScopedLock lock(shard.lock);
+
+	if (!CommitPages(shard))
+		return NULL;
+
+	u32 slab = Take(shard);
+	if (slab == NONE)
+		return NULL;
+
+	// Not findable until it's committed, the offset only tells which shard it belongs to.
+	m_entries[slab].offset = offset;
+	return Slab(slab);
+}
+
+void ChunksCache::Commit(u8* ptr, int length, int coverage) {
+	pxAssertDev(length <= (int)m_chunkSize, "ChunksCache: chunk too large");
+	u32 slab = SlabOf(ptr);
+	Entry& e = m_entries[slab];
+
+	u32 bucket;
+	Shard& shard = ShardOf(e.offset, bucket);
+	ScopedLock lock(shard.lock);
+
+	// Someone else inserted it meanwhile, that copy is as good as this one.
+	u32 existing = Find(shard, bucket, e.offset);
+	if (existing != NONE) {
+		e.size = 0;
+		e.coverage = 0;
+		LinkBack(shard, slab);
+		return;
+	}
+
+	e.size = length;
+	e.coverage = coverage;
+	Hash(shard, bucket, slab);
+	LinkFront(shard, slab);
+}
+
+void ChunksCache::Release(u8* ptr) {
+	u32 slab = SlabOf(ptr);
+	Entry& e = m_entries[slab];
+
+	u32 bucket;
+	Shard& shard = ShardOf(e.offset, bucket);
+	ScopedLock lock(shard.lock);
+
+	// Unhashed at the LRU end, it's the next one to be recycled.
+	e.size = 0;
+	e.coverage = 0;
+	LinkBack(shard, slab);
+}
+
+int ChunksCache::Read(void* pDest, PX_off_t offset, int length) {
+	if (!m_slabs)
+		return -1;
+
+	PX_off_t chunk = offset - offset % m_chunkSize;
+	u32 bucket;
+	Shard& shard = ShardOf(chunk, bucket);
+	ScopedLock lock(shard.lock);
+
+	u32 slab = Find(shard, bucket, chunk);
+	if (slab == NONE || offset + length > chunk + m_entries[slab].coverage) {
+		shard.misses++;
+		return -1;
+	}
+
+	shard.hits++;
+	if (slab != shard.head) {
+		// Move to top (MRU)
+		Unlink(shard, slab);
+		LinkFront(shard, slab);
+	}
+	return CopyAvailable(Slab(slab), chunk, m_entries[slab].size, pDest, offset, length);
+}
@@ -16,48 +16,93 @@
 #pragma once
 
 #include "zlib_indexed.h"
+#include "Utilities/Threading.h"
 
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
+// LRU cache of decompressed chunks, all of the same size and aligned to it.
+//
+// Chunks are copied (or decompressed in place) into fixed size slabs of a single
+// arena (allocated on first use), found through a hash of their offset and evicted
+// in true LRU order, so both lookups and inserts are O(1).  The slabs are split into
+// shards with their own lock, so the prefetch threads can insert while the reader reads.
 class ChunksCache {
+	DeclareNoncopyableObject(ChunksCache);
 public:
-	ChunksCache(uint initialLimitMb) : m_entries(0), m_size(0), m_limit(initialLimitMb * 1024 * 1024) {};
-	~ChunksCache() { Clear(); };
-	void SetLimit(uint megabytes);
-	void Clear() { MatchLimit(true); };
+	ChunksCache(uint limitMb, uint chunkSize);
+	~ChunksCache();
+	void Clear();
 
-	void Take(void* pMallocedSrc, PX_off_t offset, int length, int coverage);
-	int  Read(void* pDest,        PX_off_t offset, int length);
+	// offset must be at a chunk boundary.  length is the amount of valid data (at most
+	// one chunk), coverage is how much of the file it represents (more than length at EOF).
+	void Insert(PX_off_t offset, const void* pSrc, int length, int coverage);
+	// Same, but the chunk is written in place: Acquire takes a slab out of the cache (NULL
+	// if there's none to spare), it's filled without holding any lock, then either Commit
+	// adds it as the chunk at offset or Release gives it back unused.  Clear() must not be
+	// called while a slab is acquired.
+	u8*  Acquire(PX_off_t offset);
+	void Commit(u8* slab, int length, int coverage);
+	void Release(u8* slab);
+	// By design, succeed only if the entire request is in a single cached chunk
+	int  Read(void* pDest, PX_off_t offset, int length);
+
+	uint GetChunkSize() const { return m_chunkSize; }
+	u64  GetHits() const;
+	u64  GetMisses() const;
 
 	static int CopyAvailable(void* pSrc, PX_off_t srcOffset, int srcSize,
 							 void* pDst, PX_off_t dstOffset, int maxCopySize) {
-		int available = CLAMP(maxCopySize, 0, (int)(srcOffset + srcSize - dstOffset));
+		// Past the end of the data (but within coverage) there's nothing to copy.
+		int available = std::max(0, CLAMP(maxCopySize, 0, (int)(srcOffset + srcSize - dstOffset)));
 		memcpy(pDst, (char*)pSrc + (dstOffset - srcOffset), available);
 		return available;
 	};
 
 private:
-	class CacheEntry {
-	public:
-		CacheEntry(void* pMallocedSrc, PX_off_t offset, int length, int coverage) :
-			data(pMallocedSrc),
-			offset(offset),
-			coverage(coverage),
-			size(length)
-		{};
-
-		~CacheEntry() { if (data) free(data); };
-
-		void* data;
+	static const u32 NONE = 0xffffffff;
+
+	// One per slab, linked by slab number.
+	struct Entry {
 		PX_off_t offset;
-		int coverage;
 		int size;
+		int coverage;
+		u32 prev;		// LRU order, head is the most recently used
+		u32 next;
+		u32 hashNext;	// bucket chain
 	};
 
-	std::list<CacheEntry*> m_entries;
-	void MatchLimit(bool removeAll = false);
-	PX_off_t m_size;
-	PX_off_t m_limit;
+	struct Shard {
+		Threading::Mutex lock;
+		u32 first;		// slabs [first, first + count) belong to this shard
+		u32 count;
+		u32 used;
+		u32 head;
+		u32 tail;
+		u32* buckets;
+		u32 bucketMask;
+		bool committed;
+		u64 hits;
+		u64 misses;
+	};
+
+	Shard& ShardOf(PX_off_t offset, u32& bucket) const;
+	bool CommitPages(Shard& shard);
+	u32  Find(Shard& shard, u32 bucket, PX_off_t offset) const;
+	u32  Take(Shard& shard);
+	void Unlink(Shard& shard, u32 slab);
+	void LinkFront(Shard& shard, u32 slab);
+	void LinkBack(Shard& shard, u32 slab);
+	void Hash(Shard& shard, u32 bucket, u32 slab);
+	void Unhash(Shard& shard, u32 slab);
+	u8*  Slab(u32 slab) const { return m_arena + (size_t)slab * m_chunkSize; }
+	u32  SlabOf(const u8* ptr) const { return (u32)((ptr - m_arena) / m_chunkSize); }
+
+	uint m_chunkSize;
+	u32 m_slabs;
+	u8* m_arena;
+	Entry* m_entries;
+	Shard* m_shards;
+	u32 m_shardCount;
 };
 
 #undef CLAMP
@@ -0,0 +1,244 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2014  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PrecompiledHeader.h"
+#include "ChunksCache.h"
+#include "ChunksPrefetcher.h"
+
+ChunksPrefetcher::Worker::Worker(ChunksPrefetcher& owner, uint context) :
+	m_owner(owner),
+	m_context(context) {
+	m_name = L"CDVD Prefetch";
+}
+
+ChunksPrefetcher::Worker::~Worker() {
+	try {
+		_parent::Cancel();
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+void ChunksPrefetcher::Worker::ExecuteTaskInThread() {
+	// Every queued chunk posts once, so a wakeup may find nothing to do when the
+	// reader already took (or cancelled) the chunk it was posted for.
+	while (true) {
+		m_owner.m_sem_work.WaitWithoutYield();
+		if (m_owner.m_exit)
+			return;
+		m_owner.ProcessQueued(m_context);
+	}
+}
+
+ChunksPrefetcher::ChunksPrefetcher(Source& source, ChunksCache* cache, uint chunkSize, uint depth, uint workers) :
+	m_source(source),
+	m_cache(cache),
+	m_chunkSize(chunkSize),
+	m_depth(depth),
+	m_slots(depth + 2),
+	m_exit(false),
+	m_lastIndex((u32)-1),
+	m_queuedUpTo(0),
+	m_hits(0),
+	m_misses(0) {
+	// Two extra slots: one for the chunk being read, and one which may still be
+	// decompressing a chunk which fell out of the window.
+	for (Slot& slot : m_slots) {
+		slot.state = Free;
+		slot.index = 0;
+		slot.bytes = 0;
+		slot.data = (u8*)malloc(chunkSize);
+	}
+
+	for (uint i = 0; i < workers; i++) {
+		Worker* worker = new Worker(*this, i + 1);
+		m_workers.push_back(worker);
+		worker->Start();
+	}
+}
+
+ChunksPrefetcher::~ChunksPrefetcher() {
+	// Let the workers finish their current chunk and leave on their own rather
+	// than cancelling them in the middle of a file read.
+	m_exit = true;
+	for (uint i = 0; i < m_workers.size(); i++)
+		m_sem_work.Post();
+
+	for (Worker* worker : m_workers) {
+		worker->Block();
+		delete worker;
+	}
+	m_workers.clear();
+
+	for (Slot& slot : m_slots)
+		free(slot.data);
+}
+
+ChunksPrefetcher::Slot* ChunksPrefetcher::Find(u32 index) {
+	for (Slot& slot : m_slots) {
+		if (slot.state.load(std::memory_order_acquire) != Free && slot.index.load(std::memory_order_relaxed) == index)
+			return &slot;
+	}
+	return NULL;
+}
+
+// Reader thread only.  Returns a slot which the caller owns and may overwrite.
+ChunksPrefetcher::Slot* ChunksPrefetcher::Allocate(bool wait) {
+	for (Slot& slot : m_slots) {
+		if (slot.state.load(std::memory_order_acquire) == Free)
+			return &slot;
+	}
+
+	// Recycle a chunk outside of the read-ahead window.
+	for (Slot& slot : m_slots) {
+		if (IsWanted(slot.index.load(std::memory_order_relaxed)))
+			continue;
+
+		int state = slot.state.load(std::memory_order_acquire);
+		if (state == Ready || state == Failed)
+			return &slot;
+
+		// A worker may grab it at the same time, in which case it's Busy now.
+		if (state == Queued && slot.state.compare_exchange_strong(state, Free))
+			return &slot;
+	}
+
+	if (!wait)
+		return NULL;
+
+	// Everything left over is being decompressed by a worker.
+	for (Slot& slot : m_slots) {
+		if (!IsWanted(slot.index.load(std::memory_order_relaxed))) {
+			WaitFor(slot);
+			return &slot;
+		}
+	}
+
+	pxFailDev("ChunksPrefetcher: no slot available");
+	return NULL;
+}
+
+void ChunksPrefetcher::Queue(u32 index) {
+	if (Find(index))
+		return;
+
+	Slot* slot = Allocate(false);
+	if (!slot)
+		return;
+
+	slot->index.store(index, std::memory_order_relaxed);
+	slot->bytes = 0;
+	slot->state.store(Queued, std::memory_order_release);
+	m_sem_work.Post();
+}
+
+// The slot must be Busy and owned by the calling thread.
+void ChunksPrefetcher::Process(Slot& slot, uint context) {
+	const u32 index = slot.index.load(std::memory_order_relaxed);
+	slot.bytes = m_source.DecompressChunk(context, index, slot.data);
+	if (m_cache && slot.bytes >= 0)
+		m_cache->Insert((PX_off_t)index * m_chunkSize, slot.data, slot.bytes, m_chunkSize);
+	slot.state.store(slot.bytes < 0 ? Failed : Ready, std::memory_order_release);
+	m_sem_done.Post();
+}
+
+// Decompresses the lowest queued chunk, since that's what the reader needs next.
+bool ChunksPrefetcher::ProcessQueued(uint context) {
+	while (true) {
+		Slot* best = NULL;
+		u32 bestIndex = 0;
+		for (Slot& slot : m_slots) {
+			if (slot.state.load(std::memory_order_acquire) != Queued)
+				continue;
+			u32 index = slot.index.load(std::memory_order_relaxed);
+			if (!best || index < bestIndex) {
+				best = &slot;
+				bestIndex = index;
+			}
+		}
+
+		if (!best)
+			return false;
+
+		int expected = Queued;
+		if (best->state.compare_exchange_strong(expected, Busy)) {
+			Process(*best, context);
+			return true;
+		}
+	}
+}
+
+// Waits until a worker is done with the slot.  Queued slots are never cancelled
+// while the reader waits on them, so they always end up Ready or Failed.
+void ChunksPrefetcher::WaitFor(Slot& slot) {
+	while (true) {
+		int state = slot.state.load(std::memory_order_acquire);
+		if (state != Queued && state != Busy)
+			break;
+		m_sem_done.WaitWithoutYield();
+	}
+}
+
+int ChunksPrefetcher::Read(u32 index, uint offset, void* pDest, uint length, bool decodeOnMiss) {
+	// Two consecutive chunks mean the game is streaming, keep the window full.
+	bool streaming = index == m_lastIndex + 1 || (index == m_lastIndex && m_queuedUpTo > index);
+	m_lastIndex = index;
+	if (!streaming) {
+		m_queuedUpTo = index;
+	} else if (!m_workers.empty()) {
+		for (u32 i = std::max(m_queuedUpTo, index) + 1; i <= index + m_depth; i++)
+			Queue(i);
+		m_queuedUpTo = index + m_depth;
+	}
+
+	if (m_cache) {
+		int res = m_cache->Read(pDest, (PX_off_t)index * m_chunkSize + offset, std::min(length, m_chunkSize - offset));
+		if (res >= 0)
+			return res;
+	}
+
+	Slot* slot = Find(index);
+	if (slot) {
+		m_hits++;
+		// Don't wait for a worker to get to it.  Only done for sources which asked
+		// for inline decoding, the others may depend on the workers' sequential state.
+		int expected = Queued;
+		if (decodeOnMiss && slot->state.compare_exchange_strong(expected, Busy))
+			Process(*slot, 0);
+		else
+			WaitFor(*slot);
+	} else {
+		m_misses++;
+		if (!decodeOnMiss)
+			return -1;
+
+		slot = Allocate(true);
+		slot->index.store(index, std::memory_order_relaxed);
+		slot->state.store(Busy, std::memory_order_relaxed);
+		Process(*slot, 0);
+	}
+
+	if (slot->state.load(std::memory_order_acquire) == Failed) {
+		// Don't keep the failure around, a later read (or the caller's own path) will retry.
+		slot->state.store(Free, std::memory_order_release);
+		return -1;
+	}
+
+	if ((int)offset >= slot->bytes)
+		return 0;
+
+	uint bytes = std::min(length, (uint)slot->bytes - offset);
+	memcpy(pDest, slot->data + offset, bytes);
+	return bytes;
+}
@@ -0,0 +1,116 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2014  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Utilities/PersistentThread.h"
+#include <atomic>
+
+class ChunksCache;
+
+// Decompresses fixed size chunks of a compressed image ahead of the reader.
+//
+// Once the reader is detected to be streaming (two consecutive chunks), the next
+// 'depth' chunks are queued and decompressed by a small pool of worker threads,
+// so FMV and level streaming no longer pay the full inflate cost on the emulator
+// thread.  Random access degrades to decompressing inline on the calling thread.
+//
+// Decompressed chunks are also inserted into the (optional) cache by whichever
+// thread decoded them, and the cache is checked before anything else.
+//
+// Only the reader thread (the one calling Read) allocates and recycles slots.
+// Workers only move a slot from Queued to Busy to Ready, so the slot state is
+// the only thing which needs to be shared.
+class ChunksPrefetcher {
+	DeclareNoncopyableObject(ChunksPrefetcher);
+public:
+	class Source {
+	public:
+		virtual ~Source() {}
+		// Decompresses chunk 'index' into dest (chunkSize bytes).  Returns the number of
+		// bytes produced (less than chunkSize at the end of the image) or negative on error.
+		// context 0 is used by the reader thread, 1..workers by the prefetch threads, so
+		// each context may own its own file handle and decompressor state.
+		virtual int DecompressChunk(uint context, u32 index, u8* dest) = 0;
+	};
+
+	ChunksPrefetcher(Source& source, ChunksCache* cache, uint chunkSize, uint depth, uint workers);
+	~ChunksPrefetcher();
+
+	// Copies up to length bytes from offset within chunk 'index'.  If the chunk isn't
+	// ready or in flight, it's decompressed inline when decodeOnMiss is set, otherwise
+	// -1 is returned so the caller can use its own path.  Also returns -1 if the chunk
+	// couldn't be decompressed, and 0 at end of image.
+	int Read(u32 index, uint offset, void* pDest, uint length, bool decodeOnMiss);
+
+	uint GetChunkSize() const { return m_chunkSize; }
+	uint GetWorkers() const { return m_workers.size(); }
+	u64 GetHits() const { return m_hits; }
+	u64 GetMisses() const { return m_misses; }
+
+private:
+	enum SlotState {
+		Free,
+		Queued,
+		Busy,
+		Ready,
+		Failed,
+	};
+
+	struct Slot {
+		std::atomic<int> state;
+		std::atomic<u32> index;	// written by the reader while the slot is not Queued/Busy
+		int bytes;
+		u8* data;
+	};
+
+	class Worker : public Threading::pxThread {
+		typedef Threading::pxThread _parent;
+	public:
+		Worker(ChunksPrefetcher& owner, uint context);
+		virtual ~Worker();
+	protected:
+		void ExecuteTaskInThread();
+	private:
+		ChunksPrefetcher& m_owner;
+		uint m_context;
+	};
+
+	bool IsWanted(u32 index) const { return index - m_lastIndex <= m_depth; }
+	Slot* Find(u32 index);
+	Slot* Allocate(bool wait);
+	void Queue(u32 index);
+	void Process(Slot& slot, uint context);
+	bool ProcessQueued(uint context);
+	void WaitFor(Slot& slot);
+
+	Source& m_source;
+	ChunksCache* m_cache;
+	uint m_chunkSize;
+	uint m_depth;
+
+	std::vector<Slot> m_slots;
+	std::vector<Worker*> m_workers;
+
+	Threading::Semaphore m_sem_work;	// one post per queued chunk (and per worker on exit)
+	Threading::Semaphore m_sem_done;	// posted whenever a chunk finishes
+	std::atomic<bool> m_exit;
+
+	u32 m_lastIndex;
+	u32 m_queuedUpTo;	// highest chunk already queued by the current streak
+
+	u64 m_hits;
+	u64 m_misses;
+};
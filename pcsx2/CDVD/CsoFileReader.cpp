@@ -124,17 +124,6 @@ bool CsoFileReader::InitializeBuffers() {
 	// Round up, since part of a frame requires a full frame.
 	u32 numFrames = (u32)((m_totalSize + m_frameSize - 1) / m_frameSize);
 
-	// We might read a bit of alignment too, so be prepared.
-	if (m_frameSize + (1 << m_indexShift) < CSO_READ_BUFFER_SIZE) {
-		m_readBuffer = new u8[CSO_READ_BUFFER_SIZE];
-	} else {
-		m_readBuffer = new u8[m_frameSize + (1 << m_indexShift)];
-	}
-
-	// This is a buffer for the most recently decompressed frame.
-	m_zlibBuffer = new u8[m_frameSize + (1 << m_indexShift)];
-	m_zlibBufferFrame = numFrames;
-
 	const u32 indexSize = numFrames + 1;
 	m_index = new u32[indexSize];
 	if (fread(m_index, sizeof(u32), indexSize, m_src) != indexSize) {
@@ -142,41 +131,75 @@ bool CsoFileReader::InitializeBuffers() {
 		return false;
 	}
 
-	m_z_stream = new z_stream;
-	m_z_stream->zalloc = Z_NULL;
-	m_z_stream->zfree = Z_NULL;
-	m_z_stream->opaque = Z_NULL;
-	if (inflateInit2(m_z_stream, -15) != Z_OK) {
-		Console.Error("Unable to initialize zlib for CSO decompression.");
-		return false;
+	m_framesPerChunk = std::max<u32>(1, CSO_PREFETCH_CHUNK_SIZE >> m_frameShift);
+
+	// Leave a core for the EE, the reader decompresses inline when there's none to spare.
+	const uint workers = std::min<uint>(CSO_PREFETCH_MAX_WORKERS, x86caps.LogicalCores > 1 ? x86caps.LogicalCores - 1 : 0);
+
+	m_contexts.resize(1 + workers);
+	for (uint i = 0; i < m_contexts.size(); i++) {
+		Context& ctx = m_contexts[i];
+		// We might read a bit of alignment too, so be prepared.
+		ctx.readBuffer = new u8[std::max<u32>(CSO_READ_BUFFER_SIZE, m_frameSize + (1 << m_indexShift))];
+		ctx.src = i == 0 ? m_src : PX_fopen_rb(m_filename);
+		ctx.strm = new z_stream;
+		ctx.strm->zalloc = Z_NULL;
+		ctx.strm->zfree = Z_NULL;
+		ctx.strm->opaque = Z_NULL;
+		if (inflateInit2(ctx.strm, -15) != Z_OK) {
+			Console.Error("Unable to initialize zlib for CSO decompression.");
+			delete ctx.strm;
+			ctx.strm = NULL;
+			return false;
+		}
+		if (!ctx.src) {
+			Console.Error("Unable to open CSO file for prefetching.");
+			return false;
+		}
 	}
 
+	const uint chunkSize = m_framesPerChunk << m_frameShift;
+	m_cache = new ChunksCache(CSO_CHUNKCACHE_SIZE_MB, chunkSize);
+	m_prefetcher = new ChunksPrefetcher(*this, m_cache, chunkSize, CSO_PREFETCH_DEPTH, workers);
+
 	return true;
 }
 
+void CsoFileReader::CloseContexts() {
+	// The workers must be gone before their contexts are.
+	if (m_prefetcher) {
+		delete m_prefetcher;
+		m_prefetcher = NULL;
+	}
+	if (m_cache) {
+		if (m_cache->GetHits() || m_cache->GetMisses())
+			Console.WriteLn(Color_Gray, L"CSO: chunks cache hits: %llu, misses: %llu",
+			                (unsigned long long)m_cache->GetHits(), (unsigned long long)m_cache->GetMisses());
+		delete m_cache;
+		m_cache = NULL;
+	}
+
+	for (Context& ctx : m_contexts) {
+		if (ctx.src && ctx.src != m_src)
+			fclose(ctx.src);
+		if (ctx.strm) {
+			inflateEnd(ctx.strm);
+			delete ctx.strm;
+		}
+		delete[] ctx.readBuffer;
+	}
+	m_contexts.clear();
+}
+
 void CsoFileReader::Close() {
+	CloseContexts();
 	m_filename.Empty();
-#if CSO_USE_CHUNKSCACHE
-	m_cache.Clear();
-#endif
 
 	if (m_src) {
 		fclose(m_src);
 		m_src = NULL;
 	}
-	if (m_z_stream) {
-		inflateEnd(m_z_stream);
-		m_z_stream = NULL;
-	}
 
-	if (m_readBuffer) {
-		delete[] m_readBuffer;
-		m_readBuffer = NULL;
-	}
-	if (m_zlibBuffer) {
-		delete[] m_zlibBuffer;
-		m_zlibBuffer = NULL;
-	}
 	if (m_index) {
 		delete[] m_index;
 		m_index = NULL;
@@ -184,7 +207,7 @@ void CsoFileReader::Close() {
 }
 
 int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count) {
-	if (!m_src) {
+	if (!m_src || !m_prefetcher) {
 		return 0;
 	}
 
@@ -197,28 +220,20 @@ int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count) {
 	int remaining = count * m_blocksize;
 	int bytes = 0;
 
+	const uint chunkSize = m_prefetcher->GetChunkSize();
 	while (remaining > 0) {
-		int readBytes;
-
-#if CSO_USE_CHUNKSCACHE
-		// Try first to read from the cache.
-		readBytes = m_cache.Read(dest + bytes, pos + bytes, remaining);
-#else
-		readBytes = -1;
-#endif
-		if (readBytes < 0) {
-			readBytes = ReadFromFrame(dest + bytes, pos + bytes, remaining);
-			if (readBytes == 0) {
-				// We hit EOF.
-				break;
-			}
+		const u64 at = pos + bytes;
+		if (at >= m_totalSize) {
+			// Can't read anything passed the end.
+			break;
+		}
 
-#if CSO_USE_CHUNKSCACHE
-			// Add the bytes into the cache.  We need to allocate a buffer for it.
-			void *cached = malloc(readBytes);
-			memcpy(cached, dest + bytes, readBytes);
-			m_cache.Take(cached, pos + bytes, readBytes, readBytes);
-#endif
+		const u32 chunk = (u32)(at / chunkSize);
+		const uint offset = (uint)(at % chunkSize);
+		int readBytes = m_prefetcher->Read(chunk, offset, dest + bytes, remaining, true);
+		if (readBytes <= 0) {
+			// We hit EOF or the frame couldn't be decompressed.
+			break;
 		}
 
 		bytes += readBytes;
@@ -228,17 +243,28 @@ int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count) {
 	return bytes;
 }
 
-int CsoFileReader::ReadFromFrame(u8 *dest, u64 pos, int maxBytes) {
-	if (pos >= m_totalSize) {
-		// Can't read anything passed the end.
-		return 0;
+// Called from the reader thread (context 0) and from the prefetch workers.
+int CsoFileReader::DecompressChunk(uint context, u32 index, u8* dest) {
+	const u32 numFrames = (u32)((m_totalSize + m_frameSize - 1) >> m_frameShift);
+	u32 frame = index * m_framesPerChunk;
+	u64 bytes = 0;
+
+	for (u32 i = 0; i < m_framesPerChunk && frame < numFrames; ++i, ++frame) {
+		if (!ReadFrame(m_contexts[context], frame, dest + bytes)) {
+			return -1;
+		}
+		bytes += m_frameSize;
 	}
 
-	const u32 frame = (u32)(pos >> m_frameShift);
-	const u32 offset = (u32)(pos - (frame << m_frameShift));
-	// This is how many bytes we will actually be reading from this frame.
-	const u32 bytes = (u32)(std::min(m_blocksize, static_cast<uint>(m_frameSize - offset)));
+	// The last frame may be partial.
+	const u64 end = ((u64)index * m_framesPerChunk << m_frameShift) + bytes;
+	if (end > m_totalSize) {
+		bytes -= end - m_totalSize;
+	}
+	return (int)bytes;
+}
 
+bool CsoFileReader::ReadFrame(Context& ctx, u32 frame, u8* dest) {
 	// Grab the index data for the frame we're about to read.
 	const bool compressed = (m_index[frame + 0] & 0x80000000) == 0;
 	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
@@ -248,52 +274,34 @@ int CsoFileReader::ReadFromFrame(u8 *dest, u64 pos, int maxBytes) {
 	const u64 frameRawPos = (u64)index0 << m_indexShift;
 	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
 
-	if (!compressed) {
-		// Just read directly, easy.
-		if (PX_fseeko(m_src, m_dataoffset + frameRawPos + offset, SEEK_SET) != 0) {
-			Console.Error("Unable to seek to uncompressed CSO data.");
-			return 0;
-		}
-		return fread(dest, 1, bytes, m_src);
-	} else {
-		// We don't need to decompress if we already did this same frame last time.
-		if (m_zlibBufferFrame != frame) {
-			if (PX_fseeko(m_src, m_dataoffset + frameRawPos, SEEK_SET) != 0) {
-				Console.Error("Unable to seek to compressed CSO data.");
-				return 0;
-			}
-			// This might be less bytes than frameRawSize in case of padding on the last frame.
-			// This is because the index positions must be aligned.
-			const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
-			if (!DecompressFrame(frame, readRawBytes)) {
-				return 0;
-			}
-		}
+	if (PX_fseeko(ctx.src, m_dataoffset + frameRawPos, SEEK_SET) != 0) {
+		Console.Error("Unable to seek to CSO data.");
+		return false;
+	}
 
-		// Now we just copy the offset data from the cache.
-		memcpy(dest, m_zlibBuffer + offset, bytes);
+	if (!compressed) {
+		// Just read directly, easy.  The last frame may be short.
+		fread(dest, 1, m_frameSize, ctx.src);
+		return true;
 	}
 
-	return bytes;
-}
+	// This might be less bytes than frameRawSize in case of padding on the last frame.
+	// This is because the index positions must be aligned.
+	const u32 readRawBytes = fread(ctx.readBuffer, 1, frameRawSize, ctx.src);
 
-bool CsoFileReader::DecompressFrame(u32 frame, u32 readBufferSize) {
-	m_z_stream->next_in = m_readBuffer;
-	m_z_stream->avail_in = readBufferSize;
-	m_z_stream->next_out = m_zlibBuffer;
-	m_z_stream->avail_out = m_frameSize;
-
-	int status = inflate(m_z_stream, Z_FINISH);
-	bool success = status == Z_STREAM_END && m_z_stream->total_out == m_frameSize;
-	if (success) {
-		// Our buffer now contains this frame.
-		m_zlibBufferFrame = frame;
-	} else {
+	z_stream* strm = ctx.strm;
+	strm->next_in = ctx.readBuffer;
+	strm->avail_in = readRawBytes;
+	strm->next_out = dest;
+	strm->avail_out = m_frameSize;
+
+	int status = inflate(strm, Z_FINISH);
+	bool success = status == Z_STREAM_END && strm->total_out == m_frameSize;
+	if (!success) {
 		Console.Error("Unable to decompress CSO frame using zlib.");
-		m_zlibBufferFrame = (u32)-1;
 	}
 
-	inflateReset(m_z_stream);
+	inflateReset(strm);
 	return success;
 }
 
@@ -15,24 +15,21 @@
 
 #pragma once
 
-// Based on testing, the overhead of using this cache is high.
-//
-// The test was done with CSO files using a block size of 16KB.
-// Cache hit rates were observed in the range of 25%.
-// Cache overhead added 35% to the overall read time.
-//
-// For this reason, it's currently disabled.
-#define CSO_USE_CHUNKSCACHE 0
-
 #include "AsyncFileReader.h"
 #include "ChunksCache.h"
+#include "ChunksPrefetcher.h"
 
 struct CsoHeader;
 typedef struct z_stream_s z_stream;
 
-static const uint CSO_CHUNKCACHE_SIZE_MB = 200;
+// Frames are decompressed in batches of at least this size, so the prefetch
+// overhead is amortized for images using small (2KB) frames.
+static const uint CSO_PREFETCH_CHUNK_SIZE = 64 * 1024;
+static const uint CSO_PREFETCH_DEPTH = 8;
+static const uint CSO_PREFETCH_MAX_WORKERS = 4;
+static const uint CSO_CHUNKCACHE_SIZE_MB = 64;
 
-class CsoFileReader : public AsyncFileReader
+class CsoFileReader : public AsyncFileReader, protected ChunksPrefetcher::Source
 {
 	DeclareNoncopyableObject(CsoFileReader);
 public:
@@ -40,16 +37,12 @@ public:
 		m_frameSize(0),
 		m_frameShift(0),
 		m_indexShift(0),
-		m_readBuffer(0),
-		m_zlibBuffer(0),
-		m_zlibBufferFrame(0),
+		m_framesPerChunk(0),
 		m_index(0),
 		m_totalSize(0),
 		m_src(0),
-		m_z_stream(0),
-#if CSO_USE_CHUNKSCACHE
-		m_cache(CSO_CHUNKCACHE_SIZE_MB),
-#endif
+		m_cache(0),
+		m_prefetcher(0),
 		m_bytesRead(0) {
 		m_blocksize = 2048;
 	};
@@ -78,24 +71,31 @@ private:
 	static bool ValidateHeader(const CsoHeader& hdr);
 	bool ReadFileHeader();
 	bool InitializeBuffers();
-	int ReadFromFrame(u8 *dest, u64 pos, int maxBytes);
-	bool DecompressFrame(u32 frame, u32 readBufferSize);
+	void CloseContexts();
+
+	// Each decompressing thread needs its own file position and zlib state.
+	struct Context {
+		FILE* src;
+		z_stream* strm;
+		u8* readBuffer;
+	};
+
+	bool ReadFrame(Context& ctx, u32 frame, u8* dest);
+	virtual int DecompressChunk(uint context, u32 index, u8* dest);
 
 	u32 m_frameSize;
 	u8 m_frameShift;
 	u8 m_indexShift;
-	u8* m_readBuffer;
-	u8 *m_zlibBuffer;
-	u32 m_zlibBufferFrame;
+	u32 m_framesPerChunk;
 	u32 *m_index;
 	u64 m_totalSize;
 	// The actual source cso file handle.
 	FILE* m_src;
-	z_stream* m_z_stream;
 
-#if CSO_USE_CHUNKSCACHE
-	ChunksCache m_cache;
-#endif
+	// Context 0 is the reader thread (and shares m_src), the others belong to the prefetch workers.
+	std::vector<Context> m_contexts;
+	ChunksCache* m_cache;
+	ChunksPrefetcher* m_prefetcher;
 
 	// The result of a read is stored here between BeginRead() and FinishRead().
 	int m_bytesRead;
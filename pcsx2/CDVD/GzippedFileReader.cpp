@@ -22,6 +22,12 @@
 #include "GzippedFileReader.h"
 #include "zlib_indexed.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
 static s64 fsize(const wxString& filename) {
@@ -37,13 +43,138 @@ static s64 fsize(const wxString& filename) {
 }
 
 #define GZIP_ID "PCSX2.index.gzip.v1|"
+#define GZIP_ID_V2 "PCSX2.index.gzip.v2|"
 #define GZIP_ID_LEN (sizeof(GZIP_ID) - 1)	/* sizeof includes the \0 terminator */
 
-// File format is:
+// v2 index header, follows GZIP_ID_V2
+struct GzipIndexHeader {
+	u32 pointSize;          // sizeof(Point), catches layout changes
+	s32 span;
+	s32 have;
+	u32 pointsCrc;          // crc32 of the access points
+	s64 uncompressedSize;
+	s64 compressedSize;     // size of the gzip file the index was built from
+	u32 reserved;
+	u32 headerCrc;          // crc32 of all the above
+};
+
+// The header is zero padded so the points of the mapped file start 64 bytes in, aligned
+#define GZIP_V2_POINTS_OFFSET 64
+static_assert(GZIP_ID_LEN + sizeof(GzipIndexHeader) <= GZIP_V2_POINTS_OFFSET, "gzip v2 index header too large");
+
+static u32 IndexCrc(const void* data, size_t size) {
+	uLong crc = crc32(0L, Z_NULL, 0);
+	for (const Bytef* p = (const Bytef*)data; size > 0; ) {
+		uInt len = (uInt)std::min<size_t>(size, 1 << 30);
+		crc = crc32(crc, p, len);
+		p += len;
+		size -= len;
+	}
+	return (u32)crc;
+}
+
+#ifdef _WIN32
+static void* MapIndexFile(const wxString& filename, size_t& size) {
+	HANDLE file = CreateFileW(PX_wfilename(filename), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = GetFileSizeEx(file, &fileSize) ? CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+
+	// The view keeps the mapping alive
+	void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	size = (size_t)fileSize.QuadPart;
+	return base;
+}
+
+static void UnmapIndexFile(void* base, size_t size) {
+	UnmapViewOfFile(base);
+}
+#else
+static void* MapIndexFile(const wxString& filename, size_t& size) {
+	int fd = open(PX_wfilename(filename), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	void* base = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	size = (size_t)st.st_size;
+	return base;
+}
+
+static void UnmapIndexFile(void* base, size_t size) {
+	munmap(base, size);
+}
+#endif
+
+// v2 file format is:
+// - [GZIP_ID_LEN] GZIP_ID_V2 (no \0)
+// - [sizeof(GzipIndexHeader)] sizes, span and checksums
+// - zeros up to GZIP_V2_POINTS_OFFSET
+// - [rest] the indexed data points, used in place through a read only mapping of the file
+// Returns NULL if the file isn't a valid index of a file of compressedSize bytes,
+// in which case it's deleted so a new one can be written.
+static Access* MapIndexFromFile(const wxString& filename, s64 compressedSize, void*& mapping, size_t& mappingSize) {
+	size_t size = 0;
+	u8* base = (u8*)MapIndexFile(filename, size);
+	if (!base) {
+		Console.Error(L"Error: Can't map index file: '%s'", WX_STR(filename));
+		return 0;
+	}
+
+	GzipIndexHeader hdr;
+	const char* problem = NULL;
+	if (size < GZIP_V2_POINTS_OFFSET) {
+		problem = "truncated";
+	} else {
+		memcpy(&hdr, base + GZIP_ID_LEN, sizeof(hdr));
+		if (IndexCrc(&hdr, offsetof(GzipIndexHeader, headerCrc)) != hdr.headerCrc)
+			problem = "corrupted header";
+		else if (hdr.pointSize != sizeof(Point) || hdr.have <= 0)
+			problem = "incompatible";
+		else if (hdr.compressedSize != compressedSize)
+			problem = "built for a different file";
+		else if (size != GZIP_V2_POINTS_OFFSET + (size_t)hdr.have * sizeof(Point))
+			problem = "unexpected size";
+		else if (IndexCrc(base + GZIP_V2_POINTS_OFFSET, (size_t)hdr.have * sizeof(Point)) != hdr.pointsCrc)
+			problem = "corrupted";
+	}
+
+	if (problem) {
+		UnmapIndexFile(base, size);
+		Console.Warning(L"Warning: gzip index is %s, it will be rebuilt: '%s'", WX_STR(fromUTF8(problem)), WX_STR(filename));
+		wxRemoveFile(filename);
+		return 0;
+	}
+
+	Access* index = (Access*)malloc(sizeof(Access));
+	index->have = index->size = hdr.have;
+	index->span = hdr.span;
+	index->uncompressed_size = hdr.uncompressedSize;
+	index->list = (Point*)(base + GZIP_V2_POINTS_OFFSET);
+
+	mapping = base;
+	mappingSize = size;
+	return index;
+}
+
+// v1 file format is:
 // - [GZIP_ID_LEN] GZIP_ID (no \0)
 // - [sizeof(Access)] index (should be allocated, contains various sizes)
 // - [rest] the indexed data points (should be allocated, index->list should then point to it)
-static Access* ReadIndexFromFile(const wxString& filename) {
+// v2 files are mapped instead, mapping is set to the base of the mapping in that case.
+static Access* ReadIndexFromFile(const wxString& filename, s64 compressedSize, void*& mapping, size_t& mappingSize) {
 	s64 size = fsize(filename);
 	if (size <= 0) {
 		Console.Error(L"Error: Can't open index file: '%s'", WX_STR(filename));
@@ -53,6 +184,10 @@ static Access* ReadIndexFromFile(const wxString& filename) {
 
 	char fileId[GZIP_ID_LEN + 1] = { 0 };
 	infile.read(fileId, GZIP_ID_LEN);
+	if (wxString::From8BitData(GZIP_ID_V2) == wxString::From8BitData(fileId)) {
+		infile.close();
+		return MapIndexFromFile(filename, compressedSize, mapping, mappingSize);
+	}
 	if (wxString::From8BitData(GZIP_ID) != wxString::From8BitData(fileId)) {
 		Console.Error(L"Error: Incompatible gzip index, please delete it manually: '%s'", WX_STR(filename));
 		infile.close();
@@ -77,31 +212,123 @@ static Access* ReadIndexFromFile(const wxString& filename) {
 	return index;
 }
 
-static void WriteIndexToFile(Access* index, const wxString filename) {
+static void WriteIndexToFile(Access* index, const wxString filename, s64 compressedSize) {
 	if (wxFileName::FileExists(filename)) {
 		Console.Warning(L"WARNING: Won't write index - file name exists (please delete it manually): '%s'", WX_STR(filename));
 		return;
 	}
 
-	std::ofstream outfile(PX_wfilename(filename), std::ofstream::binary);
-	outfile.write(GZIP_ID, GZIP_ID_LEN);
-
-	Point* tmp = index->list;
-	index->list = 0; // current pointer is useless on disk, normalize it as 0.
-	outfile.write((char*)index, sizeof(Access));
-	index->list = tmp;
+	GzipIndexHeader hdr = {};
+	hdr.pointSize = sizeof(Point);
+	hdr.span = index->span;
+	hdr.have = index->have;
+	hdr.pointsCrc = IndexCrc(index->list, (size_t)index->have * sizeof(Point));
+	hdr.uncompressedSize = index->uncompressed_size;
+	hdr.compressedSize = compressedSize;
+	hdr.headerCrc = IndexCrc(&hdr, offsetof(GzipIndexHeader, headerCrc));
 
+	std::ofstream outfile(PX_wfilename(filename), std::ofstream::binary);
+	outfile.write(GZIP_ID_V2, GZIP_ID_LEN);
+	outfile.write((char*)&hdr, sizeof(hdr));
+	static const char padding[GZIP_V2_POINTS_OFFSET] = {};
+	outfile.write(padding, GZIP_V2_POINTS_OFFSET - GZIP_ID_LEN - sizeof(hdr));
 	outfile.write((char*)index->list, sizeof(Point) * index->have);
 	outfile.close();
 
 	// Verify
-	if (fsize(filename) != (s64)GZIP_ID_LEN + sizeof(Access) + sizeof(Point) * index->have) {
+	if (fsize(filename) != (s64)GZIP_V2_POINTS_OFFSET + sizeof(Point) * index->have) {
 		Console.Warning(L"Warning: Can't write index file to disk: '%s'", WX_STR(filename));
 	} else {
 		Console.WriteLn(Color_Green, L"OK: Gzip quick access index file saved to disk: '%s'", WX_STR(filename));
 	}
 }
 
+// Reads the compressed file ahead of build_index on its own thread, so inflating
+// the stream never waits for the disk.  Also reports the progress.
+class GzipIndexReadAhead : public Threading::pxThread {
+	typedef Threading::pxThread _parent;
+public:
+	GzipIndexReadAhead(FILE* in, s64 size) :
+		m_in(in),
+		m_size(size),
+		m_consumed(0),
+		m_lastPercent(0),
+		m_current(-1),
+		m_exit(false) {
+		m_name = L"Gzip Index Reader";
+		for (int i = 0; i < Buffers; i++) {
+			m_buffers[i] = (u8*)malloc(BufferSize);
+			m_lengths[i] = 0;
+			m_free.Post();
+		}
+	}
+
+	virtual ~GzipIndexReadAhead() {
+		try {
+			// build_index may stop before the end of the file
+			m_exit = true;
+			m_free.Post();
+			Block();
+		}
+		DESTRUCTOR_CATCHALL
+
+		for (int i = 0; i < Buffers; i++)
+			free(m_buffers[i]);
+	}
+
+	// build_index_input
+	static int Next(void* opaque, unsigned char** next) {
+		GzipIndexReadAhead& self = *(GzipIndexReadAhead*)opaque;
+		if (self.m_current >= 0)
+			self.m_free.Post(); // done with the previous buffer
+
+		self.m_full.WaitWithoutYield();
+		self.m_current = (self.m_current + 1) % Buffers;
+		*next = self.m_buffers[self.m_current];
+
+		int len = self.m_lengths[self.m_current];
+		if (len > 0 && self.m_size > 0) {
+			self.m_consumed += len;
+			int percent = (int)(self.m_consumed * 100 / self.m_size);
+			if (percent / 10 != self.m_lastPercent / 10)
+				Console.WriteLn(Color_Gray, L"Gzip index: %d%% (%d MB)", percent, (int)(self.m_consumed / _1mb));
+			self.m_lastPercent = percent;
+		}
+		return len;
+	}
+
+protected:
+	void ExecuteTaskInThread() {
+		for (int i = 0; ; i = (i + 1) % Buffers) {
+			m_free.WaitWithoutYield();
+			if (m_exit)
+				return;
+
+			size_t got = fread(m_buffers[i], 1, BufferSize, m_in);
+			m_lengths[i] = ferror(m_in) ? -1 : (int)got;
+			m_full.Post();
+			if (m_lengths[i] <= 0)
+				return;
+		}
+	}
+
+private:
+	static const int Buffers = 4;
+	static const int BufferSize = 1024 * 1024;
+
+	FILE* m_in;
+	s64 m_size;
+	s64 m_consumed;
+	int m_lastPercent;
+	u8* m_buffers[Buffers];
+	int m_lengths[Buffers];
+	int m_current;
+
+	Threading::Semaphore m_free;	// buffers the reader thread may fill
+	Threading::Semaphore m_full;	// buffers ready for build_index
+	std::atomic<bool> m_exit;
+};
+
 static wxString INDEX_TEMPLATE_KEY(L"$(f)");
 // template:
 // must contain one and only one instance of '$(f)' (without the quotes)
@@ -180,9 +407,13 @@ static wxString iso2indexname(const wxString& isoname) {
 GzippedFileReader::GzippedFileReader(void) :
 	mBytesRead(0),
 	m_pIndex(0),
+	m_indexMapping(0),
+	m_indexMappingSize(0),
 	m_zstates(0),
 	m_src(0),
-	m_cache(GZFILE_CACHE_SIZE_MB) {
+	m_cache(GZFILE_CACHE_SIZE_MB, GZFILE_READ_CHUNK_SIZE),
+	m_prefetcher(0),
+	m_prefetchSrc(0) {
 	m_blocksize = 2048;
 	AsyncPrefetchReset();
 };
@@ -291,8 +522,9 @@ bool GzippedFileReader::OkIndex() {
 	if (indexfile.length() == 0)
 		return false; // iso2indexname(...) will print errors if it can't apply the template
 
-	if (wxFileName::FileExists(indexfile) && (m_pIndex = ReadIndexFromFile(indexfile))) {
-		Console.WriteLn(Color_Green, L"OK: Gzip quick access index read from disk: '%s'", WX_STR(indexfile));
+	s64 compressedSize = fsize(m_filename);
+	if (wxFileName::FileExists(indexfile) && (m_pIndex = ReadIndexFromFile(indexfile, compressedSize, m_indexMapping, m_indexMappingSize))) {
+		Console.WriteLn(Color_Green, L"OK: Gzip quick access index %s from disk: '%s'", m_indexMapping ? L"mapped" : L"read", WX_STR(indexfile));
 		if (m_pIndex->span != GZFILE_SPAN_DEFAULT) {
 			Console.Warning(L"Note: This index has %1.1f MB intervals, while the current default for new indexes is %1.1f MB.",
 			                (float)m_pIndex->span / 1024 / 1024, (float)GZFILE_SPAN_DEFAULT / 1024 / 1024);
@@ -306,15 +538,24 @@ bool GzippedFileReader::OkIndex() {
 	// No valid index file. Generate an index
 	Console.Warning(L"This may take a while (but only once). Scanning compressed file to generate a quick access index...");
 
-	Access *index;
+	Access *index = 0;
+	int len = Z_ERRNO;
 	FILE* infile = PX_fopen_rb(m_filename);
-	int len = build_index(infile, GZFILE_SPAN_DEFAULT, &index);
-	printf("\n"); // build_index prints progress without \n's
-	fclose(infile);
+	if (infile) {
+		u64 start = GetCPUTicks();
+		{
+			GzipIndexReadAhead input(infile, compressedSize);
+			input.Start();
+			len = build_index(GzipIndexReadAhead::Next, &input, GZFILE_SPAN_DEFAULT, &index);
+		}
+		fclose(infile);
+		if (len > 0)
+			Console.WriteLn(Color_Gray, L"Gzip index: %d access points built in %d ms", len, (int)((GetCPUTicks() - start) * 1000 / GetTickFrequency()));
+	}
 
-	if (len >= 0) {
+	if (len > 0) {
 		m_pIndex = index;
-		WriteIndexToFile((Access*)m_pIndex, indexfile);
+		WriteIndexToFile((Access*)m_pIndex, indexfile, compressedSize);
 	} else {
 		Console.Error(L"ERROR (%d): index could not be generated for file '%s'", len, WX_STR(m_filename));
 		free_index(index);
@@ -335,9 +576,41 @@ bool GzippedFileReader::Open(const wxString& fileName) {
 	};
 
 	AsyncPrefetchOpen();
+	OpenPrefetcher();
 	return true;
 };
 
+void GzippedFileReader::OpenPrefetcher() {
+	if (!(m_prefetchSrc = PX_fopen_rb(m_filename))) {
+		Console.Warning(L"Warning: Can't open gzip file for prefetching, reading without it.");
+		return;
+	}
+	m_prefetcher = new ChunksPrefetcher(*this, &m_cache, GZFILE_READ_CHUNK_SIZE, GZFILE_PREFETCH_DEPTH, 1);
+}
+
+void GzippedFileReader::ClosePrefetcher() {
+	// The worker must be gone before its file and state are.
+	if (m_prefetcher) {
+		delete m_prefetcher;
+		m_prefetcher = 0;
+	}
+	m_prefetchState.Kill();
+	if (m_prefetchSrc) {
+		fclose(m_prefetchSrc);
+		m_prefetchSrc = 0;
+	}
+}
+
+// Only called by the prefetch worker, the reader extracts misses through _ReadSync.
+int GzippedFileReader::DecompressChunk(uint context, u32 index, u8* dest) {
+	PX_off_t offset = (PX_off_t)index * GZFILE_READ_CHUNK_SIZE;
+	if (offset >= m_pIndex->uncompressed_size)
+		return 0;
+
+	// Consecutive chunks continue from the previous state instead of the index.
+	return extract(m_prefetchSrc, m_pIndex, offset, dest, GZFILE_READ_CHUNK_SIZE, &m_prefetchState.state);
+}
+
 void GzippedFileReader::BeginRead(void* pBuffer, uint sector, uint count) {
 	// No a-sync support yet, implement as sync
 	mBytesRead = ReadSync(pBuffer, sector, count);
@@ -401,70 +674,98 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 
 	// From here onwards it's guarenteed that the request is inside a single GZFILE_READ_CHUNK_SIZE boundaries
 
-	int res = m_cache.Read(pBuffer, offset, bytesToRead);
+	// The prefetcher checks the cache first, and sees the access pattern that way.
+	int res;
+	if (m_prefetcher)
+		res = m_prefetcher->Read(offset / GZFILE_READ_CHUNK_SIZE, offset % GZFILE_READ_CHUNK_SIZE, pBuffer, bytesToRead, false);
+	else
+		res = m_cache.Read(pBuffer, offset, bytesToRead);
 	if (res >= 0)
 		return res;
 
-	// Not available from cache. Decompress from optimal starting
-	// point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
+	// Not available from cache. Decompress from optimal starting point in
+	// GZFILE_READ_CHUNK_SIZE chunks, straight into the cache slots.
 	PTT s = NOW();
 	PX_off_t extractOffset = GetOptimalExtractionStart(offset); // guaranteed in GZFILE_READ_CHUNK_SIZE boundaries
-	int size = offset + maxInChunk - extractOffset;
-	unsigned char* extracted = (unsigned char*)malloc(size);
+	PX_off_t chunkEnd = offset + maxInChunk;
 
 	int span = m_pIndex->span;
 	int spanix = extractOffset / span;
+	zstate* state = &m_zstates[spanix].state;
+	unsigned char* scratch = NULL; // when the cache has no slot to spare
+	PX_off_t extractEnd = extractOffset;
+	bool eof = false;
+	int copied = 0;
 	AsyncPrefetchCancel();
-	res = extract(m_src, m_pIndex, extractOffset, extracted, size, &(m_zstates[spanix].state));
-	if (res < 0) {
-		free(extracted);
-		return res;
-	}
-	AsyncPrefetchChunk(getInOffset(&(m_zstates[spanix].state)));
+	for (PX_off_t chunk = extractOffset; chunk < chunkEnd; chunk += GZFILE_READ_CHUNK_SIZE) {
+		unsigned char* dest = m_cache.Acquire(chunk);
+		if (!dest) {
+			if (!scratch)
+				scratch = (unsigned char*)malloc(GZFILE_READ_CHUNK_SIZE);
+			dest = scratch;
+		}
+
+		// Consecutive chunks continue from the state left by the previous one.  Past the
+		// end of the data, the chunks are still cached (empty) for their coverage.
+		res = eof ? 0 : extract(m_src, m_pIndex, chunk, dest, GZFILE_READ_CHUNK_SIZE, state);
+		if (res < 0) {
+			if (dest != scratch)
+				m_cache.Release(dest);
+			free(scratch);
+			return res;
+		}
 
-	int copied = ChunksCache::CopyAvailable(extracted, extractOffset, res, pBuffer, offset, bytesToRead);
+		if (chunk + GZFILE_READ_CHUNK_SIZE == chunkEnd)
+			copied = ChunksCache::CopyAvailable(dest, chunk, res, pBuffer, offset, bytesToRead);
+		if (dest != scratch)
+			m_cache.Commit(dest, res, GZFILE_READ_CHUNK_SIZE);
+
+		if (!eof)
+			extractEnd = chunk + res;
+		eof = res < GZFILE_READ_CHUNK_SIZE;
+	}
+	free(scratch);
+	AsyncPrefetchChunk(getInOffset(state));
 
-	if (m_zstates[spanix].state.isValid && (extractOffset + res) / span != offset / span) {
+	if (state->isValid && extractEnd / span != offset / span) {
 		// The state no longer matches this span.
 		// move the state to the appropriate span because it will be faster than using the index
-		int targetix = (extractOffset + res) / span;
+		int targetix = extractEnd / span;
 		m_zstates[targetix].Kill();
 		m_zstates[targetix] = m_zstates[spanix]; // We have elements for the entire file, and another one.
 		m_zstates[spanix].state.isValid = 0; // Not killing because we need the state.
 	}
 
-	if (size <= GZFILE_READ_CHUNK_SIZE)
-		m_cache.Take(extracted, extractOffset, res, size);
-	else { // split into cacheable chunks
-		for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE) {
-			int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
-			void* chunk = available ? malloc(available) : 0;
-			if (available)
-				memcpy(chunk, extracted + i, available);
-			m_cache.Take(chunk, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
-		}
-		free(extracted);
-	}
-
 	int duration = NOW() - s;
 	if (duration > 10)
 		Console.WriteLn(Color_Gray, L"gunzip: chunk #%5d-%2d : %1.2f MB - %d ms",
 		                (int)(offset / 4 / 1024 / 1024),
 		                (int)(offset % (4 * 1024 * 1024) / GZFILE_READ_CHUNK_SIZE),
-		                (float)size / 1024 / 1024,
+		                (float)(chunkEnd - extractOffset) / 1024 / 1024,
 		                duration);
 
 	return copied;
 }
 
 void GzippedFileReader::Close() {
+	ClosePrefetcher();
 	m_filename.Empty();
 	if (m_pIndex) {
-		free_index((Access*)m_pIndex);
+		if (m_indexMapping) {
+			// The access points are in the mapped index file
+			UnmapIndexFile(m_indexMapping, m_indexMappingSize);
+			free(m_pIndex);
+			m_indexMapping = 0;
+		} else {
+			free_index((Access*)m_pIndex);
+		}
 		m_pIndex = 0;
 	}
 
 	InitZstates(); // results in delete because no index
+	if (m_cache.GetHits() || m_cache.GetMisses())
+		Console.WriteLn(Color_Gray, L"gunzip: chunks cache hits: %llu, misses: %llu",
+		                (unsigned long long)m_cache.GetHits(), (unsigned long long)m_cache.GetMisses());
 	m_cache.Clear();
 
 	if (m_src) {
@@ -19,13 +19,15 @@ typedef struct zstate Zstate;
 
 #include "AsyncFileReader.h"
 #include "ChunksCache.h"
+#include "ChunksPrefetcher.h"
 #include "zlib_indexed.h"
 
 #define GZFILE_SPAN_DEFAULT (1048576L * 4)   /* distance between direct access points when creating a new index */
 #define GZFILE_READ_CHUNK_SIZE (256 * 1024)  /* zlib extraction chunks size (at 0-based boundaries) */
 #define GZFILE_CACHE_SIZE_MB 200             /* cache size for extracted data. must be at least GZFILE_READ_CHUNK_SIZE (in MB)*/
+#define GZFILE_PREFETCH_DEPTH 4              /* chunks extracted ahead of a sequential reader */
 
-class GzippedFileReader : public AsyncFileReader
+class GzippedFileReader : public AsyncFileReader, protected ChunksPrefetcher::Source
 {
 	DeclareNoncopyableObject(GzippedFileReader);
 public:
@@ -69,14 +71,25 @@ private:
 	PX_off_t GetOptimalExtractionStart(PX_off_t offset);
 	int     _ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRead);
 	void	InitZstates();
+	void	OpenPrefetcher();
+	void	ClosePrefetcher();
+	virtual int DecompressChunk(uint context, u32 index, u8* dest);
 
 	int		mBytesRead; // Temp sync read result when simulating async read
 	Access* m_pIndex;   // Quick access index
+	void*	m_indexMapping;     // v2 index files are mapped, m_pIndex->list points into it
+	size_t	m_indexMappingSize;
 	Czstate* m_zstates;
 	FILE*	m_src;
 
 	ChunksCache m_cache;
 
+	// The stream can only be inflated serially, so a single worker extracts the chunks
+	// following the reader, with its own file handle and a state which keeps up with it.
+	ChunksPrefetcher* m_prefetcher;
+	FILE*	m_prefetchSrc;
+	Czstate	m_prefetchState;
+
 #ifdef _WIN32
 	// Used by async prefetch
 	HANDLE hOverlappedFile;
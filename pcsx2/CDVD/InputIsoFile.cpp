@@ -45,6 +45,9 @@ int InputIsoFile::ReadSync(u8* dst, uint lsn)
 		return -1;
 	}
 
+	// The reader completes reads in order, don't mix this one up with the streamed ones.
+	FinishOutstandingReads();
+
 	return m_reader->ReadSync(dst+m_blockofs, lsn, 1);
 }
 
@@ -74,6 +77,37 @@ void InputIsoFile::BeginRead2(uint lsn)
 		return;
 	}
 
+	if(m_readahead_count && lsn >= m_readahead_lsn && lsn < (m_readahead_lsn+m_readahead_count))
+	{
+		// The game caught up with the read-ahead.  Reads complete in order, so the
+		// current one (if the game never finished it) has to be collected first.
+		if(m_read_inprogress)
+			m_reader->FinishRead();
+
+		std::swap(m_readbuffer, m_readaheadbuffer);
+		m_read_lsn = m_readahead_lsn;
+		m_read_count = m_readahead_count;
+		m_read_inprogress = m_readahead_inprogress;
+
+		m_readahead_inprogress = false;
+		m_readahead_count = 0;
+
+		// Keep streaming
+		uint next = m_read_lsn + m_read_count;
+		if(CanReadAhead(next))
+		{
+			m_readahead_lsn = next;
+			m_readahead_count = std::min(ReadUnit, m_blocks - next);
+			m_reader->BeginRead(m_readaheadbuffer, m_readahead_lsn, m_readahead_count);
+			m_readahead_inprogress = true;
+		}
+		return;
+	}
+
+	bool sequential = m_read_count && lsn == m_read_lsn + m_read_count;
+
+	FinishOutstandingReads();
+
 	m_read_lsn = lsn;
 	m_read_count = 1;
 
@@ -84,10 +118,51 @@ void InputIsoFile::BeginRead2(uint lsn)
 		m_read_count = std::min(ReadUnit, m_blocks - m_read_lsn);
 	}
 
-	m_reader->BeginRead(m_readbuffer, m_read_lsn, m_read_count);
+	uint next = m_read_lsn + m_read_count;
+	if(sequential && CanReadAhead(next))
+	{
+		m_readahead_lsn = next;
+		m_readahead_count = std::min(ReadUnit, m_blocks - next);
+
+		// Both in one go
+		AsyncReadRequest requests[2] = {
+			{ m_readbuffer, m_read_lsn, m_read_count },
+			{ m_readaheadbuffer, m_readahead_lsn, m_readahead_count },
+		};
+		m_reader->BeginReads(requests, 2);
+		m_readahead_inprogress = true;
+	}
+	else
+	{
+		m_reader->BeginRead(m_readbuffer, m_read_lsn, m_read_count);
+	}
 	m_read_inprogress = true;
 }
 
+// Only worth it for readers which can have a second read in flight, and for
+// multi-sector read units (blockdumps read one sector at a time).
+bool InputIsoFile::CanReadAhead(uint lsn) const
+{
+	return ReadUnit > 1 && lsn < m_blocks && m_reader->GetQueueDepth() > 1;
+}
+
+void InputIsoFile::FinishOutstandingReads()
+{
+	if(m_read_inprogress)
+	{
+		if(m_reader->FinishRead() < 0)
+			m_read_count = 0;
+		m_read_inprogress = false;
+	}
+
+	if(m_readahead_inprogress)
+	{
+		m_reader->FinishRead();
+		m_readahead_inprogress = false;
+	}
+	m_readahead_count = 0;
+}
+
 int InputIsoFile::FinishRead3(u8* dst, uint mode)
 {
 	int _offset = 0;
@@ -103,7 +178,11 @@ int InputIsoFile::FinishRead3(u8* dst, uint mode)
 		m_read_inprogress = false;
 
 		if(ret < 0)
+		{
+			// Don't treat the buffer as valid next time
+			m_read_count = 0;
 			return ret;
+		}
 	}
 		
 	switch (mode)
@@ -179,6 +258,11 @@ void InputIsoFile::_init()
 	
 	m_read_inprogress = false;
 	m_read_count = 0;
+	m_readbuffer = m_buffers[0];
+	m_readahead_inprogress = false;
+	m_readahead_lsn = 0;
+	m_readahead_count = 0;
+	m_readaheadbuffer = m_buffers[1];
 	ReadUnit = 0;
 	m_current_lsn = -1;
 	m_read_lsn = -1;
@@ -284,6 +368,9 @@ bool InputIsoFile::Open( const wxString& srcfile, bool testOnly )
 
 void InputIsoFile::Close()
 {
+	if (m_reader)
+		m_reader->CancelRead();
+
 	delete m_reader;
 	m_reader = NULL;
 	
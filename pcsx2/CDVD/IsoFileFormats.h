@@ -63,7 +63,16 @@ protected:
 	bool		m_read_inprogress;
 	uint		m_read_lsn;
 	uint		m_read_count;
-	u8			m_readbuffer[MaxReadUnit * CD_FRAMESIZE_RAW];
+	u8*			m_readbuffer;
+
+	// Next ReadUnit after the current one, read while the game consumes the current one.
+	// Promoted to the current read when the game gets to it.
+	bool		m_readahead_inprogress;
+	uint		m_readahead_lsn;
+	uint		m_readahead_count;
+	u8*			m_readaheadbuffer;
+
+	u8			m_buffers[2][MaxReadUnit * CD_FRAMESIZE_RAW];
 	
 public:	
 	InputIsoFile();
@@ -95,6 +104,9 @@ protected:
 
 	bool tryIsoType(u32 _size, s32 _offset, s32 _blockofs);
 	void FindParts();
+
+	void FinishOutstandingReads();
+	bool CanReadAhead(uint lsn) const;
 };
 
 class OutputIsoFile
@@ -49,6 +49,8 @@ Comments) 1950 to 1952 in the files http://tools.ietf.org/html/rfc1950
       (Thanks to Mark Adler for suggesting the approach)
   - build_index(...) - added progress prints
   - CHUNK changed from 16k to 512k
+  - build_index(...) - reads its input through a callback (so it can be read ahead on
+      another thread), progress is reported by the callback.
  */
 
 /* Illustrate the use of Z_BLOCK, inflatePrime(), and inflateSetDictionary()
@@ -208,6 +210,11 @@ local struct access *addpoint(struct access *index, int bits,
     return index;
 }
 
+/* Input callback for build_index(): points *next to the following piece of the
+   compressed stream and returns its size, 0 at the end of the file or negative on
+   a read error.  The data must stay valid until the next call. */
+typedef int (*build_index_input)(void *opaque, unsigned char **next);
+
 /* Make one entire pass through the compressed stream and build an index, with
    access points about every span bytes of uncompressed output -- span is
    chosen to balance the speed of random access against the memory requirements
@@ -216,14 +223,14 @@ local struct access *addpoint(struct access *index, int bits,
    returns the number of access points on success (>= 1), Z_MEM_ERROR for out
    of memory, Z_DATA_ERROR for an error in the input file, or Z_ERRNO for a
    file read error.  On success, *built points to the resulting index. */
-local int build_index(FILE *in, PX_off_t span, struct access **built)
+local int build_index(build_index_input input, void *opaque, PX_off_t span, struct access **built)
 {
-    int ret;
-    PX_off_t totin, totout, totPrinted;     /* our own total counters to avoid 4GB limit */
+    int ret, got;
+    PX_off_t totin, totout;     /* our own total counters to avoid 4GB limit */
     PX_off_t last;              /* totout value of last access point */
     struct access *index;       /* access points being generated */
     z_stream strm;
-    unsigned char input[CHUNK];
+    unsigned char *next;
     unsigned char window[WINSIZE];
 
     /* initialize inflate */
@@ -239,21 +246,22 @@ local int build_index(FILE *in, PX_off_t span, struct access **built)
     /* inflate the input, maintain a sliding window, and build an index -- this
        also validates the integrity of the compressed data using the check
        information at the end of the gzip or zlib stream */
-    totin = totout = last = totPrinted = 0;
+    totin = totout = last = 0;
     index = NULL;               /* will be allocated by first addpoint() */
     strm.avail_out = 0;
     do {
         /* get some compressed data from input file */
-        strm.avail_in = fread(input, 1, CHUNK, in);
-        if (ferror(in)) {
+        got = input(opaque, &next);
+        if (got < 0) {
             ret = Z_ERRNO;
             goto build_index_error;
         }
-        if (strm.avail_in == 0) {
+        if (got == 0) {
             ret = Z_DATA_ERROR;
             goto build_index_error;
         }
-        strm.next_in = input;
+        strm.avail_in = got;
+        strm.next_in = next;
 
         /* process all of that, or until end of stream */
         do {
@@ -297,10 +305,6 @@ local int build_index(FILE *in, PX_off_t span, struct access **built)
                 last = totout;
             }
         } while (strm.avail_in != 0);
-        if (totin / (50 * 1024 * 1024) != totPrinted / (50 * 1024 * 1024)) {
-            printf("%dMB ", (int)(totin / (1024 * 1024)));
-            totPrinted = totin;
-        }
     } while (ret != Z_STREAM_END);
 
     if (index == NULL) {
@@ -184,7 +184,8 @@ struct Pcsx2Config
 				RecBlocks_EE:1,		// Enables per-block profiling for the EE recompiler [unimplemented]
 				RecBlocks_IOP:1,	// Enables per-block profiling for the IOP recompiler [unimplemented]
 				RecBlocks_VU0:1,	// Enables per-block profiling for the VU0 recompiler [unimplemented]
-				RecBlocks_VU1:1;	// Enables per-block profiling for the VU1 recompiler [unimplemented]
+				RecBlocks_VU1:1,	// Enables per-block profiling for the VU1 recompiler [unimplemented]
+				EventCounts:1;		// Prints the EE/IOP events run per frame (see EventQueue.h)
 		BITFIELD_END
 
 		// Default is Disabled, with all recs enabled underneath.
@@ -233,6 +234,17 @@ struct Pcsx2Config
 				PreBlockCheckIOP:1;
 			bool
 				EnableEECache   :1;
+
+			// Remembers microVU programs per game and compiles them ahead of time (see microVU_Database.inl)
+			bool
+				MicroVUPrecompile	:1;
+
+			// Developer profiling, ini only (see BlockProfiler.h and Utilities/Perf.h)
+			bool
+				BlockProfilerEE		:1,
+				BlockProfilerIOP	:1,
+				BlockProfilerTicks	:1,
+				PerfMap				:1;
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -283,6 +295,8 @@ struct Pcsx2Config
 		bool	SynchronousMTGS;
 		bool	DisableOutput;
 		int		VsyncQueueSize;
+		int		RingBufferSizeFactor;	// MTGS ring buffer is 1<<factor qwords, applied when the MTGS starts
+		int		FramePacingStatsFrames;	// logs the frame interval histogram every that many frames (0 = never)
 
 		bool	FrameLimitEnable;
 		bool	FrameSkipEnable;
@@ -309,6 +323,8 @@ struct Pcsx2Config
 				OpEqu( SynchronousMTGS )		&&
 				OpEqu( DisableOutput )			&&
 				OpEqu( VsyncQueueSize )			&&
+				OpEqu( RingBufferSizeFactor )	&&
+				OpEqu( FramePacingStatsFrames )	&&
 				
 				OpEqu( FrameSkipEnable )		&&
 				OpEqu( FrameLimitEnable )		&&
@@ -377,6 +393,37 @@ struct Pcsx2Config
 		}
 	};
 
+	// ------------------------------------------------------------------------
+	// Handoffs between the EE, MTGS and MTVU threads (see System/SysWait.h)
+	struct ThreadOptions
+	{
+		int		WaitSpinNs;			// EE spins this long before sleeping on the MTGS/MTVU
+		int		IdleSpinNs;			// MTGS/MTVU spin this long before sleeping when out of work
+		int		AffinityEE;			// host cpu the thread is pinned to, -1 lets the OS schedule it
+		int		AffinityMTGS;
+		int		AffinityMTVU;
+		int		StallStatsFrames;	// prints the stall histograms every n frames, 0 disables them
+
+		ThreadOptions();
+		void LoadSave( IniInterface& conf );
+
+		bool operator ==( const ThreadOptions& right ) const
+		{
+			return
+				OpEqu( WaitSpinNs )			&&
+				OpEqu( IdleSpinNs )			&&
+				OpEqu( AffinityEE )			&&
+				OpEqu( AffinityMTGS )		&&
+				OpEqu( AffinityMTVU )		&&
+				OpEqu( StallStatsFrames );
+		}
+
+		bool operator !=( const ThreadOptions& right ) const
+		{
+			return !this->operator ==( right );
+		}
+	};
+
 	// ------------------------------------------------------------------------
 	struct SpeedhackOptions
 	{
@@ -445,6 +492,8 @@ struct Pcsx2Config
 		// when enabled uses BOOT2 injection, skipping sony bios splashes
 			UseBOOT2Injection	:1,
 			BackupSavestate		:1,
+		// copy-on-write snapshot of the main memories when saving states (see MemorySnapshot)
+			SavestateSnapshots	:1,
 		// enables simulated ejection of memory cards when loading savestates
 			McdEnableEjection	:1,
 			McdFolderAutoManage	:1,
@@ -456,8 +505,13 @@ struct Pcsx2Config
 			HostFs				:1;
 	BITFIELD_END
 
+	int					SavestateZlibLevel;		// 1 (fastest) to 9, 0 stores the savestates uncompressed
+	int					RewindInterval;			// vsyncs between rewind checkpoints, 0 disables them
+	int					RewindBudget;			// megabytes of rewind checkpoints, and the two raw states they're encoded with
+
 	CpuOptions			Cpu;
 	GSOptions			GS;
+	ThreadOptions		Threads;
 	SpeedhackOptions	Speedhacks;
 	GamefixOptions		Gamefixes;
 	ProfilerOptions		Profiler;
@@ -481,8 +535,12 @@ struct Pcsx2Config
 	{
 		return
 			OpEqu( bitset )		&&
+			OpEqu( SavestateZlibLevel )	&&
+			OpEqu( RewindInterval )	&&
+			OpEqu( RewindBudget )	&&
 			OpEqu( Cpu )		&&
 			OpEqu( GS )			&&
+			OpEqu( Threads )	&&
 			OpEqu( Speedhacks )	&&
 			OpEqu( Gamefixes )	&&
 			OpEqu( Profiler )	&&
@@ -28,6 +28,7 @@
 #include "VUmicro.h"
 
 #include "ps2/HwInternal.h"
+#include "System/FramePacer.h"
 
 #include "Sio.h"
 
@@ -168,7 +169,6 @@ void rcntInit()
 #endif
 
 static s64 m_iTicks=0;
-static u64 m_iStart=0;
 
 struct vSyncTimingInfo
 {
@@ -312,62 +312,23 @@ u32 UpdateVSyncRate()
 		Console.WriteLn( Color_Green, "(UpdateVSyncRate) FPS Limit Changed : %.02f fps", fpslimit.ToFloat()*2 );
 	}
 
-	m_iStart = GetCPUTicks();
+	FramePacer::Reset();
 
 	return (u32)m_iTicks;
 }
 
 void frameLimitReset()
 {
-	m_iStart = GetCPUTicks();
+	FramePacer::Reset();
 }
 
-// Framelimiter - Measures the delta time between calls and stalls until a
-// certain amount of time passes if such time hasn't passed yet.
+// Framelimiter - Waits until the frame's deadline (see FramePacer), and records
+// the frame intervals either way.
 // See the GS FrameSkip function for details on why this is here and not in the GS.
 static __fi void frameLimit()
 {
 	// 999 means the user would rather just have framelimiting turned off...
-	if( !EmuConfig.GS.FrameLimitEnable ) return;
-
-	u64 uExpectedEnd	= m_iStart + m_iTicks;
-	u64 iEnd			= GetCPUTicks();
-	s64 sDeltaTime		= iEnd - uExpectedEnd;
-
-	// If the framerate drops too low, reset the expected value.  This avoids
-	// excessive amounts of "fast forward" syndrome which would occur if we
-	// tried to catch up too much.
-
-	if( sDeltaTime > m_iTicks*8 )
-	{
-		m_iStart = iEnd - m_iTicks;
-		return;
-	}
-
-	// use the expected frame completion time as our starting point.
-	// improves smoothness by making the framelimiter more adaptive to the
-	// imperfect TIMESLICE() wait, and allows it to speed up a wee bit after
-	// slow frames to "catch up."
-
-	m_iStart = uExpectedEnd;
-
-	// Shortcut for cases where no waiting is needed (they're running slow already,
-	// so don't bog 'em down with extra math...)
-	if( sDeltaTime >= 0 ) return;
-
-	// If we're way ahead then we can afford to sleep the thread a bit.
-	// (note, on Windows sleep(1) thru sleep(2) tend to be the least accurate sleeps,
-	// and longer sleeps tend to be pretty reliable, so that's why the convoluted if/
-	// else below.  The same generally isn't true for Linux, but no harm either way
-	// really.)
-
-	s32 msec = (int)((sDeltaTime*-1000) / (s64)GetTickFrequency());
-	if( msec > 4 ) Threading::Sleep( msec );
-	else if( msec > 2 ) Threading::Sleep( 1 );
-
-	// Sleep is not picture-perfect accurate, but it's actually not necessary to
-	// maintain a "perfect" lock to uExpectedEnd anyway.  if we're a little ahead
-	// starting this frame, it'll just sleep longer the next to make up for it. :)
+	FramePacer::FrameDone( EmuConfig.GS.FrameLimitEnable, m_iTicks );
 }
 
 static __fi void VSyncStart(u32 sCycle)
@@ -382,6 +343,8 @@ static __fi void VSyncStart(u32 sCycle)
 	// FIXME: should probably be moved to VsyncInThread, and handled
 	// by UI implementations.  (ie, AppCoreThread in PCSX2-wx interface).
 	vSyncDebugStuff( g_FrameCount );
+	cpuEventStatsFrameDone();
+	psxEventStatsFrameDone();
 
 	CpuVU0->Vsync();
 	CpuVU1->Vsync();
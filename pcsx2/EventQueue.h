@@ -0,0 +1,197 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  EventQueue - pending EE/IOP events ordered by due cycle
+// --------------------------------------------------------------------------------------
+// A min-heap of the events scheduled with CPU_INT/PSX_INT, so an event test only looks at
+// the events which are actually due, and the next one gives the next event test cycle.
+//
+// The interrupt/sCycle/eCycle registers remain the authoritative (savestated) state.  Some
+// of the DMA code clears interrupt bits or pushes eCycle back directly, so instead of being
+// removed when that happens, entries are checked against the registers when they reach the
+// top of the heap: cancelled ones are dropped and postponed ones are queued again.  Moving
+// an event earlier has to go through CPU_INT/PSX_INT.  The queues are cleared when the
+// registers are reset or loaded, pending events which aren't queued are queued by Prune().
+
+class EventQueue
+{
+public:
+	static const uint MaxEntries = 64;
+
+	struct Entry
+	{
+		u32 due;
+		u32 id;
+	};
+
+protected:
+	Entry	m_heap[MaxEntries];
+	uint	m_size;
+	u32		m_mask;				// events with a handler, the others are never queued
+	u32		m_queued;			// events with a current entry in the heap
+	u32		m_latest[32];		// due cycle of the current entry of each event
+
+	u32		m_fired[32];		// stats: events run since the last print
+	uint	m_frames;
+
+	static bool Before( u32 a, u32 b ) { return (s32)(a - b) < 0; }
+
+	void SiftUp( uint i )
+	{
+		Entry e = m_heap[i];
+		while (i > 0)
+		{
+			uint parent = (i - 1) / 2;
+			if (!Before(e.due, m_heap[parent].due)) break;
+			m_heap[i] = m_heap[parent];
+			i = parent;
+		}
+		m_heap[i] = e;
+	}
+
+	void SiftDown( uint i )
+	{
+		Entry e = m_heap[i];
+		for (;;)
+		{
+			uint child = i * 2 + 1;
+			if (child >= m_size) break;
+			if (child + 1 < m_size && Before(m_heap[child + 1].due, m_heap[child].due)) child++;
+			if (!Before(m_heap[child].due, e.due)) break;
+			m_heap[i] = m_heap[child];
+			i = child;
+		}
+		m_heap[i] = e;
+	}
+
+	void RemoveTop()
+	{
+		m_heap[0] = m_heap[--m_size];
+		if (m_size) SiftDown(0);
+	}
+
+	void Push( uint id, u32 due )
+	{
+		// Stale entries only go away when they reach the top, start over if they pile up.
+		if (m_size == MaxEntries)
+		{
+			m_size = 0;
+			for (uint i = 0; i < 32; i++)
+				if (m_queued & (1u << i)) { m_heap[m_size].due = m_latest[i]; m_heap[m_size].id = i; SiftUp(m_size++); }
+		}
+
+		m_queued    |= 1u << id;
+		m_latest[id] = due;
+		m_heap[m_size].due = due;
+		m_heap[m_size].id  = id;
+		SiftUp(m_size++);
+	}
+
+	// Drops the top entries which don't match the registers anymore (re-queueing the
+	// events which were moved), until the top entry is a real pending event.
+	void Prune( u32 pending, const u32* sCycle, const u32* eCycle )
+	{
+		pending &= m_mask;
+
+		u32 missing = pending & ~m_queued;
+		for (uint id = 0; missing; id++, missing >>= 1)
+			if (missing & 1) Push(id, sCycle[id] + eCycle[id]);
+
+		while (m_size)
+		{
+			const Entry top = m_heap[0];
+			const u32 bit   = 1u << top.id;
+
+			if ((m_queued & bit) && m_latest[top.id] == top.due)
+			{
+				if (!(pending & bit)) m_queued &= ~bit;		// cancelled
+				else
+				{
+					u32 due = sCycle[top.id] + eCycle[top.id];
+					if (due == top.due) return;				// still valid
+					RemoveTop();
+					Push(top.id, due);						// eCycle was changed in place
+					continue;
+				}
+			}
+			RemoveTop();									// replaced by a newer entry
+		}
+	}
+
+public:
+	EventQueue( u32 mask ) : m_mask( mask ) { Clear(); }
+
+	void Clear()
+	{
+		m_size   = 0;
+		m_queued = 0;
+		m_frames = 0;
+		memzero(m_fired);
+	}
+
+	// Called after the event registers were set, O(log n).
+	void Schedule( uint id, u32 startCycle, s32 delta )
+	{
+		if (m_mask & (1u << id)) Push(id, startCycle + delta);
+	}
+
+	// Returns false when no event is pending, otherwise the due cycle of the next one.
+	bool Next( u32& due, u32 pending, const u32* sCycle, const u32* eCycle )
+	{
+		Prune(pending, sCycle, eCycle);
+		if (!m_size) return false;
+		due = m_heap[0].due;
+		return true;
+	}
+
+	// Removes the events due at the given cycle and returns them as a mask.  The caller
+	// runs them (in its preferred order), so events queued again by the handlers wait for
+	// the next event test.
+	u32 PopDue( u32 cycle, u32 pending, const u32* sCycle, const u32* eCycle )
+	{
+		u32 due = 0;
+		for (;;)
+		{
+			Prune(pending & ~due, sCycle, eCycle);
+			if (!m_size || Before(cycle, m_heap[0].due)) break;
+			due        |= 1u << m_heap[0].id;
+			m_queued   &= ~(1u << m_heap[0].id);
+			RemoveTop();
+		}
+		return due;
+	}
+
+	void CountFired( uint id ) { m_fired[id]++; }
+
+	// Prints the average number of each event per frame every 'frames' frames.
+	void FrameDone( const char* cpu, const char* const* names, uint frames )
+	{
+		if (++m_frames < frames) return;
+
+		FastFormatAscii line;
+		for (uint i = 0; i < 32; i++)
+		{
+			if (!m_fired[i]) continue;
+			line.Write(" %s:%.1f", names[i] ? names[i] : "?", (double)m_fired[i] / m_frames);
+		}
+		Console.WriteLn(Color_Gray, "%s events/frame:%s", cpu, line.c_str());
+
+		m_frames = 0;
+		memzero(m_fired);
+	}
+};
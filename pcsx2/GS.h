@@ -301,6 +301,11 @@ public:
 	uint			m_packet_size;		// size of the packet (data only, ie. not including the 16 byte command!)
 	uint			m_packet_writepos;	// index of the data location in the ringbuffer.
 
+	// Ring use statistics, only touched by the EE thread.
+	uint			m_RingHighWater;	// most qwords in use at once
+	uint			m_RingStalls;		// times the EE waited for room
+	u64				m_RingStallTicks;	// time spent waiting, in cpu ticks
+
 #ifdef RINGBUF_DEBUG_STACK
 	Threading::Mutex m_lock_Stack;
 #endif
@@ -343,6 +348,7 @@ protected:
 	void OnCleanupInThread();
 
 	void GenericStall( uint size );
+	void PrintRingStats();
 
 	// Used internally by SendSimplePacket type functions
 	void _FinishSimplePacket();
@@ -409,24 +415,33 @@ extern int g_nLeftGSFrames;
 #endif
 
 // Size of the ringbuffer as a power of 2 -- size is a multiple of simd128s.
-// (actual size is 1<<m_RingBufferSizeFactor simd vectors [128-bit values])
+// (actual size is 1<<RingBufferSizeFactor simd vectors [128-bit values])
 // A value of 19 is a 8meg ring buffer.  18 would be 4 megs, and 20 would be 16 megs.
 // Default was 2mb, but some games with lots of MTGS activity want 8mb to run fast (rama)
-static const uint RingBufferSizeFactor = 19;
+// The factor comes from EmuConfig.GS.RingBufferSizeFactor, the ring is (re)allocated
+// whenever the MTGS thread starts.
+static const uint RingBufferSizeFactorMin = 16;
+static const uint RingBufferSizeFactorMax = 22;
+extern uint RingBufferSizeFactor;
 
 // size of the ringbuffer in simd128's.
-static const uint RingBufferSize = 1<<RingBufferSizeFactor;
+extern uint RingBufferSize;
 
 // Mask to apply to ring buffer indices to wrap the pointer from end to
 // start (the wrapping is what makes it a ringbuffer, yo!)
-static const uint RingBufferMask = RingBufferSize - 1;
+extern uint RingBufferMask;
 
 struct MTGS_BufferedData
 {
-	u128		m_Ring[RingBufferSize];
+	// Regs comes first so it keeps the alignment of RingBuffer (it's handed to the GS plugin
+	// and copied to as u128s).
 	u8			Regs[Ps2MemSize::GSregs];
+	u128*		m_Ring;
+
+	MTGS_BufferedData();
+	~MTGS_BufferedData() throw();
 
-	MTGS_BufferedData() {}
+	void Alloc( uint sizeFactor );
 
 	u128& operator[]( uint idx )
 	{
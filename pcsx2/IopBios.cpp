@@ -17,6 +17,7 @@
 #include "PrecompiledHeader.h"
 #include "IopCommon.h"
 #include "R5900.h" // for g_GameStarted
+#include "System/MemorySnapshot.h"
 
 #include <ctype.h>
 #include <string.h>
@@ -411,7 +412,36 @@ namespace ioman {
 			if (!iopVirtMemR<void>(buf))
 				return 0;
 
-			v0 = file->read(iopVirtMemW<void>(buf), count);
+			if (MemorySnapshot::IsActive())
+			{
+				// The snapshot may still have the buffer write-protected, and the host read()
+				// fails with EFAULT there instead of faulting.  Read through a bounce buffer,
+				// the copy faults the pages in like any other write of the VM.
+				u8 bounce[16 * 1024];
+				u8* dest = iopVirtMemW<u8>(buf);
+				s32 total = 0;
+
+				while (count)
+				{
+					u32 len = std::min<u32>(count, sizeof(bounce));
+					int ret = file->read(bounce, len);
+					if (ret <= 0)
+					{
+						if (!total) total = ret;
+						break;
+					}
+
+					memcpy(dest + total, bounce, ret);
+					total += ret;
+					count -= ret;
+					if ((u32)ret < len)
+						break;
+				}
+
+				v0 = total;
+			}
+			else
+				v0 = file->read(iopVirtMemW<void>(buf), count);
 			pc = ra;
 			return 1;
 		}
@@ -16,11 +16,16 @@
 #include "PrecompiledHeader.h"
 #include "AsyncFileReader.h"
 
+#include <errno.h>
+#include <fcntl.h>
+
 FlatFileReader::FlatFileReader(bool shareWrite) : shareWrite(shareWrite)
 {
 	m_blocksize = 2048;
 	m_fd = -1;
 	m_aio_context = 0;
+	m_queue_head = 0;
+	m_queue_count = 0;
 }
 
 FlatFileReader::~FlatFileReader(void)
@@ -32,11 +37,15 @@ bool FlatFileReader::Open(const wxString& fileName)
 {
 	m_filename = fileName;
 
-	int err = io_setup(64, &m_aio_context);
+	int err = io_setup(MaxQueueDepth, &m_aio_context);
 	if (err) return false;
 
     m_fd = wxOpen(fileName, O_RDONLY, 0);
 
+	// Sequential streams keep several reads in flight, let the kernel read further ahead too.
+	if (m_fd != -1)
+		posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
 	return (m_fd != -1);
 }
 
@@ -48,44 +57,88 @@ int FlatFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 
 void FlatFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 {
-	u64 offset;
-	offset = sector * (s64)m_blocksize + m_dataoffset;
+	AsyncReadRequest request = { pBuffer, sector, count };
+	BeginReads(&request, 1);
+}
+
+void FlatFileReader::BeginReads(const AsyncReadRequest* requests, uint count)
+{
+	pxAssertDev(m_queue_count + count <= MaxQueueDepth, "FlatFileReader: too many reads in flight");
 
-	u32 bytesToRead = count * m_blocksize;
+	struct iocb* iocbs[MaxQueueDepth];
 
-	struct iocb iocb;
-	struct iocb* iocbs = &iocb;
+	for (uint i = 0; i < count; i++)
+	{
+		uint slot = (m_queue_head + m_queue_count + i) % MaxQueueDepth;
+
+		u64 offset = requests[i].sector * (s64)m_blocksize + m_dataoffset;
+		u32 bytesToRead = requests[i].count * m_blocksize;
+
+		io_prep_pread(&m_iocbs[slot], m_fd, requests[i].buffer, bytesToRead, offset);
+		m_done[slot] = false;
+		m_results[slot] = -1;
+		iocbs[i] = &m_iocbs[slot];
+	}
+
+	// All of them in a single syscall
+	int submitted = io_submit(m_aio_context, count, iocbs);
+	for (uint i = std::max(submitted, 0); i < count; i++)
+	{
+		// Not queued, FinishRead will report the failure
+		uint slot = (m_queue_head + m_queue_count + i) % MaxQueueDepth;
+		m_done[slot] = true;
+	}
 
-	io_prep_pread(&iocb, m_fd, pBuffer, bytesToRead, offset);
-	io_submit(m_aio_context, 1, &iocbs);
+	m_queue_count += count;
 }
 
-int FlatFileReader::FinishRead(void)
+// Completions can arrive in any order, they're matched to their slot by iocb.
+void FlatFileReader::WaitForEvents(uint min_nr)
 {
-	u32 bytes;
+	struct io_event events[MaxQueueDepth];
+
+	int nr = io_getevents(m_aio_context, min_nr, MaxQueueDepth, events, NULL);
+	for (int i = 0; i < nr; i++)
+	{
+		uint slot = events[i].obj - m_iocbs;
+		m_results[slot] = (long)events[i].res;
+		m_done[slot] = true;
+	}
 
-	int min_nr = 1;
-	int max_nr = 1;
-    struct io_event* events = new io_event[max_nr];
+	if (nr < 0 && nr != -EINTR)
+	{
+		// Don't wait forever on a broken context
+		for (uint i = 0; i < m_queue_count; i++)
+			m_done[(m_queue_head + i) % MaxQueueDepth] = true;
+	}
+}
 
-	int event = io_getevents(m_aio_context, min_nr, max_nr, events, NULL);
-	if (event < 1) {
+int FlatFileReader::FinishRead(void)
+{
+	if (!m_queue_count)
 		return -1;
-	}
 
-	return 1;
+	uint slot = m_queue_head;
+	while (!m_done[slot])
+		WaitForEvents(1);
+
+	m_queue_head = (m_queue_head + 1) % MaxQueueDepth;
+	m_queue_count--;
+
+	return m_results[slot] < 0 ? -1 : (int)m_results[slot];
 }
 
 void FlatFileReader::CancelRead(void)
 {
-	// Will be done when m_aio_context context is destroyed
-	// Note: io_cancel exists but need the iocb structure as parameter
-	// int io_cancel(aio_context_t ctx_id, struct iocb *iocb,
-	//                struct io_event *result);
+	// io_cancel isn't supported for regular files, and the buffers must not
+	// be written to once the caller reuses them, so wait for all of them.
+	while (m_queue_count)
+		FinishRead();
 }
 
 void FlatFileReader::Close(void)
 {
+	CancelRead();
 
 	if (m_fd != -1) close(m_fd);
 
@@ -24,6 +24,7 @@
 #include "MTVU.h"
 #include "Elfheader.h"
 #include "SamplProf.h"
+#include "System/SysWait.h"
 
 
 // Uncomment this to enable profiling of the GS RingBufferCopy function.
@@ -51,6 +52,42 @@ using namespace Threading;
 __aligned(32) MTGS_BufferedData RingBuffer;
 extern bool renderswitch;
 
+// Statically initialized, so they're valid before RingBuffer is constructed.
+uint RingBufferSizeFactor	= 19;
+uint RingBufferSize			= 1 << 19;
+uint RingBufferMask			= (1 << 19) - 1;
+
+// The default sized ring exists from the start (as it did when it was a static array),
+// in case something is queued before the MTGS thread is started.
+MTGS_BufferedData::MTGS_BufferedData()
+{
+	m_Ring = (u128*)_aligned_malloc( sizeof(u128) << RingBufferSizeFactor, 64 );
+}
+
+MTGS_BufferedData::~MTGS_BufferedData() throw()
+{
+	safe_aligned_free( m_Ring );
+}
+
+// Must only be called while the MTGS thread isn't running (the ring is empty).
+void MTGS_BufferedData::Alloc( uint sizeFactor )
+{
+	sizeFactor = std::min( std::max( sizeFactor, RingBufferSizeFactorMin ), RingBufferSizeFactorMax );
+	if( m_Ring && sizeFactor == RingBufferSizeFactor ) return;
+
+	safe_aligned_free( m_Ring );
+	m_Ring = (u128*)_aligned_malloc( sizeof(u128) << sizeFactor, 64 );
+	if( !m_Ring )
+		throw Exception::OutOfMemory( L"MTGS ring buffer" )
+			.SetDiagMsg( pxsFmt( L"(%u KB)", (uint)((sizeof(u128) << sizeFactor) / _1kb) ) );
+
+	RingBufferSizeFactor	= sizeFactor;
+	RingBufferSize			= 1 << sizeFactor;
+	RingBufferMask			= RingBufferSize - 1;
+
+	DevCon.WriteLn( "MTGS: Ring buffer is %u KB", (uint)((sizeof(u128) << sizeFactor) / _1kb) );
+}
+
 
 #ifdef RINGBUF_DEBUG_STACK
 #include <list>
@@ -85,6 +122,12 @@ void SysMtgsThread::OnStart()
 
 	m_CopyDataTally		= 0;
 
+	m_RingHighWater		= 0;
+	m_RingStalls		= 0;
+	m_RingStallTicks	= 0;
+
+	RingBuffer.Alloc( EmuConfig.GS.RingBufferSizeFactor );
+
 	_parent::OnStart();
 }
 
@@ -150,6 +193,8 @@ void SysMtgsThread::PostVsyncStart()
 	// Vsyncs should always start the GS thread, regardless of how little has actually be queued.
 	if (m_CopyDataTally != 0) SetEvent();
 
+	if (SysWait::FrameDone()) PrintRingStats();
+
 	// If the MTGS is allowed to queue a lot of frames in advance, it creates input lag.
 	// Use the Queued FrameCount to stall the EE if another vsync (or two) are already queued
 	// in the ringbuffer.  The queue limit is disabled when both FrameLimiting and Vsync are
@@ -165,6 +210,7 @@ void SysMtgsThread::PostVsyncStart()
 
 	m_VsyncSignalListener = true;
 	//Console.WriteLn( Color_Blue, "(EEcore Sleep) Vsync\t\tringpos=0x%06x, writepos=0x%06x", volatize(m_ReadPos), m_WritePos );
+	ScopedSysWait stall(SysWait_MtgsVsync);
 	m_sem_Vsync.WaitNoCancel();
 }
 
@@ -272,6 +318,8 @@ void SysMtgsThread::ExecuteTaskInThread()
 
 	RingBufferLock busy (*this);
 
+	SysWait::SetAffinity("MTGS", EmuConfig.Threads.AffinityMTGS);
+
 	while(true) {
 		busy.Release();
 
@@ -279,7 +327,13 @@ void SysMtgsThread::ExecuteTaskInThread()
 		// is very optimized (only 1 instruction test in most cases), so no point in trying
 		// to avoid it.
 
-		m_sem_event.WaitWithoutYield();
+		// The EE only kicks us every so often, spinning picks up new data sooner (if enabled)
+		if (SysWait::Spin(EmuConfig.Threads.IdleSpinNs, [&]() { return m_ReadPos != volatize(m_WritePos); })) {
+			SysWait::Drain(m_sem_event);
+		} else {
+			ScopedSysWait stall(SysWait_MtgsIdle);
+			m_sem_event.WaitWithoutYield();
+		}
 		StateCheckInThread();
 		busy.Acquire();
 
@@ -404,7 +458,10 @@ void SysMtgsThread::ExecuteTaskInThread()
 					vu1Thread.KickStart(true);
 					busy.m_lock2.Release();
 					// Wait for MTVU to complete vu1 program
-					vu1Thread.semaXGkick.WaitWithoutYield();
+					{
+						ScopedSysWait stall(SysWait_MtgsXGkick);
+						vu1Thread.semaXGkick.WaitWithoutYield();
+					}
 					busy.m_lock2.Acquire();
 					Gif_Path& path   = gifUnit.gifPath[GIF_PATH_1];
 					GS_Packet gsPack = path.GetGSPacketMTVU(); // Get vu1 program's xgkick packet(s)
@@ -576,6 +633,8 @@ void SysMtgsThread::OnResumeInThread( bool isSuspended )
 	if( isSuspended )
 		OpenPlugin();
 
+	SysWait::SetAffinity("MTGS", EmuConfig.Threads.AffinityMTGS);
+
 	_parent::OnResumeInThread( isSuspended );
 }
 
@@ -600,8 +659,13 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 	u32 startP1Packs = weakWait ? path.GetPendingGSPackets() : 0;
 
 	if (isMTVU || volatize(m_ReadPos) != m_WritePos) {
+		ScopedSysWait stall(SysWait_MtgsSync);
 		SetEvent();
 		RethrowException();
+		if (!isMTVU && !weakWait) {
+			// Short waits are over before the busy mutex could even be slept on
+			SysWait::Spin(EmuConfig.Threads.WaitSpinNs, [&]() { return volatize(m_ReadPos) == m_WritePos; });
+		}
 		for(;;) {
 			if (weakWait) m_mtx_RingBufferBusy2.Wait();
 			else          m_mtx_RingBufferBusy .Wait();
@@ -694,8 +758,15 @@ void SysMtgsThread::GenericStall( uint size )
 	else
 		freeroom = RingBufferSize - (writepos - readpos);
 
+	// Peak use of the ring, including the packet about to be written
+	uint used = RingBufferSize - freeroom + size;
+	if (used > m_RingHighWater) m_RingHighWater = used;
+
 	if (freeroom <= size)
 	{
+		ScopedSysWait stall(SysWait_MtgsRingFull);
+		u64 stallStart = GetCPUTicks();
+
 		// writepos will overlap readpos if we commit the data, so we need to wait until
 		// readpos is out past the end of the future write pos, or until it wraps around
 		// (in which case writepos will be >= readpos).
@@ -714,26 +785,35 @@ void SysMtgsThread::GenericStall( uint size )
 		if( somedone > 0x80 )
 		{
 			pxAssertDev( m_SignalRingEnable == 0, "MTGS Thread Synchronization Error" );
-			m_SignalRingPosition = somedone;
 
-			//Console.WriteLn( Color_Blue, "(EEcore Sleep) PrepDataPacker \tringpos=0x%06x, writepos=0x%06x, signalpos=0x%06x", readpos, writepos, m_SignalRingPosition );
+			// Spin a little first, the MTGS may be about to free enough room
+			SetEvent();
+			if (!SysWait::Spin(EmuConfig.Threads.WaitSpinNs, [&]() {
+				uint readpos = volatize(m_ReadPos);
+				return (writepos < readpos ? readpos - writepos : RingBufferSize - (writepos - readpos)) > size;
+			}))
+			{
+				m_SignalRingPosition = somedone;
 
-			while(true) {
-				m_SignalRingEnable = true;
-				SetEvent();
-				m_sem_OnRingReset.WaitWithoutYield();
-				readpos = volatize(m_ReadPos);
-				//Console.WriteLn( Color_Blue, "(EEcore Awake) Report!\tringpos=0x%06x", readpos );
+				//Console.WriteLn( Color_Blue, "(EEcore Sleep) PrepDataPacker \tringpos=0x%06x, writepos=0x%06x, signalpos=0x%06x", readpos, writepos, m_SignalRingPosition );
 
-				if (writepos < readpos)
-					freeroom = readpos - writepos;
-				else
-					freeroom = RingBufferSize - (writepos - readpos);
+				while(true) {
+					m_SignalRingEnable = true;
+					SetEvent();
+					m_sem_OnRingReset.WaitWithoutYield();
+					readpos = volatize(m_ReadPos);
+					//Console.WriteLn( Color_Blue, "(EEcore Awake) Report!\tringpos=0x%06x", readpos );
 
-				if (freeroom > size) break;
-			}
+					if (writepos < readpos)
+						freeroom = readpos - writepos;
+					else
+						freeroom = RingBufferSize - (writepos - readpos);
+
+					if (freeroom > size) break;
+				}
 
-			pxAssertDev( m_SignalRingPosition <= 0, "MTGS Thread Synchronization Error" );
+				pxAssertDev( m_SignalRingPosition <= 0, "MTGS Thread Synchronization Error" );
+			}
 		}
 		else
 		{
@@ -751,9 +831,28 @@ void SysMtgsThread::GenericStall( uint size )
 				if (freeroom > size) break;
 			}
 		}
+
+		m_RingStalls++;
+		m_RingStallTicks += GetCPUTicks() - stallStart;
 	}
 }
 
+// Printed along with the stall histograms (see SysWait), the counters restart after each print.
+void SysMtgsThread::PrintRingStats()
+{
+	u64 freq = GetTickFrequency();
+	Console.WriteLn( Color_Gray, "MTGS ring: %u KB, peak %u KB (%u%%), %u stalls for %u us",
+		(RingBufferSize * 16) / _1kb, (m_RingHighWater * 16) / _1kb, (uint)((u64)m_RingHighWater * 100 / RingBufferSize),
+		m_RingStalls, (uint)(freq ? m_RingStallTicks * 1000000 / freq : 0) );
+
+	if( m_RingHighWater >= RingBufferSize - RingBufferSize / 8 && RingBufferSizeFactor < RingBufferSizeFactorMax )
+		Console.WriteLn( Color_Gray, "MTGS ring: almost full, consider raising [GS] RingBufferSizeFactor (%u)", RingBufferSizeFactor );
+
+	m_RingHighWater		= 0;
+	m_RingStalls		= 0;
+	m_RingStallTicks	= 0;
+}
+
 void SysMtgsThread::PrepDataPacket( MTGS_RingCommand cmd, u32 size )
 {
 	m_packet_size = size;
@@ -18,6 +18,7 @@
 #include "MTVU.h"
 #include "newVif.h"
 #include "Gif_Unit.h"
+#include "System/SysWait.h"
 
 __aligned16 VU_Thread vu1Thread(CpuVU1, VU1);
 
@@ -80,6 +81,7 @@ void VU_Thread::Reset()
 	write_offset = 0;
 	vuCycleIdx   = 0;
 	isBusy = false;
+	isWaiting = false;
 	memzero(vif);
 	memzero(vifRegs);
 	memzero(vuCycles);
@@ -87,6 +89,8 @@ void VU_Thread::Reset()
 
 void VU_Thread::ExecuteTaskInThread()
 {
+	SysWait::SetAffinity("MTVU", EmuConfig.Threads.AffinityMTVU);
+
 	PCSX2_PAGEFAULT_PROTECT {
 		ExecuteRingBuffer();
 	} PCSX2_PAGEFAULT_EXCEPT;
@@ -95,58 +99,67 @@ void VU_Thread::ExecuteTaskInThread()
 void VU_Thread::ExecuteRingBuffer()
 {
 	for(;;) {
-		semaEvent.WaitWithoutYield();
+		// KickStart isn't called for every packet, spinning picks them up sooner (if enabled)
+		if (SysWait::Spin(EmuConfig.Threads.IdleSpinNs, [&]() { return read_pos != GetWritePos(); })) {
+			SysWait::Drain(semaEvent);
+		} else {
+			ScopedSysWait stall(SysWait_MtvuIdle);
+			semaEvent.WaitWithoutYield();
+		}
 		ScopedLockBool lock(mtxBusy, isBusy);
-		while (read_pos != GetWritePos()) {
-			u32 tag = Read();
-			switch (tag) {
-				case MTVU_VU_EXECUTE: {
-					vuRegs.cycle = 0;
-					s32 addr     = Read();
-					vifRegs.top  = Read();
-					vifRegs.itop = Read();
-					if (addr != -1) vuRegs.VI[REG_TPC].UL = addr;
-					vuCPU->Execute(vu1RunCycles);
-					gifUnit.gifPath[GIF_PATH_1].FinishGSPacketMTVU();
-					semaXGkick.Post(); // Tell MTGS a path1 packet is complete
-					AtomicExchange(vuCycles[vuCycleIdx], vuRegs.cycle);
-					vuCycleIdx  = (vuCycleIdx + 1) & 3;
-					break;
-				}
-				case MTVU_VU_WRITE_MICRO: {
-					u32 vu_micro_addr = Read();
-					u32 size = Read();
-					vuCPU->Clear(vu_micro_addr, size);
-					Read(&vuRegs.Micro[vu_micro_addr], size);
-					break;
+		do {
+			while (read_pos != GetWritePos()) {
+				u32 tag = Read();
+				switch (tag) {
+					case MTVU_VU_EXECUTE: {
+						vuRegs.cycle = 0;
+						s32 addr     = Read();
+						vifRegs.top  = Read();
+						vifRegs.itop = Read();
+						if (addr != -1) vuRegs.VI[REG_TPC].UL = addr;
+						vuCPU->Execute(vu1RunCycles);
+						gifUnit.gifPath[GIF_PATH_1].FinishGSPacketMTVU();
+						semaXGkick.Post(); // Tell MTGS a path1 packet is complete
+						AtomicExchange(vuCycles[vuCycleIdx], vuRegs.cycle);
+						vuCycleIdx  = (vuCycleIdx + 1) & 3;
+						break;
+					}
+					case MTVU_VU_WRITE_MICRO: {
+						u32 vu_micro_addr = Read();
+						u32 size = Read();
+						vuCPU->Clear(vu_micro_addr, size);
+						Read(&vuRegs.Micro[vu_micro_addr], size);
+						break;
+					}
+					case MTVU_VU_WRITE_DATA: {
+						u32 vu_data_addr = Read();
+						u32 size = Read();
+						Read(&vuRegs.Mem[vu_data_addr], size);
+						break;
+					}
+					case MTVU_VIF_WRITE_COL:
+						Read(&vif.MaskCol, sizeof(vif.MaskCol));
+						break;
+					case MTVU_VIF_WRITE_ROW:
+						Read(&vif.MaskRow, sizeof(vif.MaskRow));
+						break;
+					case MTVU_VIF_UNPACK: {
+						u32 vif_copy_size = (uptr)&vif.StructEnd - (uptr)&vif.tag;
+						Read(&vif.tag, vif_copy_size);
+						ReadRegs(&vifRegs);
+						u32 size = Read();
+						MTVU_Unpack(&buffer[read_pos], vifRegs);
+						incReadPos(size_u32(size));
+						break;
+					}
+					case MTVU_NULL_PACKET:
+						read_pos = 0;
+						break;
+					jNO_DEFAULT;
 				}
-				case MTVU_VU_WRITE_DATA: {
-					u32 vu_data_addr = Read();
-					u32 size = Read();
-					Read(&vuRegs.Mem[vu_data_addr], size);
-					break;
-				}
-				case MTVU_VIF_WRITE_COL:
-					Read(&vif.MaskCol, sizeof(vif.MaskCol));
-					break;
-				case MTVU_VIF_WRITE_ROW:
-					Read(&vif.MaskRow, sizeof(vif.MaskRow));
-					break;
-				case MTVU_VIF_UNPACK: {
-					u32 vif_copy_size = (uptr)&vif.StructEnd - (uptr)&vif.tag;
-					Read(&vif.tag, vif_copy_size);
-					ReadRegs(&vifRegs);
-					u32 size = Read();
-					MTVU_Unpack(&buffer[read_pos], vifRegs);
-					incReadPos(size_u32(size));
-					break;
-				}
-				case MTVU_NULL_PACKET:
-					read_pos = 0;
-					break;
-				jNO_DEFAULT;
 			}
-		}
+			// Nothing to do, compile the VU programs we expect to run next (one block at a time)
+		} while (read_pos == GetWritePos() && !isWaiting && vuCPU->Precompile());
 	}
 }
 
@@ -154,6 +167,16 @@ void VU_Thread::ExecuteRingBuffer()
 // Should only be called by ReserveSpace()
 __ri void VU_Thread::WaitOnSize(s32 size)
 {
+	auto hasRoom = [&]() {
+		s32 readPos = GetReadPos();
+		return readPos <= write_pos || readPos > write_pos + size;
+	};
+	if (hasRoom()) return;
+
+	ScopedSysWait stall(SysWait_MtvuRingFull);
+	KickStart();
+	if (SysWait::Spin(EmuConfig.Threads.WaitSpinNs, hasRoom)) return;
+
 	for(;;) {
 		s32 readPos  = GetReadPos();
 		if (readPos <= write_pos) break; // MTVU is reading in back of write_pos
@@ -283,6 +306,12 @@ bool VU_Thread::IsDone()
 void VU_Thread::WaitVU()
 {
 	MTVU_LOG("MTVU - WaitVU!");
+	isWaiting = true;
+	if (!IsDone()) {
+		ScopedSysWait stall(SysWait_MtvuSync);
+		KickStart();
+		SysWait::Spin(EmuConfig.Threads.WaitSpinNs, [&]() { return IsDone(); });
+	}
 	for(;;) {
 		if (IsDone()) break;
 		//DevCon.WriteLn("WaitVU()");
@@ -290,6 +319,7 @@ void VU_Thread::WaitVU()
 		KickStart();
 		ScopedLock lock(mtxBusy);
 	}
+	isWaiting = false;
 }
 
 void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
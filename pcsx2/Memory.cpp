@@ -44,6 +44,7 @@ BIOS
 
 #include "ps2/HwInternal.h"
 #include "ps2/BiosTools.h"
+#include "System/MemorySnapshot.h"
 
 #include "Utilities/PageFaultSource.h"
 
@@ -992,6 +993,7 @@ void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& h
 void mmap_ResetBlockTracking()
 {
 	//DbgCon.WriteLn( "vtlb/mmap: Block Tracking reset..." );
+	MemorySnapshot::Finish();		// would lose its write protection otherwise
 	memzero( m_PageProtectInfo );
 	if (eeMem) HostSys::MemProtect( eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite() );
 }
@@ -50,6 +50,9 @@ AsyncFileReader* MultipartFileReader::DetectMultipart(AsyncFileReader* reader)
 MultipartFileReader::MultipartFileReader(AsyncFileReader* firstPart)
 {
 	memset(m_parts,0,sizeof(m_parts));
+	memset(m_pending,0,sizeof(m_pending));
+	m_pending_head = 0;
+	m_pending_count = 0;
 
 	m_filename = firstPart->GetFilename();
 
@@ -163,14 +166,17 @@ int MultipartFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 
 void MultipartFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 {
+	pxAssertDev(m_pending_count < MaxQueueDepth, "MultipartFileReader: too many reads in flight");
+
 	u8* lBuffer = (u8*)pBuffer;
+	u8 parts = 0;
 
 	for(uint i = GetFirstPart(sector); i < m_numparts; i++)
 	{
 		uint num = std::min(count, m_parts[i].end - sector);
 
 		m_parts[i].reader->BeginRead(lBuffer, sector - m_parts[i].start, num);
-		m_parts[i].isReading = true;
+		parts |= 1 << i;
 
 		lBuffer += num * m_blocksize;
 		sector += num;
@@ -179,20 +185,33 @@ void MultipartFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 		if(count <= 0)
 			break;
 	}
+
+	m_pending[(m_pending_head + m_pending_count) % MaxQueueDepth] = parts;
+	m_pending_count++;
 }
 
 int MultipartFileReader::FinishRead(void)
 {
+	if(!m_pending_count)
+		return -1;
+
+	// Each part completes its own reads in order, so the oldest read of every
+	// part it touched is the one we're finishing.
+	u8 parts = m_pending[m_pending_head];
+	m_pending_head = (m_pending_head + 1) % MaxQueueDepth;
+	m_pending_count--;
+
 	int ret = 0;
 	for(uint i=0;i<m_numparts;i++)
 	{
-		if(m_parts[i].isReading)
+		if(parts & (1 << i))
 		{
-			ret = std::min(ret, m_parts[i].reader->FinishRead());
-			m_parts[i].isReading = false;
+			int bytes = m_parts[i].reader->FinishRead();
 
-			if(ret < 0)
+			if(bytes < 0 || ret < 0)
 				ret = -1;
+			else
+				ret += bytes;
 		}
 	}
 
@@ -201,14 +220,27 @@ int MultipartFileReader::FinishRead(void)
 
 void MultipartFileReader::CancelRead(void)
 {
+	u8 parts = 0;
+	for(uint i=0;i<m_pending_count;i++)
+		parts |= m_pending[(m_pending_head + i) % MaxQueueDepth];
+
 	for(uint i=0;i<m_numparts;i++)
 	{
-		if(m_parts[i].isReading)
-		{
+		if(parts & (1 << i))
 			m_parts[i].reader->CancelRead();
-			m_parts[i].isReading = false;
-		}
 	}
+
+	m_pending_head = 0;
+	m_pending_count = 0;
+}
+
+uint MultipartFileReader::GetQueueDepth(void) const
+{
+	uint depth = MaxQueueDepth;
+	for(uint i=0;i<m_numparts;i++)
+		depth = std::min(depth, m_parts[i].reader->GetQueueDepth());
+
+	return depth;
 }
 
 void MultipartFileReader::Close(void)
@@ -75,6 +75,7 @@ void Pcsx2Config::ProfilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( RecBlocks_IOP );
 	IniBitBool( RecBlocks_VU0 );
 	IniBitBool( RecBlocks_VU1 );
+	IniBitBool( EventCounts );
 }
 
 Pcsx2Config::RecompilerOptions::RecompilerOptions()
@@ -94,6 +95,7 @@ Pcsx2Config::RecompilerOptions::RecompilerOptions()
 
 	UseMicroVU0	= true;
 	UseMicroVU1	= true;
+	MicroVUPrecompile = true;
 
 	// vu and fpu clamping default to standard overflow.
 	vuOverflow	= true;
@@ -151,6 +153,7 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 
 	IniBitBool( UseMicroVU0 );
 	IniBitBool( UseMicroVU1 );
+	IniBitBool( MicroVUPrecompile );
 
 	IniBitBool( vuOverflow );
 	IniBitBool( vuExtraOverflow );
@@ -164,6 +167,11 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( StackFrameChecks );
 	IniBitBool( PreBlockCheckEE );
 	IniBitBool( PreBlockCheckIOP );
+
+	IniBitBool( BlockProfilerEE );
+	IniBitBool( BlockProfilerIOP );
+	IniBitBool( BlockProfilerTicks );
+	IniBitBool( PerfMap );
 }
 
 Pcsx2Config::CpuOptions::CpuOptions()
@@ -205,6 +213,8 @@ Pcsx2Config::GSOptions::GSOptions()
 	SynchronousMTGS			= false;
 	DisableOutput			= false;
 	VsyncQueueSize			= 2;
+	RingBufferSizeFactor	= 19;
+	FramePacingStatsFrames	= 0;
 
 	DefaultRegionMode		= Region_NTSC;
 	FramesToDraw			= 2;
@@ -222,6 +232,8 @@ void Pcsx2Config::GSOptions::LoadSave( IniInterface& ini )
 	IniEntry( SynchronousMTGS );
 	IniEntry( DisableOutput );
 	IniEntry( VsyncQueueSize );
+	IniEntry( RingBufferSizeFactor );
+	IniEntry( FramePacingStatsFrames );
 
 	IniEntry( FrameLimitEnable );
 	IniEntry( FrameSkipEnable );
@@ -239,6 +251,32 @@ void Pcsx2Config::GSOptions::LoadSave( IniInterface& ini )
 	IniEntry( FramesToSkip );
 }
 
+Pcsx2Config::ThreadOptions::ThreadOptions()
+{
+	WaitSpinNs			= 20000;
+	IdleSpinNs			= 0;
+
+	AffinityEE			= -1;
+	AffinityMTGS		= -1;
+	AffinityMTVU		= -1;
+
+	StallStatsFrames	= 0;
+}
+
+void Pcsx2Config::ThreadOptions::LoadSave( IniInterface& ini )
+{
+	ScopedIniGroup path( ini, L"Threads" );
+
+	IniEntry( WaitSpinNs );
+	IniEntry( IdleSpinNs );
+
+	IniEntry( AffinityEE );
+	IniEntry( AffinityMTGS );
+	IniEntry( AffinityMTVU );
+
+	IniEntry( StallStatsFrames );
+}
+
 const wxChar *const tbl_GamefixNames[] =
 {
 	L"VuAddSub",
@@ -407,6 +445,9 @@ Pcsx2Config::Pcsx2Config()
 	McdFolderAutoManage = true;
 	EnablePatches = true;
 	BackupSavestate = true;
+	SavestateZlibLevel = 1;
+	RewindInterval = 0;
+	RewindBudget = 256;
 }
 
 void Pcsx2Config::LoadSave( IniInterface& ini )
@@ -423,16 +464,22 @@ void Pcsx2Config::LoadSave( IniInterface& ini )
 	IniBitBool( HostFs );
 
 	IniBitBool( BackupSavestate );
+	IniBitBool( SavestateSnapshots );
 	IniBitBool( McdEnableEjection );
 	IniBitBool( McdFolderAutoManage );
 	IniBitBool( MultitapPort0_Enabled );
 	IniBitBool( MultitapPort1_Enabled );
 
+	IniEntry( SavestateZlibLevel );
+	IniEntry( RewindInterval );
+	IniEntry( RewindBudget );
+
 	// Process various sub-components:
 
 	Speedhacks		.LoadSave( ini );
 	Cpu				.LoadSave( ini );
 	GS				.LoadSave( ini );
+	Threads			.LoadSave( ini );
 	Gamefixes		.LoadSave( ini );
 	Profiler		.LoadSave( ini );
 
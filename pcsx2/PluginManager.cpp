@@ -1589,8 +1589,9 @@ void SysCorePlugins::Freeze( PluginsEnum_t pid, SaveStateBase& state )
 	int fsize = fP.size;
 	state.Freeze( fsize );
 
-	Console.Indent().WriteLn( "%s %s", state.IsSaving() ? "Saving" : "Loading",
-		tbl_PluginInfo[pid].shortname );
+	if( !state.IsQuiet() )
+		Console.Indent().WriteLn( "%s %s", state.IsSaving() ? "Saving" : "Loading",
+			tbl_PluginInfo[pid].shortname );
 
 	if( state.IsLoading() && (fsize == 0) )
 	{
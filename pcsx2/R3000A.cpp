@@ -19,6 +19,7 @@
 
 #include "Sio.h"
 #include "Sif.h"
+#include "EventQueue.h"
 
 using namespace R3000A;
 
@@ -61,6 +62,7 @@ void psxReset()
 	iopBreak = 0;
 	iopCycleEE = -1;
 	g_iopNextEventCycle = psxRegs.cycle + 4;
+	psxResetEventQueue();
 
 	psxHwReset();
 
@@ -130,6 +132,56 @@ __fi int psxTestCycle( u32 startCycle, s32 delta )
 	return (int)(psxRegs.cycle - startCycle) >= delta;
 }
 
+struct IopEventHandler
+{
+	IopEventId		id;
+	const char*		name;
+	void			(*callback)();
+};
+
+// The events run by _psxTestInterrupts(), in the order they're run when several are due at once.
+static const IopEventHandler iopEventHandlers[] =
+{
+	{ IopEvt_SIF0,		"SIF0",			sif0Interrupt },
+	{ IopEvt_SIF1,		"SIF1",			sif1Interrupt },
+	{ IopEvt_SIF2,		"SIF2",			sif2Interrupt },
+#ifndef SIO_INLINE_IRQS
+	{ IopEvt_SIO,		"SIO",			sioInterrupt },
+#endif
+	{ IopEvt_CdvdRead,	"CdvdRead",		cdvdReadInterrupt },
+	{ IopEvt_Cdvd,		"Cdvd",			cdvdActionInterrupt },
+	{ IopEvt_Dma11,		"SIO2in",		psxDMA11Interrupt },
+	{ IopEvt_Dma12,		"SIO2out",		psxDMA12Interrupt },
+	{ IopEvt_Cdrom,		"Cdrom",		cdrInterrupt },
+	{ IopEvt_CdromRead,	"CdromRead",	cdrReadInterrupt },
+	{ IopEvt_DEV9,		"DEV9",			dev9Interrupt },
+	{ IopEvt_USB,		"USB",			usbInterrupt },
+};
+
+static u32 iopEventMask()
+{
+	u32 mask = 0;
+	for (uint i = 0; i < ArraySize(iopEventHandlers); i++) mask |= 1 << iopEventHandlers[i].id;
+	return mask;
+}
+
+static EventQueue iopEvents( iopEventMask() );
+
+void psxResetEventQueue()
+{
+	iopEvents.Clear();
+}
+
+// Prints the number of events per frame (if enabled in the [Profiler] ini section).
+void psxEventStatsFrameDone()
+{
+	if (!EmuConfig.Profiler.Enabled || !EmuConfig.Profiler.EventCounts) return;
+
+	static const char* names[32];
+	for (uint i = 0; i < ArraySize(iopEventHandlers); i++) names[iopEventHandlers[i].id] = iopEventHandlers[i].name;
+	iopEvents.FrameDone( "IOP", names, 60 );
+}
+
 __fi void PSX_INT( IopEventId n, s32 ecycle )
 {
 	// 19 is CDVD read int, it's supposed to be high.
@@ -140,6 +192,7 @@ __fi void PSX_INT( IopEventId n, s32 ecycle )
 
 	psxRegs.sCycle[n] = psxRegs.cycle;
 	psxRegs.eCycle[n] = ecycle;
+	iopEvents.Schedule( n, psxRegs.sCycle[n], psxRegs.eCycle[n] );
 
 	psxSetNextBranchDelta( ecycle );
 
@@ -153,43 +206,28 @@ __fi void PSX_INT( IopEventId n, s32 ecycle )
 	}
 }
 
-static __fi void IopTestEvent( IopEventId n, void (*callback)() )
+static __fi void _psxTestInterrupts()
 {
-	if( !(psxRegs.interrupt & (1 << n)) ) return;
+	u32 due = iopEvents.PopDue( psxRegs.cycle, psxRegs.interrupt, psxRegs.sCycle, psxRegs.eCycle );
 
-	if( psxTestCycle( psxRegs.sCycle[n], psxRegs.eCycle[n] ) )
+	for (uint i = 0; due && i < ArraySize(iopEventHandlers); i++)
 	{
-		psxRegs.interrupt &= ~(1 << n);
-		callback();
-	}
-	else
-		psxSetNextBranch( psxRegs.sCycle[n], psxRegs.eCycle[n] );
-}
-
-static __fi void _psxTestInterrupts()
-{
-	IopTestEvent(IopEvt_SIF0,		sif0Interrupt);	// SIF0
-	IopTestEvent(IopEvt_SIF1,		sif1Interrupt);	// SIF1
-	IopTestEvent(IopEvt_SIF2,		sif2Interrupt);	// SIF2
-#ifndef SIO_INLINE_IRQS
-	IopTestEvent(IopEvt_SIO,		sioInterrupt);
-#endif
-	IopTestEvent(IopEvt_CdvdRead,	cdvdReadInterrupt);
+		const uint n = iopEventHandlers[i].id;
+		if (!(due & (1 << n))) continue;
+		due &= ~(1 << n);
 
-	// Profile-guided Optimization (sorta)
-	// The following ints are rarely called.  Encasing them in a conditional
-	// as follows helps speed up most games.
+		// An earlier handler may have cancelled or moved it
+		if (!(psxRegs.interrupt & (1 << n))) continue;
+		if (!psxTestCycle( psxRegs.sCycle[n], psxRegs.eCycle[n] )) continue;
 
-	if( psxRegs.interrupt & ( (1ul<<5) | (3ul<<11) | (3ul<<20) | (3ul<<17) ) )
-	{
-		IopTestEvent(IopEvt_Cdvd,		cdvdActionInterrupt);
-		IopTestEvent(IopEvt_Dma11,		psxDMA11Interrupt);	// SIO2
-		IopTestEvent(IopEvt_Dma12,		psxDMA12Interrupt);	// SIO2
-		IopTestEvent(IopEvt_Cdrom,		cdrInterrupt);
-		IopTestEvent(IopEvt_CdromRead,	cdrReadInterrupt);
-		IopTestEvent(IopEvt_DEV9,		dev9Interrupt);
-		IopTestEvent(IopEvt_USB,		usbInterrupt);
+		psxRegs.interrupt &= ~(1 << n);
+		iopEvents.CountFired( n );
+		iopEventHandlers[i].callback();
 	}
+
+	u32 next;
+	if (iopEvents.Next( next, psxRegs.interrupt, psxRegs.sCycle, psxRegs.eCycle ))
+		psxSetNextBranch( next, 0 );
 }
 
 __ri void iopEventTest()
@@ -33,6 +33,7 @@
 #include "CDVD/CDVD.h"
 #include "Patch.h"
 #include "GameDatabase.h"
+#include "EventQueue.h"
 
 #include "../DebugTools/Breakpoints.h"
 #include "R5900OpcodeTables.h"
@@ -76,6 +77,7 @@ void cpuReset()
 	fpuRegs.fprc[31]		= 0x01000001; // fpu Status/Control
 
 	g_nextEventCycle = cpuRegs.cycle + 4;
+	cpuResetEventQueue();
 	EEsCycle = 0;
 	EEoCycle = cpuRegs.cycle;
 
@@ -248,17 +250,53 @@ __fi void cpuClearInt( uint i )
 	cpuRegs.interrupt &= ~(1 << i);
 }
 
-static __fi void TESTINT( u8 n, void (*callback)() )
+struct EE_EventHandler
 {
-	if( !(cpuRegs.interrupt & (1 << n)) ) return;
+	EE_EventType	id;
+	const char*		name;
+	void			(*callback)();
+};
 
-	if( cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] ) )
-	{
-		cpuClearInt( n );
-		callback();
-	}
-	else
-		cpuSetNextEvent( cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
+// The events run by _cpuTestInterrupts(), in the order they're run when several are due at once.
+static const EE_EventHandler eeEventHandlers[] =
+{
+	{ DMAC_VIF1,		"VIF1",			vif1Interrupt },
+	{ DMAC_GIF,			"GIF",			gifInterrupt },
+	{ DMAC_SIF0,		"SIF0",			EEsif0Interrupt },
+	{ DMAC_SIF1,		"SIF1",			EEsif1Interrupt },
+	{ DMAC_VIF0,		"VIF0",			vif0Interrupt },
+	{ DMAC_FROM_IPU,	"fromIPU",		ipu0Interrupt },
+	{ DMAC_TO_IPU,		"toIPU",		ipu1Interrupt },
+	{ DMAC_FROM_SPR,	"fromSPR",		SPRFROMinterrupt },
+	{ DMAC_TO_SPR,		"toSPR",		SPRTOinterrupt },
+	{ DMAC_MFIFO_VIF,	"MFIFO-VIF",	vifMFIFOInterrupt },
+	{ DMAC_MFIFO_GIF,	"MFIFO-GIF",	gifMFIFOInterrupt },
+	{ VIF_VU0_FINISH,	"VU0finish",	vif0VUFinish },
+	{ VIF_VU1_FINISH,	"VU1finish",	vif1VUFinish },
+};
+
+static u32 eeEventMask()
+{
+	u32 mask = 0;
+	for (uint i = 0; i < ArraySize(eeEventHandlers); i++) mask |= 1 << eeEventHandlers[i].id;
+	return mask;
+}
+
+static EventQueue eeEvents( eeEventMask() );
+
+void cpuResetEventQueue()
+{
+	eeEvents.Clear();
+}
+
+// Prints the number of events per frame (if enabled in the [Profiler] ini section).
+void cpuEventStatsFrameDone()
+{
+	if (!EmuConfig.Profiler.Enabled || !EmuConfig.Profiler.EventCounts) return;
+
+	static const char* names[32];
+	for (uint i = 0; i < ArraySize(eeEventHandlers); i++) names[eeEventHandlers[i].id] = eeEventHandlers[i].name;
+	eeEvents.FrameDone( "EE", names, 60 );
 }
 
 // [TODO] move this function to LegacyDmac.cpp, and remove most of the DMAC-related headers from
@@ -273,31 +311,26 @@ static __fi void _cpuTestInterrupts()
 	/* These are 'pcsx2 interrupts', they handle asynchronous stuff
 	   that depends on the cycle timings */
 
-	TESTINT(DMAC_VIF1,		vif1Interrupt);	
-	TESTINT(DMAC_GIF,		gifInterrupt);
-	TESTINT(DMAC_SIF0,		EEsif0Interrupt);
-	TESTINT(DMAC_SIF1,		EEsif1Interrupt);
-	
-	// Profile-guided Optimization (sorta)
-	// The following ints are rarely called.  Encasing them in a conditional
-	// as follows helps speed up most games.
+	u32 due = eeEvents.PopDue( cpuRegs.cycle, cpuRegs.interrupt, cpuRegs.sCycle, cpuRegs.eCycle );
 
-	if( cpuRegs.interrupt & 0x60F19 ) // Bits 0 3 4 8 9 10 11 17 18( 1100000111100011001 )
+	for (uint i = 0; due && i < ArraySize(eeEventHandlers); i++)
 	{
-		TESTINT(DMAC_VIF0,		vif0Interrupt);
+		const uint n = eeEventHandlers[i].id;
+		if (!(due & (1 << n))) continue;
+		due &= ~(1 << n);
 
-		TESTINT(DMAC_FROM_IPU,	ipu0Interrupt);
-		TESTINT(DMAC_TO_IPU,	ipu1Interrupt);
+		// An earlier handler may have cancelled or moved it
+		if (!(cpuRegs.interrupt & (1 << n))) continue;
+		if (!cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] )) continue;
 
-		TESTINT(DMAC_FROM_SPR,	SPRFROMinterrupt);
-		TESTINT(DMAC_TO_SPR,	SPRTOinterrupt);
-
-		TESTINT(DMAC_MFIFO_VIF, vifMFIFOInterrupt);
-		TESTINT(DMAC_MFIFO_GIF, gifMFIFOInterrupt);
-
-		TESTINT(VIF_VU0_FINISH, vif0VUFinish);
-		TESTINT(VIF_VU1_FINISH, vif1VUFinish);
+		cpuClearInt( n );
+		eeEvents.CountFired( n );
+		eeEventHandlers[i].callback();
 	}
+
+	u32 next;
+	if (eeEvents.Next( next, cpuRegs.interrupt, cpuRegs.sCycle, cpuRegs.eCycle ))
+		cpuSetNextEvent( next, 0 );
 }
 
 static __fi void _cpuTestTIMR()
@@ -495,6 +528,7 @@ __fi void CPU_INT( EE_EventType n, s32 ecycle)
 	cpuRegs.interrupt|= 1 << n;
 	cpuRegs.sCycle[n] = cpuRegs.cycle;
 	cpuRegs.eCycle[n] = ecycle;
+	eeEvents.Schedule( n, cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
 
 	// Interrupt is happening soon: make sure both EE and IOP are aware.
 
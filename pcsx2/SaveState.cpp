@@ -45,6 +45,10 @@ static void PostLoadPrep()
 	for(int i=0; i<48; i++) MapTLB(i);
 	if (EmuConfig.Gamefixes.GoemonTlbHack) GoemonPreloadTlb();
 
+	// The event queues are rebuilt from the loaded interrupt/cycle registers
+	cpuResetEventQueue();
+	psxResetEventQueue();
+
 	UpdateVSyncRate();
 }
 
@@ -79,6 +83,7 @@ void SaveStateBase::Init( SafeArray<u8>* memblock )
 	m_version	= g_SaveVersion;
 	m_idx		= 0;
 	m_DidBios	= false;
+	m_quiet		= false;
 }
 
 void SaveStateBase::PrepBlock( int size )
@@ -178,7 +183,7 @@ SaveStateBase& SaveStateBase::FreezeInternals()
 {
 	vu1Thread.WaitVU(); // Finish VU1 just in-case...
 	// Print this until the MTVU problem in gifPathFreeze is taken care of (rama)
-	if (THREAD_VU1) Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
+	if (THREAD_VU1 && !IsQuiet()) Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
 	
 	if (IsLoading()) PreLoadPrep();
 
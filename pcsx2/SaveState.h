@@ -106,6 +106,7 @@ protected:
 	int m_idx;			// current read/write index of the allocation
 
 	bool m_DidBios;
+	bool m_quiet;		// no "Saving <plugin>" (and similar) console messages
 
 public:
 	SaveStateBase( VmStateBuffer& memblock );
@@ -178,6 +179,10 @@ public:
 	// Returns true if this object is a StateLoading type object.
 	bool IsLoading() const { return !IsSaving(); }
 
+	// Quiet states don't log their progress, for the periodic internal ones (rewind).
+	void SetQuiet( bool quiet ) { m_quiet = quiet; }
+	bool IsQuiet() const { return m_quiet; }
+
 	// Loads or saves a memory block.
 	virtual void FreezeMem( void* data, int size )=0;
 
@@ -25,6 +25,8 @@
 #include "Elfheader.h"
 
 #include "System/RecTypes.h"
+#include "System/MemorySnapshot.h"
+#include "System/RewindBuffer.h"
 
 #include "Utilities/MemsetFast.inl"
 #include "Utilities/Perf.h"
@@ -423,6 +425,8 @@ void SysMainMemory::CommitAll()
 void SysMainMemory::ResetAll()
 {
 	CommitAll();
+	MemorySnapshot::Finish();
+	Rewind::Clear();
 
 	DevCon.WriteLn( Color_StrongBlue, "Resetting host memory for virtual systems..." );
 	ConsoleIndentScope indent(1);
@@ -447,6 +451,9 @@ void SysMainMemory::DecommitAll()
 	// to the ring. Let's call it an extra safety valve :)
 	vu1Thread.Reset();
 
+	MemorySnapshot::Finish();
+	Rewind::Clear();
+
 	m_ee.Decommit();
 	m_iop.Decommit();
 	m_vu.Decommit();
@@ -612,6 +619,9 @@ BaseVUmicroCPU* SysCpuProviderPack::getVUprovider(int whichProvider, int vuIndex
 // Use this method to reset the recs when important global pointers like the MTGS are re-assigned.
 void SysClearExecutionCache()
 {
+	// The guest memory is about to be loaded or reset
+	MemorySnapshot::Finish();
+
 	GetCpuProviders().ApplyConfig();
 
 	Cpu->Reset();
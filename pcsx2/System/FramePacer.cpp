@@ -0,0 +1,181 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "FramePacer.h"
+
+#include <cmath>
+
+#ifdef __linux__
+#	include <time.h>
+#	include <errno.h>
+#endif
+
+// Spin tail bounds, the tail is the recent sleep lateness plus SpinMinNs.
+static const s64 SpinMinNs = 50 * 1000;
+static const s64 SpinMaxNs = 2 * 1000 * 1000;
+
+// Histogram of the frame intervals, in 50us buckets up to 100ms (the last one is open ended).
+static const s64 BucketNs = 50 * 1000;
+static const int Buckets  = 2000;
+
+static u64 s_deadline	= 0;	// end of the current frame, 0 after a reset
+static u64 s_last		= 0;	// when the previous frame ended
+static s64 s_oversleep	= 0;	// how late the sleeps have been waking up lately
+static s64 s_period		= 0;	// ns
+
+static u32 s_hist[Buckets];
+static u32 s_frames		= 0;
+static u64 s_sum		= 0;	// ns, for the mean
+static u64 s_max		= 0;
+static u32 s_late		= 0;	// frames which took 1.5 periods or more
+static int s_statFrames	= 0;
+
+static u64 Now()
+{
+#ifdef __linux__
+	// Same clock as the absolute clock_nanosleep below
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#else
+	return (u64)((double)GetCPUTicks() * 1e9 / (double)GetTickFrequency());
+#endif
+}
+
+// Sleeps until shortly before the deadline and spins the rest of the way.
+static u64 WaitUntil(u64 deadline)
+{
+	u64 now    = Now();
+	s64 margin = std::min(s_oversleep + SpinMinNs, SpinMaxNs);
+
+	if ((s64)(deadline - now) > margin)
+	{
+		u64 wake = deadline - margin;
+#ifdef __linux__
+		timespec ts;
+		ts.tv_sec  = wake / 1000000000ull;
+		ts.tv_nsec = wake % 1000000000ull;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+#else
+		// The scheduler runs at 1ms here (see EnableHiresScheduler)
+		int msec = (int)((wake - now) / 1000000);
+		if (msec > 0) Threading::Sleep(msec);
+#endif
+		now = Now();
+
+		// Rises at once on a late wakeup, decays slowly
+		s64 late = (s64)(now - wake);
+		if (late > s_oversleep) s_oversleep = late;
+		else s_oversleep -= (s_oversleep - std::max<s64>(late, 0)) / 16;
+	}
+
+	while ((s64)(deadline - now) > 0)
+	{
+		Threading::SpinWait();
+		now = Now();
+	}
+	return now;
+}
+
+static void Record(u64 interval)
+{
+	s_hist[std::min<u64>(interval / BucketNs, Buckets - 1)]++;
+	s_frames++;
+	s_sum += interval;
+	if (interval > s_max) s_max = interval;
+	if (s_period && interval * 2 >= (u64)s_period * 3) s_late++;
+}
+
+static double Percentile(u32 pct10) // in tenths of percent
+{
+	u64 seen = 0;
+	for (int i = 0; i < Buckets; i++)
+	{
+		seen += s_hist[i];
+		if (seen * 1000 >= (u64)s_frames * pct10) return (i + 1) * BucketNs / 1e6;
+	}
+	return s_max / 1e6;
+}
+
+void FramePacer::Reset()
+{
+	s_deadline = 0;
+	s_last     = 0;
+}
+
+void FramePacer::PrintStats()
+{
+	if (!s_frames) return;
+
+	// Spread of the intervals around the mean, from the bucket centers
+	double mean = (double)s_sum / s_frames / 1e6;
+	double var  = 0;
+	for (int i = 0; i < Buckets; i++)
+	{
+		if (!s_hist[i]) continue;
+		double d = (i + 0.5) * BucketNs / 1e6 - mean;
+		var += d * d * s_hist[i];
+	}
+
+	Console.WriteLn(Color_Gray, "Frame pacing: %u frames, target %.3f ms, mean %.3f ms, stddev %.3f ms, p50 <%.2f p99 <%.2f p99.9 <%.2f max %.2f ms, %u late, spin tail %.0f us",
+		s_frames, s_period / 1e6, mean, std::sqrt(var / s_frames),
+		Percentile(500), Percentile(990), Percentile(999), s_max / 1e6,
+		s_late, std::min(s_oversleep + SpinMinNs, SpinMaxNs) / 1e3);
+
+	memzero(s_hist);
+	s_frames = 0;
+	s_sum    = 0;
+	s_max    = 0;
+	s_late   = 0;
+}
+
+void FramePacer::FrameDone(bool limit, s64 periodTicks)
+{
+	s_period = (s64)((double)periodTicks * 1e9 / (double)GetTickFrequency());
+
+	u64 now = Now();
+
+	if (limit)
+	{
+		// First frame after a reset: it starts the schedule, there's nothing to wait for.
+		if (!s_deadline)
+			s_deadline = now;
+		else
+		{
+			s_deadline += s_period;
+
+			// If the framerate drops too low, restart from now.  This avoids excessive amounts
+			// of "fast forward" syndrome which would occur if we tried to catch up too much.
+			// Otherwise the next deadline follows this one, which catches up after slow frames.
+			if ((s64)(now - s_deadline) > s_period * 8)
+				s_deadline = now;
+			else
+				now = WaitUntil(s_deadline);
+		}
+	}
+	else s_deadline = 0;
+
+	if (s_last) Record(now - s_last);
+	s_last = now;
+
+	const int frames = EmuConfig.GS.FramePacingStatsFrames;
+	if (frames > 0 && ++s_statFrames >= frames)
+	{
+		s_statFrames = 0;
+		PrintStats();
+	}
+}
@@ -0,0 +1,42 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  FramePacer - frame limiter waits and frame interval statistics
+// --------------------------------------------------------------------------------------
+// Frames are paced against absolute deadlines (each one is the previous deadline plus the
+// frame period), so the sleep errors don't accumulate.  The thread sleeps until shortly
+// before the deadline (clock_nanosleep on Linux) and spins the rest of the way.  The spin
+// tail follows how late the sleeps have been waking up recently.
+//
+// Every frame interval is recorded in a histogram.  PrintStats() logs it, and it's logged
+// every EmuConfig.GS.FramePacingStatsFrames frames when that's set.
+//
+// Only used by the EE thread.
+
+namespace FramePacer
+{
+	// Forgets the previous deadline, the next frame starts now.
+	extern void Reset();
+
+	// Called once per frame.  Waits for the end of the frame when limit is set, the period
+	// is in GetCPUTicks() units.
+	extern void FrameDone(bool limit, s64 periodTicks);
+
+	// Logs the frame interval histogram since the last print (and restarts it).
+	extern void PrintStats();
+}
@@ -0,0 +1,252 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "MemorySnapshot.h"
+
+#include "Utilities/PageFaultSource.h"
+
+#include <atomic>
+#include <memory>
+
+// State of each page of a snapshot region
+enum SnapshotPageState
+{
+	Page_Pending = 0,	// protected, not copied yet
+	Page_Copying,		// being copied by the background thread
+	Page_Copied,		// protected, in the snapshot
+	Page_Released		// writable again (or back to the recompiler's protection)
+};
+
+static const uint EePages	= Ps2MemSize::MainRam >> 12;
+static const uint IopPages	= Ps2MemSize::IopRam >> 12;
+
+struct SnapshotRegion
+{
+	u8*		mem;
+	u8*		copy;
+	uint	pages;
+	bool	ee;			// pages may also be protected by the EE recompiler
+	std::atomic<u8>* state;
+};
+
+static std::atomic<u8>	s_eeState[EePages];
+static std::atomic<u8>	s_iopState[IopPages];
+static SnapshotRegion	s_regions[2];
+
+static std::atomic<bool> s_active( false );		// pages may still be protected for the snapshot
+static std::atomic<bool> s_copied( false );		// every page is in the snapshot
+
+static void CopyPage( SnapshotRegion& region, uint page )
+{
+	memcpy( region.copy + page * __pagesize, region.mem + page * __pagesize, __pagesize );
+}
+
+// Gives the page back to the VM.  EE pages with counted recompiler blocks stay read-only,
+// so the next write still goes through the block tracking.  Returns false in that case.
+static bool ReleasePage( SnapshotRegion& region, uint page )
+{
+	region.state[page].store( Page_Released, std::memory_order_relaxed );
+
+	if (region.ee && mmap_GetRamPageInfo( page << 12 ) == ProtMode_Write)
+		return false;
+
+	HostSys::MemProtect( region.mem + page * __pagesize, __pagesize, PageAccess_ReadWrite() );
+	return true;
+}
+
+// --------------------------------------------------------------------------------------
+//  SnapshotCopyThread
+// --------------------------------------------------------------------------------------
+class SnapshotCopyThread : public pxThread
+{
+	typedef pxThread _parent;
+
+public:
+	SnapshotCopyThread()
+	{
+		m_name = L"Memory Snapshot";
+	}
+
+	virtual ~SnapshotCopyThread() throw()
+	{
+		try {
+			_parent::Cancel();
+		}
+		DESTRUCTOR_CATCHALL
+	}
+
+protected:
+	void ExecuteTaskInThread()
+	{
+		for (SnapshotRegion& region : s_regions)
+		{
+			for (uint page = 0; page < region.pages; page++)
+			{
+				u8 expected = Page_Pending;
+				if (!region.state[page].compare_exchange_strong( expected, Page_Copying, std::memory_order_acquire ))
+					continue;	// already copied by the fault handler
+
+				CopyPage( region, page );
+				region.state[page].store( Page_Copied, std::memory_order_release );
+			}
+		}
+
+		s_copied = true;
+	}
+};
+
+static std::unique_ptr<SnapshotCopyThread> s_thread;
+
+// --------------------------------------------------------------------------------------
+//  SnapshotPageFaultHandler
+// --------------------------------------------------------------------------------------
+// Listeners are dispatched newest first, so this one (created on the first snapshot) runs
+// before mmap's handler, which is created with the EE memory.
+class SnapshotPageFaultHandler : public EventListener_PageFault
+{
+public:
+	void OnPageFaultEvent( const PageFaultInfo& info, bool& handled );
+};
+
+static std::unique_ptr<SnapshotPageFaultHandler> s_faultHandler;
+
+void SnapshotPageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& handled )
+{
+	if (!s_active) return;
+
+	for (SnapshotRegion& region : s_regions)
+	{
+		uptr offset = info.addr - (uptr)region.mem;
+		if (offset >= region.pages * __pagesize) continue;
+
+		const uint page = offset / __pagesize;
+		u8 state = Page_Pending;
+
+		if (region.state[page].compare_exchange_strong( state, Page_Copying, std::memory_order_acquire ))
+		{
+			CopyPage( region, page );
+			state = Page_Copied;
+		}
+		else if (state == Page_Released)
+			return;		// not ours anymore
+		else
+		{
+			// The copy thread is on it, it's only a page.
+			while ((state = region.state[page].load( std::memory_order_acquire )) == Page_Copying)
+				Threading::SpinWait();
+		}
+
+		handled = ReleasePage( region, page );
+		return;
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  MemorySnapshot  (implementations)
+// --------------------------------------------------------------------------------------
+void MemorySnapshot::Begin( u8* eeDest, u8* iopDest )
+{
+	Finish();
+
+	if (!s_faultHandler)
+	{
+		pxAssert( Source_PageFault );
+		s_faultHandler.reset( new SnapshotPageFaultHandler() );
+	}
+
+	s_regions[0].mem	= eeMem->Main;
+	s_regions[0].copy	= eeDest;
+	s_regions[0].pages	= EePages;
+	s_regions[0].ee		= true;
+	s_regions[0].state	= s_eeState;
+
+	s_regions[1].mem	= iopMem->Main;
+	s_regions[1].copy	= iopDest;
+	s_regions[1].pages	= IopPages;
+	s_regions[1].ee		= false;
+	s_regions[1].state	= s_iopState;
+
+	for (SnapshotRegion& region : s_regions)
+	{
+		for (uint page = 0; page < region.pages; page++)
+			region.state[page].store( Page_Pending, std::memory_order_relaxed );
+
+		HostSys::MemProtect( region.mem, region.pages * __pagesize, PageAccess_ReadOnly() );
+	}
+
+	s_copied = false;
+	s_active = true;
+
+	s_thread.reset( new SnapshotCopyThread() );
+	s_thread->Start();
+}
+
+void MemorySnapshot::WaitCopy()
+{
+	if (s_thread) s_thread->Block();
+}
+
+void MemorySnapshot::Poll()
+{
+	if (!s_active || !s_copied) return;
+
+	// The fault handler may run on another thread meanwhile
+	Threading::ScopedLock lock( PageFault_Mutex );
+
+	for (SnapshotRegion& region : s_regions)
+	{
+		// Consecutive pages are given back with a single call
+		uint first = 0, count = 0;
+
+		for (uint page = 0; page <= region.pages; page++)
+		{
+			bool release = false;
+
+			if (page < region.pages && region.state[page].load( std::memory_order_relaxed ) == Page_Copied)
+			{
+				region.state[page].store( Page_Released, std::memory_order_relaxed );
+				release = !(region.ee && mmap_GetRamPageInfo( page << 12 ) == ProtMode_Write);
+			}
+
+			if (release)
+			{
+				if (!count) first = page;
+				count++;
+			}
+			else if (count)
+			{
+				HostSys::MemProtect( region.mem + first * __pagesize, count * __pagesize, PageAccess_ReadWrite() );
+				count = 0;
+			}
+		}
+	}
+
+	s_active = false;
+}
+
+void MemorySnapshot::Finish()
+{
+	if (!s_active) return;
+
+	WaitCopy();
+	Poll();
+}
+
+bool MemorySnapshot::IsActive()
+{
+	return s_active;
+}
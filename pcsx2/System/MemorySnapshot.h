@@ -0,0 +1,51 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  MemorySnapshot - copy-on-write snapshot of the EE and IOP main memory
+// --------------------------------------------------------------------------------------
+// Begin() write-protects eeMem->Main and iopMem->Main and returns right away, so the VM can
+// resume.  A background thread then copies the pages to the destination buffers, and a page
+// written by the VM before the thread got to it is copied by the page fault handler first.
+//
+// Copied pages stay write-protected until their first write, or until Poll() (called by the
+// EE thread every vsync) makes the rest of them writable once the copy is complete.  EE pages
+// which are also protected for the recompiler's block tracking are left to mmap's fault
+// handler after the copy, so their blocks still get cleared.
+//
+// Only one snapshot runs at a time.  Finish() must be called, with the core suspended, before
+// anything else changes the protection of the guest memory or writes it from a thread which
+// isn't protected against page faults (resets, state loading, shutdown).
+
+namespace MemorySnapshot
+{
+	// Starts a snapshot into the given buffers (Ps2MemSize::MainRam and IopRam bytes).  The VM
+	// must be suspended.
+	extern void Begin( u8* eeDest, u8* iopDest );
+
+	// Blocks until every page of the current snapshot is in its buffer.
+	extern void WaitCopy();
+
+	// Releases the pages of a complete snapshot, from the EE thread.
+	extern void Poll();
+
+	// Waits for the copy and releases the remaining pages.  The VM must be suspended.
+	extern void Finish();
+
+	// True while pages of the main memories may still be write-protected for a snapshot.
+	extern bool IsActive();
+}
@@ -0,0 +1,422 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "RewindBuffer.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+static const uint PageSize			= _4kb;
+static const uint KeyframeInterval	= 16;		// checkpoints per keyframe, at most
+static const u32  PageStored		= 0x80000000;
+
+// --------------------------------------------------------------------------------------
+//  Page codec
+// --------------------------------------------------------------------------------------
+// A small LZ77 in the LZ4 block layout: a token with the literal count and match length
+// (extended with 255 bytes when they reach 15), the literals, and a 16 bit match offset.  The
+// last sequence only has literals.  XORed pages are mostly zero runs, which the overlapping
+// matches take care of.
+
+static const uint LzMinMatch	= 4;
+static const uint LzHashBits	= 12;
+
+static __fi u32 LzHash( const u8* p )
+{
+	u32 v;
+	memcpy( &v, p, 4 );
+	return (v * 2654435761u) >> (32 - LzHashBits);
+}
+
+static __fi u8* LzWriteLength( u8* op, uint len )
+{
+	for (; len >= 255; len -= 255) *op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+// Returns 0 if the result doesn't fit in cap bytes.
+static uint LzEncode( const u8* src, uint size, u8* dest, uint cap )
+{
+	u16 table[1 << LzHashBits];
+	memset( table, 0xff, sizeof(table) );
+
+	u8* op = dest;
+	u8* const oend = dest + cap;
+	uint anchor = 0;
+
+	for (uint i = 0; i + LzMinMatch <= size; )
+	{
+		const u32 h = LzHash( src + i );
+		const uint match = table[h];
+		table[h] = i;
+
+		if (match == 0xffff || memcmp( src + match, src + i, LzMinMatch ) != 0)
+		{
+			i++;
+			continue;
+		}
+
+		uint len = LzMinMatch;
+		while (i + len < size && src[match + len] == src[i + len]) len++;
+
+		const uint lit = i - anchor;
+		if ((uint)(oend - op) < 1 + lit / 255 + 1 + lit + 2 + len / 255 + 1) return 0;
+
+		u8* token = op++;
+		*token = (std::min( lit, 15u ) << 4) | std::min( len - LzMinMatch, 15u );
+		if (lit >= 15) op = LzWriteLength( op, lit - 15 );
+		memcpy( op, src + anchor, lit );
+		op += lit;
+
+		const uint offset = i - match;
+		*op++ = offset;
+		*op++ = offset >> 8;
+		if (len - LzMinMatch >= 15) op = LzWriteLength( op, len - LzMinMatch - 15 );
+
+		i += len;
+		anchor = i;
+	}
+
+	const uint lit = size - anchor;
+	if ((uint)(oend - op) < 1 + lit / 255 + 1 + lit) return 0;
+
+	*op++ = std::min( lit, 15u ) << 4;
+	if (lit >= 15) op = LzWriteLength( op, lit - 15 );
+	memcpy( op, src + anchor, lit );
+	op += lit;
+
+	return op - dest;
+}
+
+static bool LzDecode( const u8* src, uint srclen, u8* dest, uint size )
+{
+	const u8* ip = src;
+	const u8* const iend = src + srclen;
+	u8* op = dest;
+	u8* const oend = dest + size;
+
+	auto ReadLength = [&]( uint& len ) -> bool
+	{
+		u8 b;
+		do {
+			if (ip >= iend) return false;
+			b = *ip++;
+			len += b;
+		} while (b == 255);
+		return true;
+	};
+
+	while (ip < iend)
+	{
+		const uint token = *ip++;
+
+		uint lit = token >> 4;
+		if (lit == 15 && !ReadLength( lit )) return false;
+		if ((uint)(iend - ip) < lit || (uint)(oend - op) < lit) return false;
+		memcpy( op, ip, lit );
+		op += lit;
+		ip += lit;
+
+		if (ip == iend) break;		// last sequence
+		if (iend - ip < 2) return false;
+
+		const uint offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		uint len = token & 15;
+		if (len == 15 && !ReadLength( len )) return false;
+		len += LzMinMatch;
+
+		if (!offset || offset > (uint)(op - dest) || (uint)(oend - op) < len) return false;
+
+		// Byte by byte, the match may overlap what it writes
+		const u8* from = op - offset;
+		while (len--) *op++ = *from++;
+	}
+
+	return op == oend;
+}
+
+// --------------------------------------------------------------------------------------
+//  Checkpoints
+// --------------------------------------------------------------------------------------
+// The data holds a record for each page which differs from the keyframe (or isn't zero in
+// a keyframe): the page index (PageStored is set when the LZ didn't help), the record size,
+// then the XORed page.
+struct Checkpoint
+{
+	bool			keyframe;
+	uint			size;		// of the state
+	std::vector<u8>	data;
+};
+
+static __fi void Append( std::vector<u8>& data, u32 value )
+{
+	const u8* bytes = (const u8*)&value;
+	data.insert( data.end(), bytes, bytes + 4 );
+}
+
+static void Encode( Checkpoint& cp, const u8* state, uint size, const u8* key, uint keysize )
+{
+	u8 xored[PageSize];
+	u8 packed[PageSize];
+
+	cp.size = size;
+	cp.data.clear();
+
+	for (uint offset = 0; offset < size; offset += PageSize)
+	{
+		const uint len		= std::min( PageSize, size - offset );
+		const uint keylen	= (offset < keysize) ? std::min( len, keysize - offset ) : 0;
+		const u8* page		= state + offset;
+
+		if (keylen == len && memcmp( page, key + offset, len ) == 0) continue;
+
+		bool zero = true;
+		for (uint i = 0; i < len; i++)
+		{
+			xored[i] = page[i] ^ ((i < keylen) ? key[offset + i] : 0);
+			zero &= !xored[i];
+		}
+		if (zero) continue;
+
+		u32 index = offset / PageSize;
+		const u8* bytes = packed;
+		uint count = LzEncode( xored, len, packed, len - 1 );
+
+		if (!count)
+		{
+			index |= PageStored;
+			bytes = xored;
+			count = len;
+		}
+
+		Append( cp.data, index );
+		Append( cp.data, count );
+		cp.data.insert( cp.data.end(), bytes, bytes + count );
+	}
+}
+
+// dest must hold cp.size bytes.
+static void Decode( const Checkpoint& cp, u8* dest, const u8* key, uint keysize )
+{
+	const uint keylen = std::min( cp.size, keysize );
+	if (keylen) memcpy( dest, key, keylen );
+	memset( dest + keylen, 0, cp.size - keylen );
+
+	u8 xored[PageSize];
+	const u8* ip = cp.data.data();
+	const u8* const iend = ip + cp.data.size();
+
+	while (ip < iend)
+	{
+		u32 index, count;
+		memcpy( &index, ip, 4 );
+		memcpy( &count, ip + 4, 4 );
+		ip += 8;
+
+		const uint offset	= (index & ~PageStored) * PageSize;
+		const uint len		= std::min( PageSize, cp.size - offset );
+
+		if (index & PageStored)
+			memcpy( xored, ip, len );
+		else if (!LzDecode( ip, count, xored, len ))
+			pxFailRel( "Rewind checkpoint is corrupt." );
+
+		for (uint i = 0; i < len; i++)
+			dest[offset + i] ^= xored[i];
+
+		ip += count;
+	}
+}
+
+static Threading::Mutex			s_lock;
+static std::deque<Checkpoint>	s_checkpoints;
+static size_t					s_bytes			= 0;		// of the data in s_checkpoints
+
+// Used by the EE thread when the encoder isn't running, and by the encoder
+static std::unique_ptr<VmStateBuffer>	s_capture;
+static uint						s_captureSize	= 0;
+static std::vector<u8>			s_key;						// raw state of the last keyframe
+static size_t					s_keyBytes		= 0;		// and its encoded size
+static uint						s_sinceKey		= 0;
+static bool						s_needKey		= true;
+static int						s_frames		= 0;		// vsyncs since the last checkpoint
+
+// Drops the oldest keyframes (with their checkpoints) until the budget is met, the latest
+// keyframe is always kept.
+static void Trim( size_t budget )
+{
+	while (s_bytes > budget)
+	{
+		uint next = 1;
+		while (next < s_checkpoints.size() && !s_checkpoints[next].keyframe) next++;
+		if (next == s_checkpoints.size()) break;
+
+		for (uint i = 0; i < next; i++)
+		{
+			s_bytes -= s_checkpoints.front().data.size();
+			s_checkpoints.pop_front();
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  RewindEncodeThread
+// --------------------------------------------------------------------------------------
+class RewindEncodeThread : public pxThread
+{
+	typedef pxThread _parent;
+
+public:
+	RewindEncodeThread()
+	{
+		m_name = L"Rewind Encoder";
+	}
+
+	virtual ~RewindEncodeThread() throw()
+	{
+		try {
+			_parent::Cancel();
+		}
+		DESTRUCTOR_CATCHALL
+	}
+
+protected:
+	void ExecuteTaskInThread()
+	{
+		const u8* state = s_capture->GetPtr();
+		Checkpoint cp;
+
+		cp.keyframe = s_needKey || s_sinceKey >= KeyframeInterval;
+
+		if (cp.keyframe)
+		{
+			Encode( cp, state, s_captureSize, NULL, 0 );
+			s_key.assign( state, state + s_captureSize );
+			s_keyBytes	= cp.data.size();
+			s_sinceKey	= 0;
+			s_needKey	= false;
+		}
+		else
+		{
+			Encode( cp, state, s_captureSize, s_key.data(), s_key.size() );
+			s_sinceKey++;
+
+			// Deltas only grow from here, start over
+			if (cp.data.size() > s_keyBytes / 2) s_needKey = true;
+		}
+
+		// The raw keyframe and capture states count against the budget too
+		const size_t budget	= (size_t)EmuConfig.RewindBudget * _1mb;
+		const size_t raw	= s_key.capacity() + s_capture->GetSizeInBytes();
+
+		Threading::ScopedLock lock( s_lock );
+		s_bytes += cp.data.size();
+		s_checkpoints.push_back( std::move( cp ) );
+		Trim( budget > raw ? budget - raw : 0 );
+	}
+};
+
+static std::unique_ptr<RewindEncodeThread> s_encoder;
+
+// --------------------------------------------------------------------------------------
+//  Rewind  (implementations)
+// --------------------------------------------------------------------------------------
+void Rewind::FrameDone()
+{
+	const int interval = EmuConfig.RewindInterval;
+	if (interval <= 0 || ++s_frames < interval) return;
+
+	// Still encoding, try again on the next vsync
+	if (s_encoder && s_encoder->IsRunning()) return;
+
+	s_frames = 0;
+
+	try {
+		if (!s_capture) s_capture.reset( new VmStateBuffer( L"Rewind Capture" ) );
+
+		memSavingState saveme( s_capture.get() );
+		saveme.SetQuiet( true );
+		saveme.FreezeAll();
+		s_captureSize = saveme.GetCurrentPos();
+	}
+	catch (Exception::BaseException& ex)
+	{
+		Console.Error( L"Rewind: checkpoint failed, %s", WX_STR(ex.FormatDiagnosticMessage()) );
+		return;
+	}
+
+	s_encoder.reset( new RewindEncodeThread() );
+	s_encoder->Start();
+}
+
+bool Rewind::StepBack( VmStateBuffer& dest )
+{
+	if (s_encoder) s_encoder->Block();
+
+	Threading::ScopedLock lock( s_lock );
+	if (s_checkpoints.empty()) return false;
+
+	// Right after a checkpoint (or a rewind), go one further back
+	if (s_checkpoints.size() > 1 && s_frames < EmuConfig.RewindInterval / 2)
+	{
+		s_bytes -= s_checkpoints.back().data.size();
+		s_checkpoints.pop_back();
+	}
+
+	uint key = s_checkpoints.size() - 1;
+	while (!s_checkpoints[key].keyframe) key--;
+
+	const Checkpoint& keyframe	= s_checkpoints[key];
+	const Checkpoint& target	= s_checkpoints.back();
+
+	dest.ExactAlloc( target.size );
+
+	if (&keyframe == &target)
+		Decode( target, dest.GetPtr(), NULL, 0 );
+	else
+	{
+		std::vector<u8> keystate( keyframe.size );
+		Decode( keyframe, keystate.data(), NULL, 0 );
+		Decode( target, dest.GetPtr(), keystate.data(), keystate.size() );
+	}
+
+	Console.WriteLn( Color_StrongGreen, "Rewind: %u checkpoints left (%.1f MB)",
+		(uint)s_checkpoints.size(), s_bytes / (double)_1mb );
+
+	// The next checkpoint follows the one which was just loaded
+	s_frames	= 0;
+	s_needKey	= true;
+	return true;
+}
+
+void Rewind::Clear()
+{
+	if (s_encoder) s_encoder->Block();
+
+	Threading::ScopedLock lock( s_lock );
+	s_checkpoints.clear();
+	s_bytes		= 0;
+	s_needKey	= true;
+	s_frames	= 0;
+
+	std::vector<u8>().swap( s_key );
+	s_capture.reset();
+}
@@ -0,0 +1,43 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  Rewind - in-memory ring of delta compressed checkpoints
+// --------------------------------------------------------------------------------------
+// Every EmuConfig.RewindInterval vsyncs the EE thread saves a full state (memSavingState)
+// into a capture buffer, and a background thread encodes it.  A checkpoint only stores the
+// 4 KB pages of the state which differ from its keyframe, XORed with the keyframe's page and
+// LZ compressed.  A keyframe is stored the same way against an empty state, and a new one is
+// started every few checkpoints or when the deltas grow too large.
+//
+// The oldest keyframe and its checkpoints are dropped when the checkpoints, plus the raw
+// capture and keyframe states, take more than EmuConfig.RewindBudget megabytes.  A checkpoint
+// is skipped if the previous one is still being encoded.
+
+namespace Rewind
+{
+	// Called by the EE thread every vsync.
+	extern void FrameDone();
+
+	// Decodes the latest checkpoint into dest, or the one before it when the latest one is
+	// too recent (so repeated calls keep going back), and drops the newer ones.  Returns
+	// false if there's no checkpoint.  The VM must be suspended.
+	extern bool StepBack( VmStateBuffer& dest );
+
+	// Drops all the checkpoints.  The VM must be suspended.
+	extern void Clear();
+}
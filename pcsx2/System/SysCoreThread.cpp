@@ -24,6 +24,9 @@
 #include "Patch.h"
 #include "SysThreads.h"
 #include "MTVU.h"
+#include "SysWait.h"
+#include "MemorySnapshot.h"
+#include "RewindBuffer.h"
 
 #include "../DebugTools/MIPSAnalyst.h"
 #include "../DebugTools/SymbolMap.h"
@@ -225,6 +228,9 @@ void SysCoreThread::DoCpuReset()
 //
 void SysCoreThread::VsyncInThread()
 {
+	MemorySnapshot::Poll();
+	Rewind::FrameDone();
+
 	if (EmuConfig.EnablePatches) ApplyPatch();
 	if (EmuConfig.EnableCheats)  ApplyCheat();
 	if (EmuConfig.EnableWideScreenPatches)  ApplyCheat();
@@ -263,6 +269,8 @@ void SysCoreThread::ExecuteTaskInThread()
 	Threading::EnableHiresScheduler(); // Note that *something* in SPU2-X and GSdx also set the timer resolution to 1ms.
 	m_sem_event.WaitWithoutYield();
 
+	SysWait::SetAffinity("EE", EmuConfig.Threads.AffinityEE);
+
 	m_mxcsr_saved.bitmask = _mm_getcsr();
 
 	PCSX2_PAGEFAULT_PROTECT {
@@ -280,6 +288,7 @@ void SysCoreThread::OnSuspendInThread()
 
 void SysCoreThread::OnResumeInThread( bool isSuspended )
 {
+	SysWait::SetAffinity("EE", EmuConfig.Threads.AffinityEE);
 	GetCorePlugins().Open();
 }
 
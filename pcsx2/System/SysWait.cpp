@@ -0,0 +1,125 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "SysWait.h"
+
+#ifdef __linux__
+#	include <pthread.h>
+#	include <sched.h>
+#endif
+
+SysWait::Histogram SysWait::Stalls[SysWait_SiteCount];
+
+static int s_frames = 0;
+
+static const char* const s_site_names[SysWait_SiteCount] =
+{
+	"MTGS ring full",
+	"MTGS sync",
+	"MTGS vsync queue",
+	"MTGS xgkick",
+	"MTGS idle",
+	"MTVU ring full",
+	"MTVU sync",
+	"MTVU idle",
+};
+
+bool SysWait::IsRecording()
+{
+	return EmuConfig.Threads.StallStatsFrames > 0;
+}
+
+void SysWait::Record(SysWaitSite site, u64 ns)
+{
+	Histogram& h = Stalls[site];
+
+	int bucket = 0;
+	while (bucket < Buckets - 1 && (ns >> (bucket + 1)) != 0) bucket++;
+
+	h.count[bucket].fetch_add(1, std::memory_order_relaxed);
+	h.total.fetch_add(ns, std::memory_order_relaxed);
+}
+
+// Upper bound of the bucket under which the given fraction of the waits are
+static u64 Percentile(const u32* count, u32 total, u32 fraction_pct)
+{
+	u64 seen = 0;
+	for (int i = 0; i < SysWait::Buckets; i++) {
+		seen += count[i];
+		if (seen * 100 >= (u64)total * fraction_pct) return 2ull << i;
+	}
+	return ~0ull;
+}
+
+bool SysWait::FrameDone()
+{
+	const int frames = EmuConfig.Threads.StallStatsFrames;
+	if (frames <= 0 || ++s_frames < frames) return false;
+	s_frames = 0;
+
+	for (int site = 0; site < SysWait_SiteCount; site++) {
+		Histogram& h = Stalls[site];
+
+		u32 count[Buckets];
+		u32 waits = 0;
+		int last  = 0;
+		for (int i = 0; i < Buckets; i++) {
+			count[i] = h.count[i].exchange(0, std::memory_order_relaxed);
+			waits += count[i];
+			if (count[i]) last = i;
+		}
+		u64 total = h.total.exchange(0, std::memory_order_relaxed);
+		if (!waits) continue;
+
+		// Buckets are printed from 1us, the shorter waits are all in the first column
+		FastFormatAscii buckets;
+		u32 below = 0;
+		for (int i = 0; i < 10; i++) below += count[i];
+		if (below) buckets.Write(" <1us:%u", below);
+		for (int i = 10; i <= last; i++) {
+			if (count[i]) buckets.Write(" <%lluus:%u", (unsigned long long)(2ull << i) / 1000, count[i]);
+		}
+
+		Console.WriteLn(Color_Gray, "Stalls %-16s %6u waits %8llu us  p50 <%llu ns  p99 <%llu ns |%s",
+			s_site_names[site], waits, (unsigned long long)total / 1000,
+			(unsigned long long)Percentile(count, waits, 50), (unsigned long long)Percentile(count, waits, 99), buckets.c_str());
+	}
+	return true;
+}
+
+void SysWait::SetAffinity(const char* name, int cpu)
+{
+	if (cpu < 0) return;
+
+#if defined(_WIN32)
+	if (cpu >= (int)sizeof(DWORD_PTR) * 8 || !SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu))
+		Console.Warning("%s: Can't pin the thread to cpu %d", name, cpu);
+#elif defined(__linux__)
+	if (cpu >= CPU_SETSIZE) {
+		Console.Warning("%s: Can't pin the thread to cpu %d", name, cpu);
+		return;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+		Console.Warning("%s: Can't pin the thread to cpu %d", name, cpu);
+#else
+	Console.Warning("%s: Thread affinity isn't supported on this platform", name);
+#endif
+}
@@ -0,0 +1,105 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+// --------------------------------------------------------------------------------------
+//  SysWait - handoffs between the EE, MTGS and MTVU threads
+// --------------------------------------------------------------------------------------
+// The threads block on semaphores/mutexes (futexes on Linux) when they have to wait for
+// each other.  When the wait is expected to be short, waking up costs more than the wait
+// itself, so the waits first spin for a fixed budget (EmuConfig.Threads.WaitSpinNs for the
+// EE, IdleSpinNs for the MTGS/MTVU waiting for work) and only park after that.
+//
+// Every wait site also records how long it stalled, in power of two nanosecond buckets.
+// The histograms are printed every EmuConfig.Threads.StallStatsFrames frames.
+
+enum SysWaitSite
+{
+	SysWait_MtgsRingFull,	// EE waits for room in the MTGS ring buffer
+	SysWait_MtgsSync,		// EE (or MTVU) waits for the MTGS to empty its ring buffer
+	SysWait_MtgsVsync,		// EE waits for the MTGS to catch up with the queued frames
+	SysWait_MtgsXGkick,		// MTGS waits for the MTVU to finish a path1 packet
+	SysWait_MtgsIdle,		// MTGS waits for work
+	SysWait_MtvuRingFull,	// EE waits for room in the MTVU ring buffer
+	SysWait_MtvuSync,		// EE waits for the MTVU to finish
+	SysWait_MtvuIdle,		// MTVU waits for work
+	SysWait_SiteCount
+};
+
+namespace SysWait
+{
+	static const int Buckets = 32; // bucket i: [2^i, 2^(i+1)) ns, the last one is open ended
+
+	struct Histogram
+	{
+		std::atomic<u32> count[Buckets];
+		std::atomic<u64> total; // ns
+	};
+
+	extern Histogram Stalls[SysWait_SiteCount];
+
+	static __fi u64 Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	extern bool IsRecording();
+	extern void Record(SysWaitSite site, u64 ns);
+
+	// Called once per frame by the EE thread, prints the histograms when it's time to
+	// (and returns true so the caller can print its own stats).
+	extern bool FrameDone();
+
+	// Pins the calling thread to a host cpu (if cpu >= 0).
+	extern void SetAffinity(const char* name, int cpu);
+
+	// Spins until done() returns true or the budget runs out.  Returns the last done().
+	template<typename Func> bool Spin(int budget_ns, const Func& done)
+	{
+		if (done()) return true;
+		if (budget_ns <= 0) return false;
+
+		u64 end = Now() + budget_ns;
+
+		for (int i = 1; ; i++) {
+			Threading::SpinWait();
+			if (done()) return true;
+			// Checking the time every few iterations is enough, pause is 10-140 cycles
+			if ((i & 15) == 0 && Now() >= end) return false;
+		}
+	}
+
+	// When a spin picked up the work, the semaphore post that came with it is still pending and
+	// would wake the next wait up for nothing.  Consumes it (only the waiting thread may call it).
+	static __fi void Drain(Threading::Semaphore& sem)
+	{
+		while (sem.Count() > 0) sem.WaitWithoutYield();
+	}
+}
+
+// Times the scope if stall stats are enabled, for the wait site it's declared at.
+class ScopedSysWait
+{
+	SysWaitSite m_site;
+	u64 m_start;
+
+public:
+	ScopedSysWait(SysWaitSite site) : m_site(site), m_start(SysWait::IsRecording() ? SysWait::Now() : 0) {}
+	~ScopedSysWait() throw() { if (m_start) SysWait::Record(m_site, SysWait::Now() - m_start); }
+};
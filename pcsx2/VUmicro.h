@@ -160,6 +160,14 @@ public:
 	// there is another gif path 2/3 transfer already taking place.
 	// Use this method to resume execution of VU1.
 	virtual void ResumeXGkick() {}
+
+	// Compiles some code which is expected to run soon, while the VU thread would otherwise
+	// be idle.  Returns false when there's nothing left to compile.
+	//
+	// Thread Affinity:
+	//   Called from the MTVU thread, only when its ring buffer is empty.
+	//
+	virtual bool Precompile() { return false; }
 };
 
 
@@ -249,6 +257,7 @@ public:
 	void Clear(u32 addr, u32 size);
 	void Vsync() throw();
 	void ResumeXGkick();
+	bool Precompile();
 
 	uint GetCacheReserve() const;
 	void SetCacheReserve( uint reserveInMegs ) const;
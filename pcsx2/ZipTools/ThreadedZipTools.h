@@ -21,6 +21,29 @@
 
 using namespace Threading;
 
+// --------------------------------------------------------------------------------------
+//  Chunked archive format
+// --------------------------------------------------------------------------------------
+// Savestates are a list of entries, and each entry is split in ArchiveChunkSize chunks
+// compressed as separate zlib streams.  The chunks are independent, so both saving and
+// loading spread them over all the cores.
+//
+//   header:     ArchiveMagic, u32 savestate version, u32 entry count
+//   per entry:  u32 name length, name (UTF-8), u32 size, u32 chunk count
+//   per chunk:  u32 packed size (ArchiveChunkStored is set if it isn't compressed), data
+//
+// Older savestates are zip archives, they start with "PK".
+
+static const char ArchiveMagic[8]		= { 'P', 'C', 'S', 'X', '2', 'S', 'T', '\x1a' };
+static const uint ArchiveChunkSize		= _256kb;
+static const u32 ArchiveChunkStored		= 0x80000000;
+
+struct ArchiveChunk
+{
+	std::vector<u8>	data;
+	bool			stored;		// data is the raw chunk
+};
+
 // --------------------------------------------------------------------------------------
 //  ArchiveEntry
 // --------------------------------------------------------------------------------------
@@ -30,13 +53,19 @@ protected:
 	wxString	m_filename;
 	uptr		m_dataidx;
 	size_t		m_datasize;
-	
+	const u8*	m_dataptr;		// data outside of the list's buffer (guest memory), or NULL
+
+	std::vector<ArchiveChunk>	m_chunks;	// empty until the entry is compressed
+
+	friend class ArchiveEntryList;
+
 public:
 	ArchiveEntry( const wxString& filename=wxEmptyString )
 		: m_filename( filename )
 	{
 		m_dataidx	= 0;
 		m_datasize	= 0;
+		m_dataptr	= NULL;
 	}
 
 	virtual ~ArchiveEntry() throw() {}
@@ -53,6 +82,14 @@ public:
 		return *this;
 	}
 
+	// The data is read from there instead of the list's buffer.  It has to stay valid (and
+	// unchanged) until the entry is compressed.
+	ArchiveEntry& SetDataPtr( const u8* ptr )
+	{
+		m_dataptr = ptr;
+		return *this;
+	}
+
 	wxString GetFilename() const
 	{
 		return m_filename;
@@ -67,6 +104,16 @@ public:
 	{
 		return m_datasize;
 	}
+
+	const u8* GetDataPtr() const
+	{
+		return m_dataptr;
+	}
+
+	bool IsCompressed() const
+	{
+		return !m_chunks.empty() || !m_datasize;
+	}
 };
 
 typedef SafeArray< u8 > ArchiveDataBuffer;
@@ -137,6 +184,68 @@ public:
 	{
 		return m_list[idx];
 	}
+
+	const u8* GetEntryPtr( const ArchiveEntry& entry ) const
+	{
+		return entry.GetDataPtr() ? entry.GetDataPtr() : GetPtr( entry.GetDataIndex() );
+	}
+
+	// Compresses the entries which aren't compressed yet (only the ones with a data pointer
+	// if directOnly is set).  Level 0 stores the chunks.
+	void Compress( int level, bool directOnly=false );
+
+	// Writes the header and the compressed entries.
+	void Write( pxOutputStream& out, u32 version ) const;
+};
+
+// --------------------------------------------------------------------------------------
+//  ArchiveReader
+// --------------------------------------------------------------------------------------
+// Reads a whole chunked archive in memory.  The entries are queued with their destination,
+// and Decompress() then inflates all their chunks in parallel, straight to that destination.
+class ArchiveReader
+{
+	DeclareNoncopyableObject( ArchiveReader );
+
+protected:
+	struct Entry
+	{
+		wxString			name;
+		uint				size;
+		std::vector<uint>	offsets;	// of each chunk in m_data
+		std::vector<u32>	packed;		// sizes, ArchiveChunkStored flags included
+	};
+
+	struct Job
+	{
+		const Entry*	entry;
+		uint			chunk;
+		u8*				dest;
+		uint			destsize;		// may be shorter than the chunk
+	};
+
+	wxString			m_filename;
+	ArchiveDataBuffer	m_data;
+	u32					m_version;
+	std::vector<Entry>	m_entries;
+	std::vector<Job>	m_jobs;
+
+public:
+	static bool IsArchive( const wxString& filename );
+
+	ArchiveReader( const wxString& filename );
+	virtual ~ArchiveReader() throw() {}
+
+	u32 GetVersion() const { return m_version; }
+	wxString GetStreamName() const { return m_filename; }
+
+	// Returns -1 if there's no such entry.
+	int Find( const wxString& name ) const;
+	uint GetSize( int entry ) const { return m_entries[entry].size; }
+
+	// Decompresses at most size bytes of the entry to dest when Decompress() is called.
+	void Queue( int entry, u8* dest, uint size );
+	void Decompress();
 };
 
 // --------------------------------------------------------------------------------------
@@ -151,6 +260,7 @@ protected:
 	pxOutputStream*					m_gzfp;
 	ArchiveEntryList*				m_src_list;
 	bool							m_PendingSaveFlag;
+	int								m_level;
 	
 	wxString						m_final_filename;
 
@@ -181,6 +291,12 @@ public:
 		return *this;
 	}
 
+	BaseCompressThread& SetCompressionLevel( int level )
+	{
+		m_level = level;
+		return *this;
+	}
+
 	BaseCompressThread& SetFinishedPath( const wxString& path )
 	{
 		m_final_filename = path;
@@ -201,6 +317,7 @@ protected:
 		m_gzfp				= NULL;
 		m_src_list			= NULL;
 		m_PendingSaveFlag	= false;
+		m_level				= 1;
 	}
 
 	void SetPendingSave();
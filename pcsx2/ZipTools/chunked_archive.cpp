@@ -0,0 +1,357 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "SaveState.h"
+#include "ThreadedZipTools.h"
+#include "Utilities/SafeArray.inl"
+
+#include <wx/ffile.h>
+#include <atomic>
+#include <zlib.h>
+
+// --------------------------------------------------------------------------------------
+//  ChunkPool
+// --------------------------------------------------------------------------------------
+// Runs a list of independent chunk jobs on the calling thread plus one worker per other
+// core.  The workers only live for the duration of Run().
+template< typename T >
+class ChunkPool
+{
+	DeclareNoncopyableObject( ChunkPool );
+
+public:
+	static const uint MaxThreads = 8;
+
+protected:
+	class Worker : public pxThread
+	{
+		typedef pxThread _parent;
+
+	protected:
+		ChunkPool& m_pool;
+
+	public:
+		Worker( ChunkPool& pool ) : m_pool( pool )
+		{
+			m_name = L"Savestate Zip";
+		}
+
+		virtual ~Worker() throw()
+		{
+			try {
+				_parent::Cancel();
+			}
+			DESTRUCTOR_CATCHALL
+		}
+
+	protected:
+		void ExecuteTaskInThread() { m_pool.RunJobs(); }
+	};
+
+	std::vector<T>&		m_jobs;
+	void				(*m_func)( T& job );
+	std::atomic<uint>	m_next;
+
+	void RunJobs()
+	{
+		for (uint i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_jobs.size(); )
+			m_func( m_jobs[i] );
+	}
+
+public:
+	ChunkPool( std::vector<T>& jobs, void (*func)( T& job ) )
+		: m_jobs( jobs )
+		, m_func( func )
+		, m_next( 0 )
+	{
+	}
+
+	void Run()
+	{
+		uint threads = std::min<uint>( std::min<uint>( wxThread::GetCPUCount(), MaxThreads ), m_jobs.size() );
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		for (uint i = 1; i < threads; i++)
+		{
+			workers.emplace_back( new Worker( *this ) );
+			workers.back()->Start();
+		}
+
+		RunJobs();
+
+		for (auto& worker : workers)
+			worker->Block();
+	}
+};
+
+// --------------------------------------------------------------------------------------
+//  ArchiveEntryList  (compression)
+// --------------------------------------------------------------------------------------
+struct DeflateJob
+{
+	const u8*		src;
+	uint			size;
+	int				level;
+	ArchiveChunk*	dest;
+};
+
+static void DeflateChunk( DeflateJob& job )
+{
+	std::vector<u8>& data = job.dest->data;
+
+	if (job.level > 0)
+	{
+		uLongf packed = compressBound( job.size );
+		data.resize( packed );
+
+		if (compress2( data.data(), &packed, job.src, job.size, job.level ) == Z_OK && packed < job.size)
+		{
+			data.resize( packed );
+			job.dest->stored = false;
+			return;
+		}
+	}
+
+	// Incompressible (or level 0), keep it as it is
+	data.assign( job.src, job.src + job.size );
+	job.dest->stored = true;
+}
+
+void ArchiveEntryList::Compress( int level, bool directOnly )
+{
+	level = std::min( level, Z_BEST_COMPRESSION );
+
+	std::vector<DeflateJob> jobs;
+
+	for (ArchiveEntry& entry : m_list)
+	{
+		if (entry.IsCompressed() || (directOnly && !entry.GetDataPtr())) continue;
+
+		const u8* src = GetEntryPtr( entry );
+		uint chunks = (entry.GetDataSize() + ArchiveChunkSize - 1) / ArchiveChunkSize;
+		entry.m_chunks.resize( chunks );
+
+		for (uint i = 0; i < chunks; i++)
+		{
+			DeflateJob job;
+			job.src		= src + i * ArchiveChunkSize;
+			job.size	= std::min( ArchiveChunkSize, entry.GetDataSize() - i * ArchiveChunkSize );
+			job.level	= level;
+			job.dest	= &entry.m_chunks[i];
+			jobs.push_back( job );
+		}
+	}
+
+	if (!jobs.empty())
+		ChunkPool<DeflateJob>( jobs, DeflateChunk ).Run();
+}
+
+void ArchiveEntryList::Write( pxOutputStream& out, u32 version ) const
+{
+	u32 count = 0;
+	for (const ArchiveEntry& entry : m_list)
+		if (entry.GetDataSize()) count++;
+
+	out.Write( ArchiveMagic, sizeof(ArchiveMagic) );
+	out.Write( version );
+	out.Write( count );
+
+	for (const ArchiveEntry& entry : m_list)
+	{
+		if (!entry.GetDataSize()) continue;
+		pxAssertDev( entry.IsCompressed(), "Savestate entry written before being compressed" );
+
+		const wxCharBuffer name( entry.GetFilename().ToUTF8() );
+		const u32 namelen = strlen( name.data() );
+
+		out.Write( namelen );
+		out.Write( name.data(), namelen );
+		out.Write( (u32)entry.GetDataSize() );
+		out.Write( (u32)entry.m_chunks.size() );
+
+		for (const ArchiveChunk& chunk : entry.m_chunks)
+		{
+			out.Write( (u32)chunk.data.size() | (chunk.stored ? ArchiveChunkStored : 0) );
+			out.Write( chunk.data.data(), chunk.data.size() );
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  ArchiveReader
+// --------------------------------------------------------------------------------------
+bool ArchiveReader::IsArchive( const wxString& filename )
+{
+	wxFFile file( filename, L"rb" );
+	char magic[sizeof(ArchiveMagic)];
+
+	return file.IsOpened() && file.Read( magic, sizeof(magic) ) == sizeof(magic)
+		&& memcmp( magic, ArchiveMagic, sizeof(magic) ) == 0;
+}
+
+ArchiveReader::ArchiveReader( const wxString& filename )
+	: m_filename( filename )
+	, m_data( L"Savestate Archive" )
+{
+	wxFFile file( filename, L"rb" );
+	if (!file.IsOpened())
+		throw Exception::CannotCreateStream( filename ).SetDiagMsg(L"Cannot open file for reading.");
+
+	const wxFileOffset length = file.Length();
+	if (length < (wxFileOffset)(sizeof(ArchiveMagic) + 8) || length > 0x7fffffff)
+		throw Exception::SaveStateLoadError( filename ).SetDiagMsg(L"Savestate archive has an invalid length.");
+
+	m_data.ExactAlloc( length );
+	if (file.Read( m_data.GetPtr(), length ) != (size_t)length)
+		throw Exception::BadStream( filename ).SetDiagMsg(L"Savestate archive could not be read.");
+
+	const u8* ptr = m_data.GetPtr();
+	const u8* end = ptr + length;
+
+	auto Take = [&]( uint size ) -> const u8*
+	{
+		if ((uint)(end - ptr) < size)
+			throw Exception::SaveStateLoadError( filename ).SetDiagMsg(L"Savestate archive is truncated.");
+		const u8* at = ptr;
+		ptr += size;
+		return at;
+	};
+	auto TakeU32 = [&]() -> u32
+	{
+		u32 value;
+		memcpy( &value, Take( 4 ), 4 );
+		return value;
+	};
+
+	Take( sizeof(ArchiveMagic) );
+	m_version = TakeU32();
+	u32 count = TakeU32();
+
+	for (u32 i = 0; i < count; i++)
+	{
+		Entry entry;
+
+		u32 namelen = TakeU32();
+		const u8* name = Take( namelen );
+		entry.name = wxString::FromUTF8( (const char*)name, namelen );
+		entry.size = TakeU32();
+
+		u32 chunks = TakeU32();
+		if (chunks != (entry.size + ArchiveChunkSize - 1) / ArchiveChunkSize)
+			throw Exception::SaveStateLoadError( filename ).SetDiagMsg(pxsFmt(L"Savestate archive entry '%s' is corrupt.", WX_STR(entry.name)));
+
+		for (u32 c = 0; c < chunks; c++)
+		{
+			u32 packed = TakeU32();
+			entry.packed.push_back( packed );
+			entry.offsets.push_back( Take( packed & ~ArchiveChunkStored ) - m_data.GetPtr() );
+		}
+
+		m_entries.push_back( entry );
+	}
+}
+
+int ArchiveReader::Find( const wxString& name ) const
+{
+	for (uint i = 0; i < m_entries.size(); i++)
+		if (m_entries[i].name.CmpNoCase( name ) == 0) return i;
+
+	return -1;
+}
+
+void ArchiveReader::Queue( int entry, u8* dest, uint size )
+{
+	const Entry& e = m_entries[entry];
+	size = std::min( size, e.size );
+
+	for (uint c = 0; c * ArchiveChunkSize < size; c++)
+	{
+		Job job;
+		job.entry		= &e;
+		job.chunk		= c;
+		job.dest		= dest + c * ArchiveChunkSize;
+		job.destsize	= std::min( ArchiveChunkSize, size - c * ArchiveChunkSize );
+		m_jobs.push_back( job );
+	}
+}
+
+struct InflateJob
+{
+	const wxString*	name;
+	const u8*	src;
+	u32			packed;
+	uint		size;		// of the whole chunk
+	u8*			dest;
+	uint		destsize;
+	bool		ok;
+};
+
+static void InflateChunk( InflateJob& job )
+{
+	const uint srclen = job.packed & ~ArchiveChunkStored;
+
+	if (job.packed & ArchiveChunkStored)
+	{
+		job.ok = srclen == job.size;
+		if (job.ok) memcpy( job.dest, job.src, job.destsize );
+		return;
+	}
+
+	// A chunk which is only partly loaded is inflated on the side first
+	std::vector<u8> temp;
+	u8* dest = job.dest;
+	if (job.destsize < job.size)
+	{
+		temp.resize( job.size );
+		dest = temp.data();
+	}
+
+	uLongf size = job.size;
+	job.ok = uncompress( dest, &size, job.src, srclen ) == Z_OK && size == job.size;
+
+	if (job.ok && dest != job.dest)
+		memcpy( job.dest, dest, job.destsize );
+}
+
+void ArchiveReader::Decompress()
+{
+	std::vector<InflateJob> jobs;
+
+	for (const Job& j : m_jobs)
+	{
+		InflateJob job;
+		job.name		= &j.entry->name;
+		job.src			= m_data.GetPtr() + j.entry->offsets[j.chunk];
+		job.packed		= j.entry->packed[j.chunk];
+		job.size		= std::min( ArchiveChunkSize, j.entry->size - j.chunk * ArchiveChunkSize );
+		job.dest		= j.dest;
+		job.destsize	= j.destsize;
+		job.ok			= false;
+		jobs.push_back( job );
+	}
+	m_jobs.clear();
+
+	if (!jobs.empty())
+		ChunkPool<InflateJob>( jobs, InflateChunk ).Run();
+
+	for (const InflateJob& job : jobs)
+	{
+		if (!job.ok)
+			throw Exception::SaveStateLoadError( m_filename )
+				.SetDiagMsg(pxsFmt(L"Savestate archive entry '%s' is corrupt.", WX_STR(*job.name)));
+	}
+}
@@ -55,27 +55,9 @@ void BaseCompressThread::ExecuteTaskInThread()
 	
 	Yield( 3 );
 
-	uint listlen = m_src_list->GetLength();
-	for( uint i=0; i<listlen; ++i )
-	{
-		const ArchiveEntry& entry = (*m_src_list)[i];
-		if (!entry.GetDataSize()) continue;
-
-		wxArchiveOutputStream& woot = *(wxArchiveOutputStream*)m_gzfp->GetWxStreamBase();
-		woot.PutNextEntry( entry.GetFilename() );
-
-		static const uint BlockSize = 0x64000;
-		uint curidx = 0;
-
-		do {
-			uint thisBlockSize = std::min( BlockSize, entry.GetDataSize() - curidx );
-			m_gzfp->Write(m_src_list->GetPtr( entry.GetDataIndex() + curidx ), thisBlockSize);
-			curidx += thisBlockSize;
-			Yield( 2 );
-		} while( curidx < entry.GetDataSize() );
-		
-		woot.CloseEntry();
-	}
+	// Whatever wasn't compressed while the core was paused (everything but the guest memory)
+	m_src_list->Compress( m_level );
+	m_src_list->Write( *m_gzfp, g_SaveVersion );
 
 	m_gzfp->Close();
 
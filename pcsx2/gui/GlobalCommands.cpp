@@ -502,6 +502,12 @@ static const GlobalCommandDescriptor CommandDeclarations[] =
 		pxL( "Cycles the current save slot in -1 fashion!" ),
 	},
 
+	{	"States_Rewind",
+		States_Rewind,
+		pxL( "Rewind" ),
+		pxL( "Loads the previous rewind checkpoint." ),
+	},
+
 	{	"Frameskip_Toggle",
 		Implementations::Frameskip_Toggle,
 		NULL,
@@ -169,3 +169,22 @@ void States_CycleSlotBackward()
 	OnSlotChanged();
 }
 
+void States_Rewind()
+{
+	if( !SysHasValidState() )
+	{
+		Console.WriteLn( "Rewind: Aborting (VM is not active)." );
+		return;
+	}
+
+	if( IsSavingOrLoading.exchange(true) )
+	{
+		Console.WriteLn( "Load or save action is already pending." );
+		return;
+	}
+
+	StateCopy_Rewind();
+
+	GetSysExecutorThread().PostIdleEvent( SysExecEvent_ClearSavingLoadingFlag() );
+}
+
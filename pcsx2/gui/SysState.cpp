@@ -18,6 +18,8 @@
 #include "App.h"
 
 #include "System/SysThreads.h"
+#include "System/MemorySnapshot.h"
+#include "System/RewindBuffer.h"
 #include "SaveState.h"
 #include "VUmicro.h"
 
@@ -25,6 +27,7 @@
 #include "Utilities/pxStreams.h"
 
 #include <wx/wfstream.h>
+#include <wx/mstream.h>
 #include <memory>
 
 // Used to hold the current state backup (fullcopy of PS2 memory and plugin states).
@@ -62,7 +65,6 @@ public:
 	virtual void FreezeOut( SaveStateBase& writer ) const;
 	virtual bool IsRequired() const { return true; }
 
-protected:
 	virtual u8* GetDataPtr() const=0;
 	virtual uint GetDataSize() const=0;
 };
@@ -271,22 +273,19 @@ static const SavestateEntryPack SavestateEntries;
 //
 static Mutex mtx_CompressToDisk;
 
-static void CheckVersion( pxInputStream& thr )
+static void CheckVersion( u32 savever, const wxString& filename )
 {
-	u32 savever;
-	thr.Read( savever );
-	
 	// Major version mismatch.  Means we can't load this savestate at all.  Support for it
 	// was removed entirely.
 	if( savever > g_SaveVersion )
-		throw Exception::SaveStateLoadError( thr.GetStreamName() )
+		throw Exception::SaveStateLoadError( filename )
 			.SetDiagMsg(pxsFmt( L"Savestate uses an unsupported or unknown savestate version.\n(PCSX2 ver=%x, state ver=%x)", g_SaveVersion, savever ))
 			.SetUserMsg(_("Cannot load this savestate.  The state is an unsupported version."));
 
 	// check for a "minor" version incompatibility; which happens if the savestate being loaded is a newer version
 	// than the emulator recognizes.  99% chance that trying to load it will just corrupt emulation or crash.
 	if( (savever >> 16) != (g_SaveVersion >> 16) )
-		throw Exception::SaveStateLoadError( thr.GetStreamName() )
+		throw Exception::SaveStateLoadError( filename )
 			.SetDiagMsg(pxsFmt( L"Savestate uses an unknown savestate version.\n(PCSX2 ver=%x, state ver=%x)", g_SaveVersion, savever ))
 			.SetUserMsg(_("Cannot load this savestate. The state is an unsupported version."));
 };
@@ -298,6 +297,11 @@ static void CheckVersion( pxInputStream& thr )
 // is then mailed to another thread for zip archiving, while the main emulation process is
 // allowed to continue execution.
 //
+// The guest memory isn't copied to the buffer: it's compressed in place (on all cores)
+// before the core resumes, and only the smaller internal and plugin states are buffered.
+// With EmuConfig.SavestateSnapshots the EE and IOP main memory are snapshotted instead
+// (see MemorySnapshot), and the core resumes without waiting for either.
+//
 class SysExecEvent_DownloadState : public SysExecEvent
 {
 protected:
@@ -317,6 +321,11 @@ public:
 	bool AllowCancelOnExit() const { return false; }
 	
 protected:
+	static bool IsSnapshotMemory( const MemorySavestateEntry* mem )
+	{
+		return mem->GetDataPtr() == eeMem->Main || mem->GetDataPtr() == iopMem->Main;
+	}
+
 	void InvokeEvent()
 	{
 		ScopedCoreThreadPause paused_core;
@@ -326,6 +335,24 @@ protected:
 				.SetDiagMsg(L"SysExecEvent_DownloadState: Cannot freeze/download an invalid VM state!")
 				.SetUserMsg(_("There is no active virtual machine state to download or save." ));
 
+		const bool snapshot = EmuConfig.SavestateSnapshots;
+
+		if (!snapshot)
+		{
+			for (uint i=0; i<SavestateEntries.GetSize(); ++i)
+			{
+				const MemorySavestateEntry* mem = dynamic_cast<const MemorySavestateEntry*>(SavestateEntries[i]);
+				if (!mem) continue;
+
+				m_dest_list->Add( ArchiveEntry( mem->GetFilename() )
+					.SetDataPtr( mem->GetDataPtr() )
+					.SetDataSize( mem->GetDataSize() )
+				);
+			}
+
+			m_dest_list->Compress( EmuConfig.SavestateZlibLevel, true );
+		}
+
 		memSavingState saveme( m_dest_list->GetBuffer() );
 		ArchiveEntry internals( EntryFilename_InternalStructures );
 		internals.SetDataIndex( saveme.GetCurrentPos() );
@@ -338,6 +365,9 @@ protected:
 
 		for (uint i=0; i<SavestateEntries.GetSize(); ++i)
 		{
+			const MemorySavestateEntry* mem = dynamic_cast<const MemorySavestateEntry*>(SavestateEntries[i]);
+			if (mem && (!snapshot || IsSnapshotMemory( mem ))) continue;
+
 			uint startpos = saveme.GetCurrentPos();
 			SavestateEntries[i]->FreezeOut( saveme );
 			m_dest_list->Add( ArchiveEntry( SavestateEntries[i]->GetFilename() )
@@ -346,6 +376,31 @@ protected:
 			);
 		}
 
+		// The main memories are reserved last, the buffer mustn't move while the snapshot
+		// is copied into it.
+		if (snapshot)
+		{
+			const uint eepos	= saveme.GetCurrentPos();
+			const uint ioppos	= eepos + Ps2MemSize::MainRam;
+			const uint size		= Ps2MemSize::MainRam + Ps2MemSize::IopRam;
+
+			saveme.PrepBlock( size );
+			saveme.CommitBlock( size );
+
+			for (uint i=0; i<SavestateEntries.GetSize(); ++i)
+			{
+				const MemorySavestateEntry* mem = dynamic_cast<const MemorySavestateEntry*>(SavestateEntries[i]);
+				if (!mem || !IsSnapshotMemory( mem )) continue;
+
+				m_dest_list->Add( ArchiveEntry( mem->GetFilename() )
+					.SetDataIndex( (mem->GetDataPtr() == eeMem->Main) ? eepos : ioppos )
+					.SetDataSize( mem->GetDataSize() )
+				);
+			}
+
+			MemorySnapshot::Begin( m_dest_list->GetPtr( eepos ), m_dest_list->GetPtr( ioppos ) );
+		}
+
 		UI_EnableStateActions();
 		paused_core.AllowResume();
 	}
@@ -425,6 +480,9 @@ protected:
 		// Provisionals for scoped cleanup, in case of exception:
 		std::unique_ptr<ArchiveEntryList> elist(m_src_list);
 
+		// The list's buffer receives the memory snapshot, if there's one
+		MemorySnapshot::WaitCopy();
+
 		wxString tempfile( m_filename + L".tmp" );
 
 		wxFFileOutputStream* woot = new wxFFileOutputStream(tempfile);
@@ -437,32 +495,12 @@ protected:
 
 		pxYield(4);
 
-		// Write the version and screenshot:
-		std::unique_ptr<pxOutputStream> out(new pxOutputStream(tempfile, new wxZipOutputStream(woot)));
-		wxZipOutputStream* gzfp = (wxZipOutputStream*)out->GetWxStreamBase();
-
-		{
-			wxZipEntry* vent = new wxZipEntry(EntryFilename_StateVersion);
-			vent->SetMethod( wxZIP_METHOD_STORE );
-			gzfp->PutNextEntry( vent );
-			out->Write(g_SaveVersion);
-			gzfp->CloseEntry();
-		}
-
-		std::unique_ptr<wxImage> m_screenshot;
-		
-		if (m_screenshot)
-		{
-			wxZipEntry* vent = new wxZipEntry(EntryFilename_Screenshot);
-			vent->SetMethod( wxZIP_METHOD_STORE );
-			gzfp->PutNextEntry( vent );
-			m_screenshot->SaveFile( *gzfp, wxBITMAP_TYPE_JPEG );
-			gzfp->CloseEntry();
-		}
+		std::unique_ptr<pxOutputStream> out(new pxOutputStream(tempfile, woot));
 
 		(*new VmStateCompressThread())
 			.SetSource(elist.get())
 			.SetOutStream(out.get())
+			.SetCompressionLevel(EmuConfig.SavestateZlibLevel)
 			.SetFinishedPath(m_filename)
 			.Start();
 
@@ -505,6 +543,111 @@ protected:
 	{
 		ScopedLock lock( mtx_CompressToDisk );
 
+		if (ArchiveReader::IsArchive( m_filename ))
+			LoadArchive();
+		else
+			LoadZip();
+	}
+
+	// Log any parts and pieces that are missing, and then generate an exception.
+	void CheckRequiredEntries( const bool* found )
+	{
+		bool throwIt = false;
+		for (uint i=0; i<NumSavestateEntries; ++i)
+		{
+			if (found[i]) continue;
+			
+			if (SavestateEntries[i]->IsRequired())
+			{
+				throwIt = true;
+				Console.WriteLn( Color_Red, " ... not found '%s'!", WX_STR(SavestateEntries[i]->GetFilename()) );
+			}
+		}
+
+		if (throwIt)
+			throw Exception::SaveStateLoadError( m_filename )
+				.SetDiagMsg( L"Savestate cannot be loaded: some required components were not found or are incomplete." )
+				.SetUserMsg(_("This savestate cannot be loaded due to missing critical components.  See the log file for details."));
+	}
+
+	// All the chunks (of every entry) are decompressed in parallel.  The guest memory is
+	// decompressed in place, the plugin states and internal structures go through buffers.
+	void LoadArchive()
+	{
+		ArchiveReader reader( m_filename );
+		CheckVersion( reader.GetVersion(), m_filename );
+
+		const int internal = reader.Find( EntryFilename_InternalStructures );
+		if (internal < 0)
+		{
+			throw Exception::SaveStateLoadError( m_filename )
+				.SetDiagMsg( pxsFmt(L"Savestate file does not contain '%s'", EntryFilename_InternalStructures) )
+				.SetUserMsg(_("This file is not a valid PCSX2 savestate.  See the logfile for details."));
+		}
+
+		int foundEntry[NumSavestateEntries];
+		bool found[NumSavestateEntries];
+		for (uint i=0; i<NumSavestateEntries; ++i)
+		{
+			foundEntry[i] = reader.Find( SavestateEntries[i]->GetFilename() );
+			found[i] = foundEntry[i] >= 0;
+			if (found[i])
+				DevCon.WriteLn( Color_Green, L" ... found '%s'", WX_STR(SavestateEntries[i]->GetFilename()) );
+		}
+
+		CheckRequiredEntries( found );
+
+		// We use direct Suspend/Resume control here, since it's desirable that emulation
+		// *ALWAYS* start execution after the new savestate is loaded.
+
+		GetCoreThread().Pause();
+		SysClearExecutionCache();
+
+		std::unique_ptr<VmStateBuffer> buffers[NumSavestateEntries];
+
+		for (uint i=0; i<NumSavestateEntries; ++i)
+		{
+			if (!found[i]) continue;
+
+			const uint entrySize = reader.GetSize( foundEntry[i] );
+
+			if (const MemorySavestateEntry* mem = dynamic_cast<const MemorySavestateEntry*>(SavestateEntries[i]))
+			{
+				if (entrySize < mem->GetDataSize())
+				{
+					Console.WriteLn( Color_Yellow, " '%s' is incomplete (expected 0x%x bytes, loading only 0x%x bytes)",
+						WX_STR(mem->GetFilename()), mem->GetDataSize(), entrySize );
+				}
+
+				reader.Queue( foundEntry[i], mem->GetDataPtr(), mem->GetDataSize() );
+			}
+			else
+			{
+				buffers[i].reset( new VmStateBuffer( entrySize, L"StateBuffer_UnzipFromDisk" ) );
+				reader.Queue( foundEntry[i], buffers[i]->GetPtr(), entrySize );
+			}
+		}
+
+		VmStateBuffer buffer( reader.GetSize( internal ), L"StateBuffer_UnzipFromDisk" );
+		reader.Queue( internal, buffer.GetPtr(), buffer.GetSizeInBytes() );
+
+		reader.Decompress();
+
+		for (uint i=0; i<NumSavestateEntries; ++i)
+		{
+			if (!buffers[i]) continue;
+
+			pxInputStream stream( m_filename, new wxMemoryInputStream( buffers[i]->GetPtr(), buffers[i]->GetSizeInBytes() ) );
+			SavestateEntries[i]->FreezeIn( stream );
+		}
+
+		memLoadingState( buffer ).FreezeBios().FreezeInternals();
+		GetCoreThread().Resume();	// force resume regardless of emulation state earlier.
+	}
+
+	// Savestates from older versions
+	void LoadZip()
+	{
 		// Ugh.  Exception handling made crappy because wxWidgets classes don't support scoped pointers yet.
 
 		std::unique_ptr<wxFFileInputStream> woot(new wxFFileInputStream(m_filename));
@@ -543,7 +686,9 @@ protected:
 			{
 				DevCon.WriteLn( Color_Green, L" ... found '%s'", EntryFilename_StateVersion);
 				foundVersion = true;
-				CheckVersion(*reader);
+				u32 savever;
+				reader->Read( savever );
+				CheckVersion( savever, m_filename );
 				continue;
 			}
 
@@ -580,23 +725,11 @@ protected:
 				.SetUserMsg(_("This file is not a valid PCSX2 savestate.  See the logfile for details."));
 		}
 
-		// Log any parts and pieces that are missing, and then generate an exception.
-		bool throwIt = false;
+		bool found[NumSavestateEntries];
 		for (uint i=0; i<NumSavestateEntries; ++i)
-		{
-			if (foundEntry[i]) continue;
-			
-			if (SavestateEntries[i]->IsRequired())
-			{
-				throwIt = true;
-				Console.WriteLn( Color_Red, " ... not found '%s'!", WX_STR(SavestateEntries[i]->GetFilename()) );
-			}
-		}
+			found[i] = !!foundEntry[i];
 
-		if (throwIt)
-			throw Exception::SaveStateLoadError( m_filename )
-				.SetDiagMsg( L"Savestate cannot be loaded: some required components were not found or are incomplete." )
-				.SetUserMsg(_("This savestate cannot be loaded due to missing critical components.  See the log file for details."));
+		CheckRequiredEntries( found );
 
 		// We use direct Suspend/Resume control here, since it's desirable that emulation
 		// *ALWAYS* start execution after the new savestate is loaded.
@@ -626,6 +759,37 @@ protected:
 	}
 };
 
+// --------------------------------------------------------------------------------------
+//  SysExecEvent_Rewind
+// --------------------------------------------------------------------------------------
+// Loads the previous rewind checkpoint (see Rewind).
+//
+class SysExecEvent_Rewind : public SysExecEvent
+{
+public:
+	wxString GetEventName() const { return L"VM_Rewind"; }
+
+	virtual ~SysExecEvent_Rewind() throw() {}
+	SysExecEvent_Rewind* Clone() const { return new SysExecEvent_Rewind( *this ); }
+
+	bool IsCriticalEvent() const { return true; }
+	bool AllowCancelOnExit() const { return false; }
+
+protected:
+	void InvokeEvent()
+	{
+		ScopedCoreThreadPause paused_core;
+
+		VmStateBuffer buffer( L"StateBuffer_Rewind" );
+		if (Rewind::StepBack( buffer ))
+			GetCoreThread().UploadStateCopy( buffer );
+		else
+			Console.WriteLn( "Rewind: there's no checkpoint to go back to." );
+
+		paused_core.AllowResume();
+	}
+};
+
 // =====================================================================================================
 //  StateCopy Public Interface
 // =====================================================================================================
@@ -648,6 +812,11 @@ void StateCopy_LoadFromFile( const wxString& file )
 	GetSysExecutorThread().PostEvent(new SysExecEvent_UnzipFromDisk( file ));
 }
 
+void StateCopy_Rewind()
+{
+	GetSysExecutorThread().PostEvent(new SysExecEvent_Rewind());
+}
+
 // Saves recovery state info to the given saveslot, or saves the active emulation state
 // (if one exists) and no recovery data was found.  This is needed because when a recovery
 // state is made, the emulation state is usually reset so the only persisting state is
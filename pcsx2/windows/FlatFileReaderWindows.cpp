@@ -20,8 +20,10 @@ FlatFileReader::FlatFileReader(bool shareWrite) : shareWrite(shareWrite)
 {
 	m_blocksize = 2048;
 	hOverlappedFile = INVALID_HANDLE_VALUE;
-	hEvent = INVALID_HANDLE_VALUE;
-	asyncInProgress = false;
+	for (uint i = 0; i < MaxQueueDepth; i++)
+		hEvent[i] = INVALID_HANDLE_VALUE;
+	m_queue_head = 0;
+	m_queue_count = 0;
 }
 
 FlatFileReader::~FlatFileReader(void)
@@ -33,7 +35,9 @@ bool FlatFileReader::Open(const wxString& fileName)
 {
 	m_filename = fileName;
 
-	hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	// One event per read in flight
+	for (uint i = 0; i < MaxQueueDepth; i++)
+		hEvent[i] = CreateEvent(NULL, TRUE, FALSE, NULL);
 
 	DWORD shareMode = FILE_SHARE_READ;
 	if (shareWrite)
@@ -69,52 +73,67 @@ int FlatFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 
 void FlatFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 {
+	pxAssertDev(m_queue_count < MaxQueueDepth, "FlatFileReader: too many reads in flight");
+
+	uint slot = (m_queue_head + m_queue_count) % MaxQueueDepth;
+
 	LARGE_INTEGER offset;
 	offset.QuadPart = sector * (s64)m_blocksize + m_dataoffset;
 	
 	DWORD bytesToRead = count * m_blocksize;
 
-	ZeroMemory(&asyncOperationContext, sizeof(asyncOperationContext));
-	asyncOperationContext.hEvent = hEvent;
-	asyncOperationContext.Offset = offset.LowPart;
-	asyncOperationContext.OffsetHigh = offset.HighPart;
+	ZeroMemory(&asyncOperationContext[slot], sizeof(asyncOperationContext[slot]));
+	asyncOperationContext[slot].hEvent = hEvent[slot];
+	asyncOperationContext[slot].Offset = offset.LowPart;
+	asyncOperationContext[slot].OffsetHigh = offset.HighPart;
 
-	ReadFile(hOverlappedFile, pBuffer, bytesToRead, NULL, &asyncOperationContext);
-	asyncInProgress = true;
+	ReadFile(hOverlappedFile, pBuffer, bytesToRead, NULL, &asyncOperationContext[slot]);
+	m_queue_count++;
 }
 
 int FlatFileReader::FinishRead(void)
 {
+	if (!m_queue_count)
+		return -1;
+
+	// Reads complete in the order they were begun
+	uint slot = m_queue_head;
+	m_queue_head = (m_queue_head + 1) % MaxQueueDepth;
+	m_queue_count--;
+
 	DWORD bytes;
 	
-	if(!GetOverlappedResult(hOverlappedFile, &asyncOperationContext, &bytes, TRUE))
-	{
-		asyncInProgress = false;
+	if(!GetOverlappedResult(hOverlappedFile, &asyncOperationContext[slot], &bytes, TRUE))
 		return -1;
-	}
 
-	asyncInProgress = false;
 	return bytes;
 }
 
 void FlatFileReader::CancelRead(void)
 {
 	CancelIo(hOverlappedFile);
+
+	// The OVERLAPPED structs and buffers must stay valid until the cancelled reads are done.
+	while (m_queue_count)
+		FinishRead();
 }
 
 void FlatFileReader::Close(void)
 {
-	if(asyncInProgress)
+	if(m_queue_count)
 		CancelRead();
 
 	if(hOverlappedFile != INVALID_HANDLE_VALUE)
 		CloseHandle(hOverlappedFile);
 
-	if(hEvent != INVALID_HANDLE_VALUE)
-		CloseHandle(hEvent);
+	for (uint i = 0; i < MaxQueueDepth; i++)
+	{
+		if(hEvent[i] != INVALID_HANDLE_VALUE)
+			CloseHandle(hEvent[i]);
+		hEvent[i] = INVALID_HANDLE_VALUE;
+	}
 
 	hOverlappedFile = INVALID_HANDLE_VALUE;
-	hEvent = INVALID_HANDLE_VALUE;
 }
 
 uint FlatFileReader::GetBlockCount(void) const
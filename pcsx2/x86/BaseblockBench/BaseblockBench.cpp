@@ -0,0 +1,220 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// --------------------------------------------------------------------------------------
+//  BaseblockBench - BaseBlocks vs the legacy sorted array under synthetic SMC churn
+// --------------------------------------------------------------------------------------
+// Runs the same random sequence of operations on both indexes over a 32MB address space:
+//   60% new blocks (1 to 64 instructions, only where no block contains the pc)
+//   20% links to a random pc
+//   20% clears of a 4KB page, removing every block which overlaps it (like recClear)
+//
+// Prints the time each index took, then checks that both hold the same blocks and
+// answer random Last/Get lookups the same way.  Returns non-zero on a mismatch.
+//
+// Usage: BaseblockBench [ops=200000] [seed=7]
+
+#include "PrecompiledHeader.h"
+#include "../BaseblockEx.h"
+#include "LegacyBaseblockEx.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+static const u32 AddressSpace = 32 * 1024 * 1024;
+
+// The blocks point here; dev builds write a breakpoint to the first byte of removed blocks.
+static u8 s_code[0x1000];
+
+static void FakeJITCompile() {}
+
+enum BenchOp
+{
+	Op_New,
+	Op_Link,
+	Op_Clear,
+};
+
+struct BenchStep
+{
+	BenchOp	op;
+	u32		pc;
+	u16		size;
+};
+
+static std::vector<BenchStep> MakeSteps( int ops, u32 seed )
+{
+	std::mt19937 rng( seed );
+	std::vector<BenchStep> steps( ops );
+
+	for (BenchStep& step : steps)
+	{
+		const u32 roll = rng() % 10;
+		step.op		= roll < 6 ? Op_New : roll < 8 ? Op_Link : Op_Clear;
+		step.pc		= (rng() % (AddressSpace / 4)) * 4;
+		step.size	= 1 + rng() % 64;
+	}
+
+	return steps;
+}
+
+static void RunLegacy( Legacy::BaseBlocks& blocks, const std::vector<BenchStep>& steps, std::vector<s32>& jumps )
+{
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		const BenchStep& step = steps[i];
+
+		switch (step.op)
+		{
+			case Op_New:
+				if (blocks.Index( step.pc ) == -1)
+					blocks.New( step.pc, (uptr)s_code )->size = step.size;
+			break;
+
+			case Op_Link:
+				blocks.Link( step.pc, &jumps[i] );
+			break;
+
+			case Op_Clear:
+			{
+				const u32 addr = step.pc & ~0xfff;
+				int last = blocks.LastIndex( addr + 0x1000 - 4 );
+				if (last == -1) break;
+
+				int idx = last;
+				while (Legacy::BASEBLOCKEX* block = blocks[idx])
+				{
+					if (block->startpc + block->size * 4 <= addr) break;
+					idx--;
+				}
+
+				if (idx != last)
+					blocks.Remove( idx + 1, last );
+			}
+			break;
+		}
+	}
+}
+
+static void RunCurrent( BaseBlocks& blocks, const std::vector<BenchStep>& steps, std::vector<s32>& jumps )
+{
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		const BenchStep& step = steps[i];
+
+		switch (step.op)
+		{
+			case Op_New:
+				if (!blocks.Get( step.pc ))
+					blocks.SetSize( blocks.New( step.pc, (uptr)s_code ), step.size );
+			break;
+
+			case Op_Link:
+				blocks.Link( step.pc, &jumps[i] );
+			break;
+
+			case Op_Clear:
+			{
+				const u32 addr = step.pc & ~0xfff;
+				BASEBLOCKEX* block = blocks.Last( addr + 0x1000 - 4 );
+
+				while (block)
+				{
+					BASEBLOCKEX* prev = blocks.Prev( block );
+					if (block->startpc + block->size * 4 <= addr) break;
+					blocks.Remove( block );
+					block = prev;
+				}
+			}
+			break;
+		}
+	}
+}
+
+template< typename T >
+static double TimeIt( const T& func )
+{
+	const auto start = std::chrono::steady_clock::now();
+	func();
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+static bool Compare( Legacy::BaseBlocks& legacy, BaseBlocks& current, u32 seed )
+{
+	int count = 0;
+	BASEBLOCKEX* block = current.First();
+
+	for (; Legacy::BASEBLOCKEX* old = legacy[count]; count++, block = BaseBlocks::Next( block ))
+	{
+		if (!block || block->startpc != old->startpc || block->size != old->size)
+		{
+			printf( "Block %d differs\n", count );
+			return false;
+		}
+	}
+
+	if (block)
+	{
+		printf( "Extra blocks after %d\n", count );
+		return false;
+	}
+
+	std::mt19937 rng( seed ^ 0x5a5a5a5a );
+
+	for (int i = 0; i < 200000; i++)
+	{
+		const u32 pc = (rng() % (AddressSpace / 4)) * 4;
+
+		const int idx = legacy.LastIndex( pc );
+		const Legacy::BASEBLOCKEX* old = (idx != -1 && legacy[idx]->startpc <= pc) ? legacy[idx] : NULL;
+		const BASEBLOCKEX* last = current.Last( pc );
+
+		if (!old != !last || (last && last->startpc != old->startpc))
+		{
+			printf( "Last(%08x) differs: %08x vs %08x\n", pc, old ? old->startpc : 0, last ? last->startpc : 0 );
+			return false;
+		}
+
+		if (!legacy.Get( pc ) != !current.Get( pc ))
+		{
+			printf( "Get(%08x) differs\n", pc );
+			return false;
+		}
+	}
+
+	printf( "Same contents, %d blocks\n", count );
+	return true;
+}
+
+int main( int argc, char** argv )
+{
+	const int ops = argc > 1 ? atoi( argv[1] ) : 200000;
+	const u32 seed = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 7;
+
+	const std::vector<BenchStep> steps( MakeSteps( ops, seed ) );
+	std::vector<s32> jumps( ops );
+
+	Legacy::BaseBlocks legacy;
+	BaseBlocks current;
+	legacy.SetJITCompile( FakeJITCompile );
+	current.SetJITCompile( FakeJITCompile );
+
+	printf( "%d ops (60%% new, 20%% link, 20%% 4KB clear), seed %u\n", ops, seed );
+	printf( "legacy:  %.3fs\n", TimeIt( [&]{ RunLegacy( legacy, steps, jumps ); } ) );
+	printf( "current: %.3fs\n", TimeIt( [&]{ RunCurrent( current, steps, jumps ); } ) );
+
+	return Compare( legacy, current, seed ) ? 0 : 1;
+}
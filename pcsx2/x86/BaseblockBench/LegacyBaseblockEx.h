@@ -0,0 +1,244 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+
+// --------------------------------------------------------------------------------------
+//  Legacy::BaseBlocks
+// --------------------------------------------------------------------------------------
+// The block index BaseblockEx.h used to have (one array sorted by startpc, links in a
+// multimap), kept only so the benchmark can compare against it.  Same interface as it had.
+namespace Legacy
+{
+
+struct BASEBLOCKEX
+{
+	u32  startpc;
+	uptr fnptr;
+	u16  size;	 // The size in dwords (equivalent to the number of instructions)
+	u16  x86size; // The size in byte of the translated x86 instructions
+};
+
+class BaseBlockArray {
+	s32 _Reserved;
+	s32 _Size;
+	BASEBLOCKEX *blocks;
+
+	__fi void resize(s32 size)
+	{
+		pxAssert(size > 0);
+		BASEBLOCKEX *newMem = new BASEBLOCKEX[size];
+		if(blocks) {
+			memcpy(newMem, blocks, _Reserved * sizeof(BASEBLOCKEX));
+			delete[] blocks;
+		}
+		blocks = newMem;
+		pxAssert(blocks != NULL);
+	}
+
+	void reserve(u32 size)
+	{
+		resize(size);
+		_Reserved = size;
+	}
+public:
+	~BaseBlockArray()
+	{
+		if(blocks) {
+			delete[] blocks;
+		}
+	}
+
+	BaseBlockArray (s32 size) : _Reserved(0),
+		_Size(0), blocks(NULL)
+	{
+		reserve(size);
+	}
+
+	BASEBLOCKEX *insert(u32 startpc, uptr fnptr)
+	{
+		if(_Size + 1 >= _Reserved) {
+			reserve(_Reserved + 0x2000); // some games requires even more!
+		}
+
+		// Insert the the new BASEBLOCKEX by startpc order
+		int imin = 0, imax = _Size, imid;
+
+		while (imin < imax) {
+			imid = (imin+imax)>>1;
+
+			if (blocks[imid].startpc > startpc)
+				imax = imid;
+			else
+				imin = imid + 1;
+		}
+
+		pxAssert(imin == _Size || blocks[imin].startpc > startpc);
+
+		if(imin < _Size) {
+			// make a hole for a new block.
+			memmove(blocks + imin + 1, blocks + imin, (_Size - imin) * sizeof(BASEBLOCKEX));
+		}
+
+		memset((blocks + imin), 0, sizeof(BASEBLOCKEX));
+		blocks[imin].startpc = startpc;
+		blocks[imin].fnptr = fnptr;
+
+		_Size++;
+		return &blocks[imin];
+	}
+
+	__fi BASEBLOCKEX &operator[](int idx) const
+	{
+		return *(blocks + idx);
+	}
+
+	void clear()
+	{
+		_Size = 0;
+	}
+
+	__fi u32 size() const
+	{
+		return _Size;
+	}
+
+	__fi void erase(s32 first, s32 last)
+	{
+		int range = last - first;
+
+		if(last < _Size) {
+			memmove(blocks + first, blocks + last, (_Size - last) * sizeof(BASEBLOCKEX));
+		}
+
+		_Size -= range;
+	}
+};
+
+class BaseBlocks
+{
+protected:
+	typedef std::multimap<u32, uptr>::iterator linkiter_t;
+
+	std::multimap<u32, uptr> links;
+	uptr recompiler;
+	BaseBlockArray blocks;
+
+public:
+	BaseBlocks() :
+		recompiler(0)
+	,	blocks(0x4000)
+	{
+	}
+
+	void SetJITCompile( void (*recompiler_)() )
+	{
+		recompiler = (uptr)recompiler_;
+	}
+
+	BASEBLOCKEX* New(u32 startpc, uptr fnptr)
+	{
+		std::pair<linkiter_t, linkiter_t> range = links.equal_range(startpc);
+		for (linkiter_t i = range.first; i != range.second; ++i)
+			*(u32*)i->second = fnptr - (i->second + 4);
+
+		return blocks.insert(startpc, fnptr);
+	}
+
+	int LastIndex (u32 startpc) const
+	{
+		if (0 == blocks.size())
+			return -1;
+
+		int imin = 0, imax = blocks.size() - 1, imid;
+
+		while(imin != imax) {
+			imid = (imin+imax+1)>>1;
+
+			if (blocks[imid].startpc > startpc)
+				imax = imid - 1;
+			else
+				imin = imid;
+		}
+
+		return imin;
+	}
+
+	__fi int Index (u32 startpc) const
+	{
+		int idx = LastIndex(startpc);
+
+		if ((idx == -1) || (startpc < blocks[idx].startpc) ||
+			((blocks[idx].size) && (startpc >= blocks[idx].startpc + blocks[idx].size * 4)))
+			return -1;
+		else
+			return idx;
+	}
+
+	__fi BASEBLOCKEX* operator[](int idx)
+	{
+		if (idx < 0 || idx >= (int)blocks.size())
+			return 0;
+
+		return &blocks[idx];
+	}
+
+	__fi BASEBLOCKEX* Get(u32 startpc)
+	{
+		return (*this)[Index(startpc)];
+	}
+
+	__fi void Remove(int first, int last)
+	{
+		pxAssert(first <= last);
+		int idx = first;
+		do{
+			pxAssert(idx <= last);
+
+			std::pair<linkiter_t, linkiter_t> range = links.equal_range(blocks[idx].startpc);
+			for (linkiter_t i = range.first; i != range.second; ++i)
+				*(u32*)i->second = recompiler - (i->second + 4);
+
+			if( IsDevBuild )
+			{
+				BASEBLOCKEX effu( blocks[idx] );
+				memset( (void*)effu.fnptr, 0xcc, 1 );
+			}
+		}
+		while(idx++ < last);
+
+		blocks.erase(first, last + 1);
+	}
+
+	void Link(u32 pc, s32* jumpptr)
+	{
+		BASEBLOCKEX *targetblock = Get(pc);
+		if (targetblock && targetblock->startpc == pc)
+			*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
+		else
+			*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
+		links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
+	}
+
+	__fi void Reset()
+	{
+		blocks.clear();
+		links.clear();
+	}
+};
+
+}
@@ -17,32 +17,176 @@
 #include "PrecompiledHeader.h"
 #include "BaseblockEx.h"
 
+BaseBlocks::BaseBlocks() :
+	recompiler(0)
+,	m_head(NULL)
+,	m_maxsize(0)
+,	m_chunkcur(0)
+,	m_chunkused(0)
+,	m_free(NULL)
+,	m_linkcount(0)
+{
+	m_pages = new BASEBLOCKEX*[PageCount];
+	m_usedpages = new u32[PageCount / 32];
+
+	m_links.resize(0x1000);
+	Reset();
+}
+
+BaseBlocks::~BaseBlocks()
+{
+	for (BASEBLOCKEX* chunk : m_chunks)
+		delete[] chunk;
+
+	delete[] m_pages;
+	delete[] m_usedpages;
+}
+
+void BaseBlocks::Reset()
+{
+	m_head = NULL;
+	m_maxsize = 0;
+	memset(m_pages, 0, PageCount * sizeof(BASEBLOCKEX*));
+	memset(m_usedpages, 0, PageCount / 32 * sizeof(u32));
+
+	// Keep the chunks around, the same game will need them again.
+	m_chunkcur = 0;
+	m_chunkused = 0;
+	m_free = NULL;
+
+	memset(m_links.data(), 0, m_links.size() * sizeof(LinkSlot));
+	m_linkrefs.clear();
+	m_linkcount = 0;
+}
+
+BASEBLOCKEX* BaseBlocks::Alloc()
+{
+	if (m_free) {
+		BASEBLOCKEX* block = m_free;
+		m_free = block->next;
+		return block;
+	}
+
+	if (m_chunkused == ChunkSize) {
+		m_chunkcur++;
+		m_chunkused = 0;
+	}
+
+	if (m_chunkcur == m_chunks.size())
+		m_chunks.push_back(new BASEBLOCKEX[ChunkSize]);
+
+	return &m_chunks[m_chunkcur][m_chunkused++];
+}
+
+// Highest used page below 'page', or -1
+int BaseBlocks::PrevUsedPage(u32 page) const
+{
+	int word = page / 32;
+	u32 bits = m_usedpages[word] & ((1u << (page % 32)) - 1);
+
+	while (!bits) {
+		if (--word < 0)
+			return -1;
+		bits = m_usedpages[word];
+	}
+
+#ifdef _MSC_VER
+	unsigned long bit;
+	_BitScanReverse(&bit, bits);
+#else
+	u32 bit = 31 - __builtin_clz(bits);
+#endif
+	return word * 32 + bit;
+}
+
+BASEBLOCKEX* BaseBlocks::Last(u32 pc) const
+{
+	u32 page = pc >> PageShift;
+	if (page >= PageCount)
+		return NULL;
+
+	BASEBLOCKEX* block = m_pages[page];
+
+	if (!block || block->startpc > pc) {
+		// Nothing before pc in its page, it's the last block of the previous used page.
+		int prev = PrevUsedPage(page);
+		if (prev < 0)
+			return NULL;
+
+		block = m_pages[prev];
+		pc = ((prev + 1) << PageShift) - 1;
+	}
+
+	while (block->next && block->next->startpc <= pc)
+		block = block->next;
+
+	return block;
+}
+
 BASEBLOCKEX* BaseBlocks::New(u32 startpc, uptr fnptr)
 {
-	std::pair<linkiter_t, linkiter_t> range = links.equal_range(startpc);
-	for (linkiter_t i = range.first; i != range.second; ++i)
-		*(u32*)i->second = fnptr - (i->second + 4);
-	
-	return blocks.insert(startpc, fnptr);;
+	PatchLinks(startpc, fnptr);
+
+	BASEBLOCKEX* block = Alloc();
+	memset(block, 0, sizeof(BASEBLOCKEX));
+	block->startpc = startpc;
+	block->fnptr = fnptr;
+
+	// After any block with the same startpc, like the sorted array used to do.
+	BASEBLOCKEX* prev = Last(startpc);
+	block->prev = prev;
+	block->next = prev ? prev->next : m_head;
+	if (block->next)
+		block->next->prev = block;
+	if (prev)
+		prev->next = block;
+	else
+		m_head = block;
+
+	u32 page = startpc >> PageShift;
+	if (!m_pages[page] || m_pages[page] == block->next) {
+		m_pages[page] = block;
+		m_usedpages[page / 32] |= 1u << (page % 32);
+	}
+
+	return block;
 }
 
-int BaseBlocks::LastIndex(u32 startpc) const
+void BaseBlocks::Remove(BASEBLOCKEX* block)
 {
-	if (0 == blocks.size())
-		return -1;
+	PatchLinks(block->startpc, recompiler);
 
-	int imin = 0, imax = blocks.size() - 1, imid;
+	if( IsDevBuild )
+	{
+		// Clear the first instruction to 0xcc (breakpoint), as a way to assert if some
+		// static jumps get left behind to this block.  Note: Do not clear more than the
+		// first byte, since this code is called during exception handlers and event handlers
+		// both of which expect to be able to return to the recompiled code.
 
-	while(imin != imax) {
-		imid = (imin+imax+1)>>1;
+		memset( (void*)block->fnptr, 0xcc, 1 );
+	}
 
-		if (blocks[imid].startpc > startpc)
-			imax = imid - 1;
-		else
-			imin = imid;
+	// TODO: remove links from this block?
+
+	u32 page = block->startpc >> PageShift;
+	if (m_pages[page] == block) {
+		if (block->next && (block->next->startpc >> PageShift) == page) {
+			m_pages[page] = block->next;
+		} else {
+			m_pages[page] = NULL;
+			m_usedpages[page / 32] &= ~(1u << (page % 32));
+		}
 	}
 
-	return imin;
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		m_head = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+
+	block->next = m_free;
+	m_free = block;
 }
 
 #if 0
@@ -70,6 +214,41 @@ BASEBLOCKEX* BaseBlocks::GetByX86(uptr ip)
 }
 #endif
 
+BaseBlocks::LinkSlot* BaseBlocks::FindLinks(u32 pc)
+{
+	// Fibonacci hashing, jump targets are word aligned
+	uint mask = m_links.size() - 1;
+	uint i = ((pc >> 2) * 0x9E3779B1u) >> 8 & mask;
+
+	while (m_links[i].head && m_links[i].pc != pc)
+		i = (i + 1) & mask;
+
+	return &m_links[i];
+}
+
+void BaseBlocks::GrowLinks()
+{
+	std::vector<LinkSlot> old;
+	old.swap(m_links);
+	m_links.resize(old.size() * 2);
+	memset(m_links.data(), 0, m_links.size() * sizeof(LinkSlot));
+
+	for (const LinkSlot& slot : old) {
+		if (slot.head)
+			*FindLinks(slot.pc) = slot;
+	}
+}
+
+void BaseBlocks::PatchLinks(u32 pc, uptr target)
+{
+	const LinkSlot* slot = FindLinks(pc);
+
+	for (u32 ref = slot->head; ref; ref = m_linkrefs[ref - 1].next) {
+		uptr jumpptr = m_linkrefs[ref - 1].jumpptr;
+		*(u32*)jumpptr = target - (jumpptr + 4);
+	}
+}
+
 void BaseBlocks::Link(u32 pc, s32* jumpptr)
 {
 	BASEBLOCKEX *targetblock = Get(pc);
@@ -77,6 +256,18 @@ void BaseBlocks::Link(u32 pc, s32* jumpptr)
 		*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
 	else
 		*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
-	links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
-}
 
+	// Keep the table at most half full
+	if ((m_linkcount + 1) * 2 > m_links.size())
+		GrowLinks();
+
+	LinkSlot* slot = FindLinks(pc);
+	if (!slot->head) {
+		slot->pc = pc;
+		m_linkcount++;
+	}
+
+	LinkRef ref = { (uptr)jumpptr, slot->head };
+	m_linkrefs.push_back(ref);
+	slot->head = m_linkrefs.size();
+}
@@ -15,7 +15,7 @@
 
 #pragma once
 
-#include <map>			// used by BaseBlockEx
+#include <vector>
 
 // Every potential jump point in the PS2's addressable memory has a BASEBLOCK
 // associated with it. So that means a BASEBLOCK for every 4 bytes of PS2
@@ -36,6 +36,10 @@ struct BASEBLOCKEX
 	u16  size;	 // The size in dwords (equivalent to the number of instructions)
 	u16  x86size; // The size in byte of the translated x86 instructions
 
+	// Neighbours by startpc, owned by BaseBlocks (use BaseBlocks::Prev/Next)
+	BASEBLOCKEX* prev;
+	BASEBLOCKEX* next;
+
 #ifdef PCSX2_DEVBUILD
 	// Could be useful to instrument the block
 	//u32 visited; // number of times called
@@ -44,118 +48,61 @@ struct BASEBLOCKEX
 
 };
 
-class BaseBlockArray {
-	s32 _Reserved;
-	s32 _Size;
-	BASEBLOCKEX *blocks;
-
-	__fi void resize(s32 size)
-	{
-		pxAssert(size > 0);
-		BASEBLOCKEX *newMem = new BASEBLOCKEX[size];
-		if(blocks) {
-			memcpy(newMem, blocks, _Reserved * sizeof(BASEBLOCKEX));
-			delete[] blocks;
-		}
-		blocks = newMem;
-		pxAssert(blocks != NULL);
-	}
-
-	void reserve(u32 size)
-	{
-		resize(size);
-		_Reserved = size;
-	}
-public:
-	~BaseBlockArray()
-	{
-		if(blocks) {
-			delete[] blocks;
-		}
-	}
-
-	BaseBlockArray (s32 size) : _Reserved(0),
-		_Size(0), blocks(NULL)
-	{
-		reserve(size);
-	}
-
-	BASEBLOCKEX *insert(u32 startpc, uptr fnptr)
-	{
-		if(_Size + 1 >= _Reserved) {
-			reserve(_Reserved + 0x2000); // some games requires even more!
-		}
-
-		// Insert the the new BASEBLOCKEX by startpc order
-		int imin = 0, imax = _Size, imid;
-
-		while (imin < imax) {
-			imid = (imin+imax)>>1;
-
-			if (blocks[imid].startpc > startpc)
-				imax = imid;
-			else
-				imin = imid + 1;
-		}
-	
-		pxAssert(imin == _Size || blocks[imin].startpc > startpc);
-
-		if(imin < _Size) {
-			// make a hole for a new block.
-			memmove(blocks + imin + 1, blocks + imin, (_Size - imin) * sizeof(BASEBLOCKEX));
-		}
-
-		memset((blocks + imin), 0, sizeof(BASEBLOCKEX));
-		blocks[imin].startpc = startpc;
-		blocks[imin].fnptr = fnptr;
-
-		_Size++;
-		return &blocks[imin];
-	}
-
-	__fi BASEBLOCKEX &operator[](int idx) const
-	{
-		return *(blocks + idx);
-	}
+// --------------------------------------------------------------------------------------
+//  BaseBlocks
+// --------------------------------------------------------------------------------------
+// Index of the recompiled blocks, ordered by startpc.
+//
+// Blocks live in fixed chunks (so pointers stay valid until the block is removed) and
+// are chained in startpc order.  Each 4k page of the (physical) address space points
+// to its first block, and a bitmap of the used pages finds the closest block before an
+// empty page, so lookups, inserts and removes don't depend on the number of blocks.
+//
+// Jumps waiting on a block (see Link) are kept in an open addressing table by target pc.
+class BaseBlocks
+{
+protected:
+	static const uint PageShift = 12;
+	static const uint PageCount = 0x20000000 >> PageShift;	// HWADDR is a physical address
+	static const uint ChunkSize = 0x2000;
 
-	void clear()
+	struct LinkRef
 	{
-		_Size = 0;
-	}
+		uptr jumpptr;
+		u32 next;		// index+1 of the next jump to the same pc, 0 ends the chain
+	};
 
-	__fi u32 size() const
+	struct LinkSlot
 	{
-		return _Size;
-	}
+		u32 pc;
+		u32 head;		// index+1 in m_linkrefs, 0 is an empty slot
+	};
 
-	__fi void erase(s32 first, s32 last)
-	{
-		int range = last - first;
+	uptr recompiler;
 
-		if(last < _Size) {
-			memmove(blocks + first, blocks + last, (_Size - last) * sizeof(BASEBLOCKEX));
-		}
+	BASEBLOCKEX* m_head;
+	BASEBLOCKEX** m_pages;		// first block of every page
+	u32* m_usedpages;			// one bit per page which has a block
+	u32 m_maxsize;				// largest block size (in dwords) since the last reset
 
-		_Size -= range;
-	}
-};
+	std::vector<BASEBLOCKEX*> m_chunks;
+	uint m_chunkcur;			// chunk being carved, and how much of it is used
+	uint m_chunkused;
+	BASEBLOCKEX* m_free;
 
-class BaseBlocks
-{
-protected:
-	typedef std::multimap<u32, uptr>::iterator linkiter_t;
+	std::vector<LinkSlot> m_links;
+	std::vector<LinkRef> m_linkrefs;
+	uint m_linkcount;			// used slots of m_links
 
-	// switch to a hash map later?
-	std::multimap<u32, uptr> links;
-	uptr recompiler;
-	BaseBlockArray blocks;
+	BASEBLOCKEX* Alloc();
+	int PrevUsedPage(u32 page) const;
+	LinkSlot* FindLinks(u32 pc);
+	void PatchLinks(u32 pc, uptr target);
+	void GrowLinks();
 
 public:
-	BaseBlocks() :
-		recompiler(0)
-	,	blocks(0x4000)
-	{
-	}
+	BaseBlocks();
+	~BaseBlocks();
 
 	void SetJITCompile( void (*recompiler_)() )
 	{
@@ -163,69 +110,55 @@ public:
 	}
 
 	BASEBLOCKEX* New(u32 startpc, uptr fnptr);
-	int LastIndex (u32 startpc) const;
+
+	// Block with the highest startpc <= pc, NULL if there's none or pc is out of range.
+	BASEBLOCKEX* Last(u32 pc) const;
 	//BASEBLOCKEX* GetByX86(uptr ip);
 
-	__fi int Index (u32 startpc) const
+	// Block which contains pc (or starts at it, for blocks still being compiled)
+	__fi BASEBLOCKEX* Get(u32 pc) const
 	{
-		int idx = LastIndex(startpc);
+		BASEBLOCKEX* block = Last(pc);
 
-		if ((idx == -1) || (startpc < blocks[idx].startpc) ||
-			((blocks[idx].size) && (startpc >= blocks[idx].startpc + blocks[idx].size * 4)))
-			return -1;
+		if (!block || ((block->size) && (pc >= block->startpc + block->size * 4)))
+			return NULL;
 		else
-			return idx;
+			return block;
 	}
 
-	__fi BASEBLOCKEX* operator[](int idx)
-	{
-		if (idx < 0 || idx >= (int)blocks.size())
-			return 0;
+	__fi BASEBLOCKEX* First() const { return m_head; }
+	__fi static BASEBLOCKEX* Prev(const BASEBLOCKEX* block) { return block->prev; }
+	__fi static BASEBLOCKEX* Next(const BASEBLOCKEX* block) { return block->next; }
 
-		return &blocks[idx];
-	}
-
-	__fi BASEBLOCKEX* Get(u32 startpc)
+	// Blocks are created with a size of 0, set it once the block is compiled.
+	__fi void SetSize(BASEBLOCKEX* block, u32 size)
 	{
-		return (*this)[Index(startpc)];
+		pxAssert(size <= 0xffff);
+		block->size = size;
+		m_maxsize = std::max(m_maxsize, size);
 	}
 
-	__fi void Remove(int first, int last)
+	// No block starting before addr - GetReach() can contain addr.
+	__fi u32 GetReach() const { return m_maxsize * 4; }
+
+	void Remove(BASEBLOCKEX* block);
+
+	// Removes first, last and everything in between.
+	__fi void Remove(BASEBLOCKEX* first, BASEBLOCKEX* last)
 	{
-		pxAssert(first <= last);
-		int idx = first;
-		do{
-			pxAssert(idx <= last);
-
-			//u32 startpc = blocks[idx].startpc;
-			std::pair<linkiter_t, linkiter_t> range = links.equal_range(blocks[idx].startpc);
-			for (linkiter_t i = range.first; i != range.second; ++i)
-				*(u32*)i->second = recompiler - (i->second + 4);
-
-			if( IsDevBuild )
-			{
-				// Clear the first instruction to 0xcc (breakpoint), as a way to assert if some
-				// static jumps get left behind to this block.  Note: Do not clear more than the
-				// first byte, since this code is called during exception handlers and event handlers
-				// both of which expect to be able to return to the recompiled code.
-
-				BASEBLOCKEX effu( blocks[idx] );
-				memset( (void*)effu.fnptr, 0xcc, 1 );
-			}
+		while (true) {
+			BASEBLOCKEX* next = first->next;
+			Remove(first);
+			if (first == last)
+				break;
+			pxAssert(next);
+			first = next;
 		}
-		while(idx++ < last);
-
-		// TODO: remove links from this block?
-		blocks.erase(first, last + 1);
 	}
 
 	void Link(u32 pc, s32* jumpptr);
 
-	__fi void Reset()
-	{
-		blocks.clear();
-		links.clear();
-	}
+	void Reset();
 };
 
 #define PC_GETBLOCK_(x, reclut) ((BASEBLOCK*)(reclut[((u32)(x)) >> 16] + (x)*(sizeof(BASEBLOCK)/4)))
@@ -0,0 +1,159 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2015  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "BlockProfiler.h"
+
+#include "x86emitter/x86emitter.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace x86Emitter;
+
+BlockProfiler EE::BlockProfiles("EE");
+BlockProfiler IOP::BlockProfiles("IOP");
+
+// Shared by all the profilers, since the EE and IOP blocks run on the same thread and
+// the IOP runs from within EE event tests.
+static BlockProfile* s_current = NULL;
+static u64 s_lastticks = 0;
+
+static void __fastcall BlockProfilerEnter(BlockProfile* profile)
+{
+	u64 now = GetCPUTicks();
+
+	if (s_current)
+		s_current->ticks += now - s_lastticks;
+
+	s_current = profile;
+	s_lastticks = now;
+}
+
+BlockProfiler::BlockProfiler(const char* name)
+	: m_name(name)
+	, m_enabled(false)
+	, m_ticks(false)
+{
+}
+
+void BlockProfiler::Enable(bool enabled, bool ticks)
+{
+	if (m_enabled && !enabled)
+		Clear();
+
+	m_enabled = enabled;
+	m_ticks = enabled && ticks;
+}
+
+void BlockProfiler::Clear()
+{
+	// Only valid while no recompiled code references the entries, ie after a reset.
+	s_current = NULL;
+	m_bypc.clear();
+	m_profiles.clear();
+}
+
+BlockProfile* BlockProfiler::Find(u32 startpc)
+{
+	auto it = m_bypc.find(startpc);
+	if (it != m_bypc.end())
+		return it->second;
+
+	BlockProfile profile = {};
+	profile.startpc = startpc;
+	m_profiles.push_back(profile);
+
+	BlockProfile* p = &m_profiles.back();
+	m_bypc[startpc] = p;
+	return p;
+}
+
+BlockProfile* BlockProfiler::EmitEntry(u32 startpc)
+{
+	if (!m_enabled)
+		return NULL;
+
+	BlockProfile* profile = Find(startpc);
+
+	// Block entry, all the registers are free
+	xADD(ptr32[&((u32*)&profile->visits)[0]], 1);
+	xADC(ptr32[&((u32*)&profile->visits)[1]], 0);
+
+	if (m_ticks)
+		xFastCall(BlockProfilerEnter, (const void*)profile);
+
+	return profile;
+}
+
+void BlockProfiler::Compiled(BlockProfile* profile, u32 size, u32 x86size)
+{
+	if (!profile)
+		return;
+
+	profile->size = size;
+	profile->x86size = x86size;
+	profile->compiles++;
+}
+
+void BlockProfiler::Invalidated(u32 startpc)
+{
+	if (!m_enabled)
+		return;
+
+	auto it = m_bypc.find(startpc);
+	if (it != m_bypc.end())
+		it->second->invalidations++;
+}
+
+void BlockProfiler::Report(uint count)
+{
+	if (!m_enabled || m_profiles.empty())
+		return;
+
+	// Don't charge the pause to the last block
+	s_current = NULL;
+
+	std::vector<const BlockProfile*> sorted;
+	sorted.reserve(m_profiles.size());
+
+	u64 visits = 0, ticks = 0;
+	for (const BlockProfile& profile : m_profiles) {
+		visits += profile.visits;
+		ticks += profile.ticks;
+		sorted.push_back(&profile);
+	}
+
+	const bool byticks = m_ticks && ticks;
+	std::sort(sorted.begin(), sorted.end(), [byticks](const BlockProfile* a, const BlockProfile* b) {
+		return byticks ? a->ticks > b->ticks : a->visits > b->visits;
+	});
+
+	Console.WriteLn(Color_StrongBlack, "%s block profile (%u blocks, %llu visits, %llu ticks):",
+		m_name, (uint)m_profiles.size(), (unsigned long long)visits, (unsigned long long)ticks);
+
+	ConsoleIndentScope indent;
+
+	Console.WriteLn("      pc    size  x86size       visits          ticks   ticks%%  compiles  invalidations");
+	for (uint i = 0; i < std::min<uint>(count, sorted.size()); i++) {
+		const BlockProfile* p = sorted[i];
+		if (!p->visits)
+			break;
+
+		Console.WriteLn("%08x %7u %8u %12llu %14llu %7.2f%% %9u %14u",
+			p->startpc, p->size, p->x86size, (unsigned long long)p->visits, (unsigned long long)p->ticks,
+			ticks ? 100.0 * p->ticks / ticks : 0.0, p->compiles, p->invalidations);
+	}
+}
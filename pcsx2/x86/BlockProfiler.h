@@ -0,0 +1,86 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2015  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+
+// Statistics of a guest block, kept by startpc so they survive the block being
+// invalidated and recompiled.
+struct BlockProfile
+{
+	u64 visits;			// incremented by the block itself
+	u64 ticks;			// host ticks from the block entry to the next block entry
+	u32 startpc;
+	u32 size;			// in instructions, of the last compile
+	u32 x86size;		// of the last compile
+	u32 compiles;
+	u32 invalidations;	// blocks cleared by recClear (self modifying code, DMA...)
+};
+
+// --------------------------------------------------------------------------------------
+//  BlockProfiler
+// --------------------------------------------------------------------------------------
+// Opt-in per-block profiling of a recompiler (see the BlockProfiler* recompiler options).
+//
+// When enabled, every block starts with a 64 bits visit counter increment and, in tick
+// mode, a call which charges the time since the previous block entry (of any profiled
+// cpu) to that previous block.  Ticks are therefore inclusive of the dispatcher, event
+// tests and whatever the block called into.
+//
+// Reports are printed when the recompiler leaves execution (pausing the emulation), so
+// the profile of a scene can be taken by pausing on it.
+class BlockProfiler
+{
+	DeclareNoncopyableObject( BlockProfiler );
+
+	const char* m_name;
+	bool m_enabled;
+	bool m_ticks;
+
+	// deque: the entries are referenced by the recompiled code and must never move
+	std::deque<BlockProfile> m_profiles;
+	std::unordered_map<u32, BlockProfile*> m_bypc;
+
+	BlockProfile* Find(u32 startpc);
+
+public:
+	BlockProfiler(const char* name);
+
+	bool IsEnabled() const { return m_enabled; }
+
+	// Counters are kept across recompiler resets, they're only lost when the profiler is
+	// disabled or cleared.
+	void Enable(bool enabled, bool ticks);
+	void Clear();
+
+	// Called at the start of a block, emits the counters
+	BlockProfile* EmitEntry(u32 startpc);
+	void Compiled(BlockProfile* profile, u32 size, u32 x86size);
+	void Invalidated(u32 startpc);
+
+	void Report(uint count = 50);
+};
+
+namespace EE
+{
+	extern BlockProfiler BlockProfiles;
+}
+
+namespace IOP
+{
+	extern BlockProfiler BlockProfiles;
+}
@@ -22,6 +22,7 @@
 
 #include "iR3000A.h"
 #include "BaseblockEx.h"
+#include "BlockProfiler.h"
 #include "System/RecTypes.h"
 
 #include <time.h>
@@ -668,6 +669,8 @@ void recResetIOP()
 	recAlloc();
 	recMem->Reset();
 
+	IOP::BlockProfiles.Enable(EmuConfig.Cpu.Recompiler.BlockProfilerIOP, EmuConfig.Cpu.Recompiler.BlockProfilerTicks);
+
 	iopClearRecLUT((BASEBLOCK*)m_recBlockAlloc,
 		(((Ps2MemSize::IopRam + Ps2MemSize::Rom + Ps2MemSize::Rom1) / 4)));
 
@@ -782,36 +785,44 @@ static __fi u32 psxRecClearMem(u32 pc)
 	pc = HWADDR(pc);
 
 	u32 lowerextent = pc, upperextent = pc + 4;
-	int blockidx = recBlocks.Index(pc);
-	pxAssert(blockidx != -1);
-
-	while (BASEBLOCKEX* pexblock = recBlocks[blockidx - 1]) {
-		if (pexblock->startpc + pexblock->size * 4 <= lowerextent)
-			break;
-
-		lowerextent = std::min(lowerextent, pexblock->startpc);
-		blockidx--;
-	}
+	BASEBLOCKEX* first = recBlocks.Get(pc);
+	BASEBLOCKEX* last = NULL;
+	pxAssert(first);
+
+	// Nothing to remove without a block at pc, only the LUT entry is reset
+	if (first) {
+		while (BASEBLOCKEX* pexblock = recBlocks.Prev(first)) {
+			if (pexblock->startpc + pexblock->size * 4 <= lowerextent)
+				break;
 
-	int toRemoveFirst = blockidx;
+			lowerextent = std::min(lowerextent, pexblock->startpc);
+			first = pexblock;
+		}
 
-	while (BASEBLOCKEX* pexblock = recBlocks[blockidx]) {
-		if (pexblock->startpc >= upperextent)
-			break;
+		for (BASEBLOCKEX* pexblock = first; pexblock; pexblock = recBlocks.Next(pexblock)) {
+			if (pexblock->startpc >= upperextent)
+				break;
 
-		lowerextent = std::min(lowerextent, pexblock->startpc);
-		upperextent = std::max(upperextent, pexblock->startpc + pexblock->size * 4);
+			lowerextent = std::min(lowerextent, pexblock->startpc);
+			upperextent = std::max(upperextent, pexblock->startpc + pexblock->size * 4);
 
-		blockidx++;
+			last = pexblock;
+		}
 	}
 
-	if(toRemoveFirst != blockidx) {
-		recBlocks.Remove(toRemoveFirst, (blockidx - 1));
+	if (last) {
+		for (BASEBLOCKEX* pexblock = first; pexblock != recBlocks.Next(last); pexblock = recBlocks.Next(pexblock))
+			IOP::BlockProfiles.Invalidated(pexblock->startpc);
+
+		recBlocks.Remove(first, last);
 	}
 
-	blockidx=0;
-	while(BASEBLOCKEX* pexblock = recBlocks[blockidx++])
+	// Only blocks starting within GetReach() of pc can contain it.
+	for (BASEBLOCKEX* pexblock = recBlocks.Last(pc); pexblock; pexblock = recBlocks.Prev(pexblock))
 	{
+		if (pexblock->startpc + recBlocks.GetReach() <= pc)
+			break;
+
 		if (pc >= pexblock->startpc && pc < pexblock->startpc + pexblock->size * 4) {
 			DevCon.Error("Impossible block clearing failure");
 			pxFailDev( "Impossible block clearing failure" );
@@ -1116,6 +1127,8 @@ static void __fastcall iopRecRecompile( const u32 startpc )
 		xFastCall(PreBlockCheck, psxpc);
 	}
 
+	BlockProfile* profile = IOP::BlockProfiles.EmitEntry(HWADDR(startpc));
+
 	// go until the next branch
 	i = startpc;
 	s_nEndBlock = 0xffffffff;
@@ -1237,7 +1250,7 @@ StartRecomp:
 		iIopDumpBlock(startpc, recPtr);
 
 	pxAssert( (psxpc-startpc)>>2 <= 0xffff );
-	s_pCurBlockEx->size = (psxpc-startpc)>>2;
+	recBlocks.SetSize(s_pCurBlockEx, (psxpc-startpc)>>2);
 
 	for(i = 1; i < (u32)s_pCurBlockEx->size; ++i) {
 		if (s_pCurBlock[i].GetFnptr() == (uptr)iopJITCompile)
@@ -1275,6 +1288,7 @@ StartRecomp:
 
 	pxAssert(xGetPtr() - recPtr < _64kb);
 	s_pCurBlockEx->x86size = xGetPtr() - recPtr;
+	IOP::BlockProfiles.Compiled(profile, s_pCurBlockEx->size, s_pCurBlockEx->x86size);
 
 	Perf::iop.map(s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size, s_pCurBlockEx->startpc);
 
@@ -22,6 +22,7 @@
 #include "R5900OpcodeTables.h"
 #include "iR5900.h"
 #include "BaseblockEx.h"
+#include "BlockProfiler.h"
 #include "System/RecTypes.h"
 
 #include "vtlb.h"
@@ -586,6 +587,10 @@ static void recResetRaw()
 
 	recMem->Reset();
 	ClearRecLUT((BASEBLOCK*)recLutReserve_RAM, recLutSize);
+
+	// No code references the profiles anymore, they can be dropped if disabled.
+	EE::BlockProfiles.Enable(EmuConfig.Cpu.Recompiler.BlockProfilerEE, EmuConfig.Cpu.Recompiler.BlockProfilerTicks);
+	Perf::enable(EmuConfig.Cpu.Recompiler.PerfMap);
 	memset(recRAMCopy, 0, Ps2MemSize::MainRam);
 
 	maxrecmem = 0;
@@ -724,6 +729,8 @@ static void recExecute()
 #endif
 
 	EE::Profiler.Print();
+	EE::BlockProfiles.Report();
+	IOP::BlockProfiles.Report();
 }
 
 ////////////////////////////////////////////////////
@@ -765,29 +772,24 @@ void recClear(u32 addr, u32 size)
 		return;
 	addr = HWADDR(addr);
 
-	int blockidx = recBlocks.LastIndex(addr + size * 4 - 4);
+	BASEBLOCKEX* pexblock = recBlocks.Last(addr + size * 4 - 4);
 
-	if (blockidx == -1)
+	if (!pexblock)
 		return;
 
 	u32 lowerextent = (u32)-1, upperextent = 0, ceiling = (u32)-1;
 
-	BASEBLOCKEX* pexblock = recBlocks[blockidx + 1];
-	if (pexblock)
-		ceiling = pexblock->startpc;
-
-	int toRemoveLast = blockidx;
+	if (BASEBLOCKEX* next = recBlocks.Next(pexblock))
+		ceiling = next->startpc;
 
-	while (pexblock = recBlocks[blockidx]) {
+	while (pexblock) {
+		BASEBLOCKEX* prev = recBlocks.Prev(pexblock);
 		u32 blockstart = pexblock->startpc;
 		u32 blockend = pexblock->startpc + pexblock->size * 4;
 		BASEBLOCK* pblock = PC_GETBLOCK(blockstart);
 
 		if (pblock == s_pCurBlock) {
-			if(toRemoveLast != blockidx) {
-				recBlocks.Remove((blockidx + 1), toRemoveLast);
-			}
-			toRemoveLast = --blockidx;
+			pexblock = prev;
 			continue;
 		}
 
@@ -802,16 +804,17 @@ void recClear(u32 addr, u32 size)
 		// so set it to recompile now.  This will become JITCompile if we clear it.
 		pblock->SetFnptr((uptr)JITCompileInBlock);
 
-		blockidx--;
-	}
-
-	if(toRemoveLast != blockidx) {
-		recBlocks.Remove((blockidx + 1), toRemoveLast);
+		EE::BlockProfiles.Invalidated(blockstart);
+		recBlocks.Remove(pexblock);
+		pexblock = prev;
 	}
 
 	upperextent = std::min(upperextent, ceiling);
 
-	for (int i = 0; pexblock = recBlocks[i]; i++) {
+	// Only blocks starting within GetReach() of the range can overlap it.
+	for (pexblock = recBlocks.Last(addr + size * 4 - 4); pexblock; pexblock = recBlocks.Prev(pexblock)) {
+		if (pexblock->startpc + recBlocks.GetReach() <= addr)
+			break;
 		if (s_pCurBlock == PC_GETBLOCK(pexblock->startpc))
 			continue;
 		u32 blockend = pexblock->startpc + pexblock->size * 4;
@@ -1642,6 +1645,8 @@ static void __fastcall recRecompile( const u32 startpc )
 		xFastCall(PreBlockCheck, pc);
 	}
 
+	BlockProfile* profile = EE::BlockProfiles.EmitEntry(HWADDR(startpc));
+
 	if (EmuConfig.Gamefixes.GoemonTlbHack) {
 		if (pc == 0x33ad48 || pc == 0x35060c) {
 			// 0x33ad48 and 0x35060c are the return address of the function (0x356250) that populate the TLB cache
@@ -1953,14 +1958,12 @@ StartRecomp:
 #endif
 
 	pxAssert( (pc-startpc)>>2 <= 0xffff );
-	s_pCurBlockEx->size = (pc-startpc)>>2;
+	recBlocks.SetSize(s_pCurBlockEx, (pc-startpc)>>2);
 
 	if (HWADDR(pc) <= Ps2MemSize::MainRam) {
 		BASEBLOCKEX *oldBlock;
-		int i;
 
-		i = recBlocks.LastIndex(HWADDR(pc) - 4);
-		while (oldBlock = recBlocks[i--]) {
+		for (oldBlock = recBlocks.Last(HWADDR(pc) - 4); oldBlock; oldBlock = recBlocks.Prev(oldBlock)) {
 			if (oldBlock == s_pCurBlockEx)
 				continue;
 			if (oldBlock->startpc >= HWADDR(pc))
@@ -2034,6 +2037,7 @@ StartRecomp:
 
 	pxAssert(xGetPtr() - recPtr < _64kb);
 	s_pCurBlockEx->x86size = xGetPtr() - recPtr;
+	EE::BlockProfiles.Compiled(profile, s_pCurBlockEx->size, s_pCurBlockEx->x86size);
 
 #if 0
 	// Example: Dump both x86/EE code
@@ -76,6 +76,8 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 	// Restore reserve to uncommitted state
 	if (resetReserve) mVU.cache_reserve->Reset();
 
+	mVUdbReset(mVU);
+
 	if (mVU.index) Perf::any.map((uptr)&mVU.dispCache, mVUdispCacheSize, "mVU1 Dispatcher");
 	else           Perf::any.map((uptr)&mVU.dispCache, mVUdispCacheSize, "mVU0 Dispatcher");
 	
@@ -121,6 +123,8 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 // Free Allocated Resources
 void mVUclose(microVU& mVU) {
 
+	mVUdbClose(mVU);
+
 	safe_delete  (mVU.cache_reserve);
 	SafeSysMunmap(mVU.dispCache, mVUdispCacheSize);
 
@@ -137,6 +141,7 @@ void mVUclose(microVU& mVU) {
 
 // Clears Block Data in specified range
 __fi void mVUclear(mV, u32 addr, u32 size) {
+	mVUdbClear(mVU);
 	if(!mVU.prog.cleared) {
 		mVU.prog.cleared = 1;		// Next execution searches/creates a new microprogram
 		memzero(mVU.prog.lpState); // Clear pipeline state
@@ -388,6 +393,11 @@ void recMicroVU1::SetCacheReserve(uint reserveInMegs) const {
 	mVUreserveCache(microVU1); // Need rec-reset after this
 }
 
+bool recMicroVU1::Precompile() {
+	pxAssert(m_Reserved); // please allocate me first! :|
+	return mVUprecompile<1>();
+}
+
 void recMicroVU1::ResumeXGkick() {
 	pxAssert(m_Reserved); // please allocate me first! :|
 
@@ -23,6 +23,8 @@ using namespace x86Emitter;
 #include <deque>
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include "Common.h"
 #include "VU.h"
 #include "MTVU.h"
@@ -30,6 +32,8 @@ using namespace x86Emitter;
 #include "Gif_Unit.h"
 #include "iR5900.h"
 #include "R5900OpcodeTables.h"
+#include "Elfheader.h"
+#include "AppConfig.h"
 #include "System/RecTypes.h"
 #include "x86emitter/x86emitter.h"
 #include "microVU_Misc.h"
@@ -278,6 +282,7 @@ void sortVector(T& v) {
 #include "microVU_Tables.inl"
 #include "microVU_Flags.inl"
 #include "microVU_Branch.inl"
+#include "microVU_Database.inl"
 #include "microVU_Compile.inl"
 #include "microVU_Execute.inl"
 #include "microVU_Macro.inl"
@@ -663,8 +663,8 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState) {
 // Returns the entry point of the block (compiles it if not found)
 __fi void* mVUentryGet(microVU& mVU, microBlockManager* block, u32 startPC, uptr pState) {
 	microBlock* pBlock = block->search((microRegInfo*)pState);
-	if (pBlock) return pBlock->x86ptrStart;
-	else	 {  return mVUcompile(mVU, startPC, pState);}
+	if (pBlock) { mVUdbCheckHit(mVU, pBlock->x86ptrStart); return pBlock->x86ptrStart; }
+	else	 {  mVUdbRecord(mVU, startPC, pState); return mVUcompile(mVU, startPC, pState);}
 }
 
  // Search for Existing Compiled Block (if found, return x86ptr; else, compile and return x86ptr)
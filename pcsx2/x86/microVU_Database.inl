@@ -0,0 +1,238 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Micro VU - Program Database
+//------------------------------------------------------------------
+// Remembers which entry points (start PC and pipeline state) were compiled for each
+// micro memory image, per game, and saves them next to the ini files.  On the next
+// boot, once a known image has been uploaded, the MTVU thread compiles those entry
+// points while it would otherwise be waiting for work, so the VU program doesn't
+// stall on the recompiler the first time it runs.
+//
+// The blocks are looked up by pipeline state like any other, so a recorded state
+// which doesn't happen again only costs some cache space.
+
+static const u32 mVUdbVersion = 1;
+
+struct microProgEntry {
+	u64 hash;									// Hash of the whole micro memory
+	u32 startPC;
+	u32 pState[sizeof(microRegInfo) / 4];		// Unaligned copy, see mVUprecompile()
+};
+
+struct microProgDatabase {
+	std::unordered_map<u64, std::vector<microProgEntry>> progs; // Entries by micro memory hash
+	std::unordered_set<void*> precompiled;		// Precompiled entry points which haven't run yet
+	std::vector<microProgEntry>* todo;			// Entries of the current image left to precompile
+	size_t	todoPos;
+	u32		crc;								// Game the entries belong to
+	u64		hash;								// Hash of the current micro memory
+	bool	hashValid;
+	bool	loaded;
+	bool	dirty;								// New entries since loaded
+	bool	pending;							// Micro memory changed since last looked up
+	bool	precompiling;
+	bool	compiled;							// A block was compiled by the current precompile
+	u32		statPrecompiled;					// Blocks compiled ahead of time
+	u32		statHits;							// ...which were then run
+	u32		statMisses;							// Blocks compiled while running
+};
+
+static microProgDatabase mVUdatabase[2];
+
+__fi microProgDatabase& mVUdb(microVU& mVU) { return mVUdatabase[mVU.index]; }
+
+static wxString mVUdbFilename(microVU& mVU, u32 crc) {
+	return (GetSettingsFolder() + pxsFmt(L"microVU%d_%08X.db", mVU.index, crc)).GetFullPath();
+}
+
+static u64 mVUdbHashMicro(microVU& mVU) {
+	const u64* data = (u64*)mVU.regs().Micro;
+	u64 hash = 0xcbf29ce484222325ull;
+	for (u32 i = 0; i < mVU.microMemSize / 8; i++) {
+		hash = (hash ^ data[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static void mVUdbPrintStats(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (!db.statPrecompiled && !db.statMisses) return;
+	DevCon.WriteLn(mVU.index ? Color_Orange : Color_Magenta,
+		"microVU%d: Precompiled %d blocks, %d were run, %d compiled while running [CRC=%08X]",
+		mVU.index, db.statPrecompiled, db.statHits, db.statMisses, db.crc);
+}
+
+static void mVUdbSave(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (!db.dirty || !db.crc) return;
+	db.dirty = false;
+
+	wxFFile file(mVUdbFilename(mVU, db.crc), L"wb");
+	if (!file.IsOpened()) return;
+
+	u32 header[4] = { 0x6244566d /* mVDb */, mVUdbVersion, mVU.index, sizeof(microProgEntry) };
+	file.Write(header, sizeof(header));
+	for (auto it = db.progs.begin(); it != db.progs.end(); ++it) {
+		if (!it->second.empty()) file.Write(&it->second[0], it->second.size() * sizeof(microProgEntry));
+	}
+}
+
+static void mVUdbLoad(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (!db.crc || !wxFileExists(mVUdbFilename(mVU, db.crc))) return;
+
+	wxFFile file(mVUdbFilename(mVU, db.crc), L"rb");
+	if (!file.IsOpened()) return;
+
+	u32 header[4];
+	if (file.Read(header, sizeof(header)) != sizeof(header) || header[0] != 0x6244566d
+	|| header[1] != mVUdbVersion || header[2] != mVU.index || header[3] != sizeof(microProgEntry)) {
+		Console.Warning("microVU%d: Ignoring outdated program database", mVU.index);
+		return;
+	}
+
+	microProgEntry entry;
+	while (file.Read(&entry, sizeof(entry)) == sizeof(entry)) {
+		db.progs[entry.hash].push_back(entry);
+	}
+	DevCon.WriteLn(mVU.index ? Color_Orange : Color_Magenta, "microVU%d: Loaded %d known programs [CRC=%08X]",
+				   mVU.index, (int)db.progs.size(), db.crc);
+}
+
+// Switches to the database of the running game (if it changed)
+static void mVUdbCheckGame(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (db.loaded && db.crc == ElfCRC) return;
+
+	mVUdbPrintStats(mVU);
+	mVUdbSave(mVU);
+	db.progs.clear();
+	db.precompiled.clear();
+	db.todo    = NULL;
+	db.todoPos = 0;
+	db.statPrecompiled = db.statHits = db.statMisses = 0;
+
+	db.crc     = ElfCRC; // The BIOS runs with no CRC and isn't recorded
+	db.loaded  = true;
+	db.pending = true;
+	mVUdbLoad(mVU);
+}
+
+static u64 mVUdbCurrentHash(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (!db.hashValid) {
+		db.hash      = mVUdbHashMicro(mVU);
+		db.hashValid = true;
+	}
+	return db.hash;
+}
+
+// Micro memory was written to
+__fi void mVUdbClear(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	db.hashValid = false;
+	db.pending   = true;
+}
+
+// Rec cache was reset, all compiled code is gone
+static void mVUdbReset(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	mVUdbSave(mVU);
+	db.precompiled.clear();
+	db.todo    = NULL;
+	db.todoPos = 0;
+	db.pending = true;
+}
+
+static void mVUdbClose(microVU& mVU) {
+	microProgDatabase& db = mVUdb(mVU);
+	mVUdbPrintStats(mVU);
+	mVUdbSave(mVU);
+	db.progs.clear();
+	db.precompiled.clear();
+	db.todo   = NULL;
+	db.loaded = false;
+}
+
+// Called whenever a block is compiled by mVUentryGet()
+static void mVUdbRecord(microVU& mVU, u32 startPC, uptr pState) {
+	if (!EmuConfig.Cpu.Recompiler.MicroVUPrecompile) return;
+	microProgDatabase& db = mVUdb(mVU);
+
+	if (db.precompiling) { db.compiled = true; db.statPrecompiled++; }
+	else                 { mVUdbCheckGame(mVU); db.statMisses++; }
+	if (!db.crc) return;
+
+	std::vector<microProgEntry>& list = db.progs[mVUdbCurrentHash(mVU)];
+	for (size_t i = 0; i < list.size(); i++) {
+		if (list[i].startPC == startPC && !memcmp(list[i].pState, (void*)pState, sizeof(microRegInfo)))
+			return;
+	}
+
+	microProgEntry entry;
+	entry.hash    = db.hash;
+	entry.startPC = startPC;
+	memcpy(entry.pState, (void*)pState, sizeof(microRegInfo));
+	list.push_back(entry);
+	db.dirty = true;
+}
+
+// Called whenever mVUentryGet() finds an existing block
+__fi void mVUdbCheckHit(microVU& mVU, void* x86ptr) {
+	microProgDatabase& db = mVUdb(mVU);
+	if (!db.precompiled.empty() && db.precompiled.erase(x86ptr)) db.statHits++;
+}
+
+// Compiles one entry point which is expected for the current micro memory.
+// Returns false when there's nothing left to do.
+_mVUt bool mVUprecompile() {
+	microVU& mVU = mVUx;
+	microProgDatabase& db = mVUdb(mVU);
+	if (!EmuConfig.Cpu.Recompiler.MicroVUPrecompile) return false;
+
+	if (db.pending) {
+		db.pending = false;
+		mVUdbCheckGame(mVU);
+		auto it    = db.progs.find(mVUdbCurrentHash(mVU));
+		db.todo    = (it != db.progs.end()) ? &it->second : NULL;
+		db.todoPos = 0;
+	}
+	if (!db.todo || db.todoPos >= db.todo->size()) return false;
+
+	// Entries are appended to while compiling, so copy the one being compiled
+	microProgEntry entry = (*db.todo)[db.todoPos++];
+	__aligned16 microRegInfo pState;
+	memcpy(&pState, entry.pState, sizeof(pState));
+
+	db.precompiling = true;
+	db.compiled     = false;
+	xSetPtr(mVU.prog.x86ptr);
+	void* x86ptr = mVUsearchProg<vuIndex>(entry.startPC, (uptr)&pState);
+	mVU.prog.x86ptr = x86Ptr;
+	db.precompiling = false;
+
+	if (db.compiled) db.precompiled.insert(x86ptr);
+
+	if ((xGetPtr() < mVU.prog.x86start) || (xGetPtr() >= mVU.prog.x86end)) {
+		Console.WriteLn(vuIndex ? Color_Orange : Color_Magenta, "microVU%d: Program cache limit reached.", mVU.index);
+		mVUreset(mVU, false);
+		return false;
+	}
+	return true;
+}
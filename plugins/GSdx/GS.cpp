@@ -25,6 +25,8 @@
 #include "GSRendererSW.h"
 #include "GSRendererNull.h"
 #include "GSDeviceNull.h"
+#include "GSDeviceSW.h"
+#include "GSWndNull.h"
 #include "GSDeviceOGL.h"
 #include "GSRendererOGL.h"
 #include "GSRendererCL.h"
@@ -975,6 +977,169 @@ EXPORT_C GSsetFrameLimit(int limit)
 	}
 }
 
+// clock() counts in ms on Windows and in us (of cpu time) on linux
+static int GSBenchmarkRate(float n, clock_t ticks)
+{
+	return (int)(n * CLOCKS_PER_SEC / std::max<clock_t>(ticks, 1) / 1000000);
+}
+
+// Transfer and texture read rates of every format, in MB/s and Mpixels/s:
+// write image | read image | read texture | read texture with palette (8/4/8H/4HL/4HH)
+
+static void GSBenchmarkLocalMemory()
+{
+	printf("%s\n\n", GSUtil::GetLibName());
+
+	GSLocalMemory* mem = new GSLocalMemory();
+
+	static struct {int psm; const char* name;} s_format[] =
+	{
+		{PSM_PSMCT32, "32"},
+		{PSM_PSMCT24, "24"},
+		{PSM_PSMCT16, "16"},
+		{PSM_PSMCT16S, "16S"},
+		{PSM_PSMT8, "8"},
+		{PSM_PSMT4, "4"},
+		{PSM_PSMT8H, "8H"},
+		{PSM_PSMT4HL, "4HL"},
+		{PSM_PSMT4HH, "4HH"},
+		{PSM_PSMZ32, "32Z"},
+		{PSM_PSMZ24, "24Z"},
+		{PSM_PSMZ16, "16Z"},
+		{PSM_PSMZ16S, "16ZS"},
+	};
+
+	uint8* ptr = (uint8*)_aligned_malloc(1024 * 1024 * 4, 32);
+
+	for(int i = 0; i < 1024 * 1024 * 4; i++) ptr[i] = (uint8)i;
+
+	//
+
+	for(int tbw = 5; tbw <= 10; tbw++)
+	{
+		int n = 256 << ((10 - tbw) * 2);
+
+		int w = 1 << tbw;
+		int h = 1 << tbw;
+
+		printf("%d x %d\n\n", w, h);
+
+		for(size_t i = 0; i < countof(s_format); i++)
+		{
+			const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[s_format[i].psm];
+
+			GSLocalMemory::writeImage wi = psm.wi;
+			GSLocalMemory::readImage ri = psm.ri;
+			GSLocalMemory::readTexture rtx = psm.rtx;
+			GSLocalMemory::readTexture rtxP = psm.rtxP;
+
+			GIFRegBITBLTBUF BITBLTBUF;
+
+			BITBLTBUF.SBP = 0;
+			BITBLTBUF.SBW = w / 64;
+			BITBLTBUF.SPSM = s_format[i].psm;
+			BITBLTBUF.DBP = 0;
+			BITBLTBUF.DBW = w / 64;
+			BITBLTBUF.DPSM = s_format[i].psm;
+
+			GIFRegTRXPOS TRXPOS;
+
+			TRXPOS.SSAX = 0;
+			TRXPOS.SSAY = 0;
+			TRXPOS.DSAX = 0;
+			TRXPOS.DSAY = 0;
+
+			GIFRegTRXREG TRXREG;
+
+			TRXREG.RRW = w;
+			TRXREG.RRH = h;
+
+			GSVector4i r(0, 0, w, h);
+
+			GIFRegTEX0 TEX0;
+
+			TEX0.TBP0 = 0;
+			TEX0.TBW = w / 64;
+
+			GIFRegTEXA TEXA;
+
+			TEXA.TA0 = 0;
+			TEXA.TA1 = 0x80;
+			TEXA.AEM = 0;
+
+			int trlen = w * h * psm.trbpp / 8;
+			int len = w * h * psm.bpp / 8;
+
+			clock_t start, end;
+
+			printf("[%4s] ", s_format[i].name);
+
+			start = clock();
+
+			for(int j = 0; j < n; j++)
+			{
+				int x = 0;
+				int y = 0;
+
+				(mem->*wi)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
+			}
+
+			end = clock();
+
+			printf("%6d %6d | ", GSBenchmarkRate((float)trlen * n, end - start), GSBenchmarkRate((float)(w * h) * n, end - start));
+
+			start = clock();
+
+			for(int j = 0; j < n; j++)
+			{
+				int x = 0;
+				int y = 0;
+
+				(mem->*ri)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
+			}
+
+			end = clock();
+
+			printf("%6d %6d | ", GSBenchmarkRate((float)trlen * n, end - start), GSBenchmarkRate((float)(w * h) * n, end - start));
+
+			const GSOffset* off = mem->GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
+
+			start = clock();
+
+			for(int j = 0; j < n; j++)
+			{
+				(mem->*rtx)(off, r, ptr, w * 4, TEXA);
+			}
+
+			end = clock();
+
+			printf("%6d %6d ", GSBenchmarkRate((float)len * n, end - start), GSBenchmarkRate((float)(w * h) * n, end - start));
+
+			if(psm.pal > 0)
+			{
+				start = clock();
+
+				for(int j = 0; j < n; j++)
+				{
+					(mem->*rtxP)(off, r, ptr, w, TEXA);
+				}
+
+				end = clock();
+
+				printf("| %6d %6d ", GSBenchmarkRate((float)len * n, end - start), GSBenchmarkRate((float)(w * h) * n, end - start));
+			}
+
+			printf("\n");
+		}
+
+		printf("\n");
+	}
+
+	_aligned_free(ptr);
+
+	delete mem;
+}
+
 #ifdef _WIN32
 
 #include <io.h>
@@ -1300,215 +1465,374 @@ EXPORT_C GSBenchmark(HWND hwnd, HINSTANCE hinst, LPSTR lpszCmdLine, int nCmdShow
 
 	if(1)
 	{
-		GSLocalMemory* mem = new GSLocalMemory();		
+		GSBenchmarkLocalMemory();
+	}
 
-		static struct {int psm; const char* name;} s_format[] =
-		{
-			{PSM_PSMCT32, "32"},
-			{PSM_PSMCT24, "24"},
-			{PSM_PSMCT16, "16"},
-			{PSM_PSMCT16S, "16S"},
-			{PSM_PSMT8, "8"},
-			{PSM_PSMT4, "4"},
-			{PSM_PSMT8H, "8H"},
-			{PSM_PSMT4HL, "4HL"},
-			{PSM_PSMT4HH, "4HH"},
-			{PSM_PSMZ32, "32Z"},
-			{PSM_PSMZ24, "24Z"},
-			{PSM_PSMZ16, "16Z"},
-			{PSM_PSMZ16S, "16ZS"},
-		};
+	//
+
+	if(0)
+	{
+		GSLocalMemory* mem = new GSLocalMemory();
 
 		uint8* ptr = (uint8*)_aligned_malloc(1024 * 1024 * 4, 32);
 
 		for(int i = 0; i < 1024 * 1024 * 4; i++) ptr[i] = (uint8)i;
 
-		//
+		const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[PSM_PSMCT32];
 
-		for(int tbw = 5; tbw <= 10; tbw++)
-		{
-			int n = 256 << ((10 - tbw) * 2);
+		GSLocalMemory::writeImage wi = psm.wi;
 
-			int w = 1 << tbw;
-			int h = 1 << tbw;
+		GIFRegBITBLTBUF BITBLTBUF;
 
-			printf("%d x %d\n\n", w, h);
+		BITBLTBUF.DBP = 0;
+		BITBLTBUF.DBW = 32;
+		BITBLTBUF.DPSM = PSM_PSMCT32;
 
-			for(size_t i = 0; i < countof(s_format); i++)
-			{
-				const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[s_format[i].psm];
+		GIFRegTRXPOS TRXPOS;
 
-				GSLocalMemory::writeImage wi = psm.wi;
-				GSLocalMemory::readImage ri = psm.ri;
-				GSLocalMemory::readTexture rtx = psm.rtx;
-				GSLocalMemory::readTexture rtxP = psm.rtxP;
+		TRXPOS.DSAX = 0;
+		TRXPOS.DSAY = 1;
 
-				GIFRegBITBLTBUF BITBLTBUF;
+		GIFRegTRXREG TRXREG;
 
-				BITBLTBUF.SBP = 0;
-				BITBLTBUF.SBW = w / 64;
-				BITBLTBUF.SPSM = s_format[i].psm;
-				BITBLTBUF.DBP = 0;
-				BITBLTBUF.DBW = w / 64;
-				BITBLTBUF.DPSM = s_format[i].psm;
+		TRXREG.RRW = 256;
+		TRXREG.RRH = 256;
 
-				GIFRegTRXPOS TRXPOS;
+		int trlen = 256 * 256 * psm.trbpp / 8;
 
-				TRXPOS.SSAX = 0;
-				TRXPOS.SSAY = 0;
-				TRXPOS.DSAX = 0;
-				TRXPOS.DSAY = 0;
+		int x = 0;
+		int y = 0;
 
-				GIFRegTRXREG TRXREG;
+		(mem->*wi)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
 
-				TRXREG.RRW = w;
-				TRXREG.RRH = h;
+		delete mem;
+	}
 
-				GSVector4i r(0, 0, w, h);
+	//
 
-				GIFRegTEX0 TEX0;
+	PostQuitMessage(0);
+}
 
-				TEX0.TBP0 = 0;
-				TEX0.TBW = w / 64;
+#endif
 
-				GIFRegTEXA TEXA;
+#ifdef __linux__
 
-				TEXA.TA0 = 0;
-				TEXA.TA1 = 0x80;
-				TEXA.AEM = 0;
+#include <sys/time.h>
+#include <sys/timeb.h>	// ftime(), struct timeb
+#include "GSLzma.h"
 
-				int trlen = w * h * psm.trbpp / 8;
-				int len = w * h * psm.bpp / 8;
+inline unsigned long timeGetTime()
+{
+	timeb t;
+	ftime(&t);
 
-				clock_t start, end;
+	return (unsigned long)(t.time*1000 + t.millitm);
+}
 
-				printf("[%4s] ", s_format[i].name);
+inline uint64 timeGetTimeUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-				start = clock();
+	return (uint64)ts.tv_sec * 1000000 + (uint64)ts.tv_nsec / 1000;
+}
 
-				for(int j = 0; j < n; j++)
-				{
-					int x = 0;
-					int y = 0;
+// Headless replay: the software rasterizer draws into GSDeviceSW memory, there is
+// no X display nor GL context so it can run on build hosts without a GPU.
+static int _GSopenHeadless(int w, int h, int threads)
+{
+	delete s_gs;
 
-					(mem->*wi)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
-				}
+	s_gs = new GSRendererSW(threads);
+	s_renderer = GSRendererType::OGL_SW;
+	s_renderer_name = " Headless";
+	s_renderer_type = " SW";
 
-				end = clock();
+	printf("Current Renderer: Headless (Software mode)\n");
 
-				printf("%6d %6d | ", (int)((float)trlen * n / (end - start) / 1000), (int)((float)(w * h) * n / (end - start) / 1000));
+	s_gs->SetRegsMem(s_basemem);
+	s_gs->SetIrqCallback(s_irq);
+	s_gs->SetVSync(false);
+	s_gs->SetFrameLimit(false);
 
-				start = clock();
+	s_gs->m_wnd = new GSWndNull();
+	s_gs->m_wnd->Create("", w, h);
 
-				for(int j = 0; j < n; j++)
-				{
-					int x = 0;
-					int y = 0;
+	if(!s_gs->CreateDevice(new GSDeviceSW()))
+	{
+		GSclose();
 
-					(mem->*ri)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
-				}
+		return -1;
+	}
 
-				end = clock();
+	return 0;
+}
 
-				printf("%6d %6d | ", (int)((float)trlen * n / (end - start) / 1000), (int)((float)(w * h) * n / (end - start) / 1000));
+// Per frame statistics of the replay. Output is either CSV or JSON (one object by
+// line). Counters are the GSPerfMon values accumulated during the frame, timers are
+// raw rdtsc ticks.
+class GSReplayStats
+{
+	FILE* m_fp;
+	int m_format;
+	int m_workers;
+	uint64 m_time;
+	double m_counters[GSPerfMon::CounterLast];
+	uint64 m_ticks[GSPerfMon::TimerLast];
 
-				const GSOffset* off = mem->GetOffset(TEX0.TBP0, TEX0.TBW, TEX0.PSM);
+	static const char* CounterName(int c)
+	{
+		static const char* s_names[] = {"frame", "prim", "draw", "swizzle", "unswizzle", "fillrate", "quad", "syncpoint", "wakeup", "park", 
+			"sync0", "sync1", "sync2", "sync3", "sync4", "sync5", "sync6", "sync7", "pagewait", "unswizzlejobs"};
 
-				start = clock();
+		return s_names[c];
+	}
 
-				for(int j = 0; j < n; j++)
-				{
-					(mem->*rtx)(off, r, ptr, w * 4, TEXA);
-				}
+public:
+	enum {StatsNone, StatsCSV, StatsJSON};
 
-				end = clock();
+	GSReplayStats(int format, const string& filename, int workers)
+		: m_fp(NULL)
+		, m_format(format)
+		, m_workers(std::min<int>(std::max<int>(workers, 1), 16))
+		, m_time(0)
+	{
+		if(m_format == StatsNone) return;
 
-				printf("%6d %6d ", (int)((float)len * n / (end - start) / 1000), (int)((float)(w * h) * n / (end - start) / 1000));
+		m_fp = filename.empty() ? stdout : fopen(filename.c_str(), "w");
 
-				if(psm.pal > 0)
-				{
-					start = clock();
+		if(m_fp == NULL)
+		{
+			fprintf(stderr, "Failed to open %s, replay stats are disabled\n", filename.c_str());
 
-					for(int j = 0; j < n; j++)
-					{
-						(mem->*rtxP)(off, r, ptr, w, TEXA);
-					}
+			m_format = StatsNone;
+		}
+		else if(m_format == StatsCSV)
+		{
+			fprintf(m_fp, "loop,frame,us");
 
-					end = clock();
+			for(int i = GSPerfMon::Prim; i < GSPerfMon::CounterLast; i++)
+			{
+				fprintf(m_fp, ",%s", CounterName(i));
+			}
 
-					printf("| %6d %6d ", (int)((float)len * n / (end - start) / 1000), (int)((float)(w * h) * n / (end - start) / 1000));
-				}
+			fprintf(m_fp, ",main,sync");
 
-				printf("\n");
+			for(int i = 0; i < m_workers; i++)
+			{
+				fprintf(m_fp, ",worker%d", i);
 			}
 
-			printf("\n");
+			fprintf(m_fp, "\n");
 		}
+	}
 
-		_aligned_free(ptr);
-
-		delete mem;
+	~GSReplayStats()
+	{
+		if(m_fp != NULL && m_fp != stdout) fclose(m_fp);
+		else if(m_fp != NULL) fflush(m_fp);
 	}
 
-	//
+	void Begin(GSPerfMon& pm)
+	{
+		if(m_format == StatsNone) return;
 
-	if(0)
+		for(int i = 0; i < GSPerfMon::CounterLast; i++)
+		{
+			m_counters[i] = pm.GetTotal((GSPerfMon::counter_t)i);
+		}
+
+		for(int i = 0; i < GSPerfMon::TimerLast; i++)
+		{
+			m_ticks[i] = pm.GetTicks(i);
+		}
+
+		m_time = timeGetTimeUs();
+	}
+
+	void Frame(GSPerfMon& pm, int loop, unsigned long frame)
 	{
-		GSLocalMemory* mem = new GSLocalMemory();
+		if(m_format == StatsNone) return;
 
-		uint8* ptr = (uint8*)_aligned_malloc(1024 * 1024 * 4, 32);
+		uint64 now = timeGetTimeUs();
 
-		for(int i = 0; i < 1024 * 1024 * 4; i++) ptr[i] = (uint8)i;
+		double counters[GSPerfMon::CounterLast];
+		uint64 ticks[GSPerfMon::TimerLast];
 
-		const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[PSM_PSMCT32];
+		for(int i = 0; i < GSPerfMon::CounterLast; i++)
+		{
+			double total = pm.GetTotal((GSPerfMon::counter_t)i);
 
-		GSLocalMemory::writeImage wi = psm.wi;
+			counters[i] = total - m_counters[i];
+			m_counters[i] = total;
+		}
 
-		GIFRegBITBLTBUF BITBLTBUF;
+		for(int i = 0; i < GSPerfMon::TimerLast; i++)
+		{
+			uint64 total = pm.GetTicks(i);
 
-		BITBLTBUF.DBP = 0;
-		BITBLTBUF.DBW = 32;
-		BITBLTBUF.DPSM = PSM_PSMCT32;
+			ticks[i] = total - m_ticks[i];
+			m_ticks[i] = total;
+		}
 
-		GIFRegTRXPOS TRXPOS;
+		if(m_format == StatsCSV)
+		{
+			fprintf(m_fp, "%d,%lu,%llu", loop, frame, (unsigned long long)(now - m_time));
 
-		TRXPOS.DSAX = 0;
-		TRXPOS.DSAY = 1;
+			for(int i = GSPerfMon::Prim; i < GSPerfMon::CounterLast; i++)
+			{
+				fprintf(m_fp, ",%.0f", counters[i]);
+			}
 
-		GIFRegTRXREG TRXREG;
+			for(int i = GSPerfMon::Main; i < GSPerfMon::WorkerDraw0 + m_workers; i++)
+			{
+				fprintf(m_fp, ",%llu", (unsigned long long)ticks[i]);
+			}
 
-		TRXREG.RRW = 256;
-		TRXREG.RRH = 256;
+			fprintf(m_fp, "\n");
+		}
+		else
+		{
+			fprintf(m_fp, "{\"loop\":%d,\"frame\":%lu,\"us\":%llu", loop, frame, (unsigned long long)(now - m_time));
 
-		int trlen = 256 * 256 * psm.trbpp / 8;
+			for(int i = GSPerfMon::Prim; i < GSPerfMon::CounterLast; i++)
+			{
+				fprintf(m_fp, ",\"%s\":%.0f", CounterName(i), counters[i]);
+			}
 
-		int x = 0;
-		int y = 0;
+			fprintf(m_fp, ",\"main\":%llu,\"sync\":%llu,\"workers\":[", (unsigned long long)ticks[GSPerfMon::Main], (unsigned long long)ticks[GSPerfMon::Sync]);
 
-		(mem->*wi)(x, y, ptr, trlen, BITBLTBUF, TRXPOS, TRXREG);
+			for(int i = 0; i < m_workers; i++)
+			{
+				fprintf(m_fp, i == 0 ? "%llu" : ",%llu", (unsigned long long)ticks[GSPerfMon::WorkerDraw0 + i]);
+			}
 
-		delete mem;
+			fprintf(m_fp, "]}\n");
+		}
+
+		m_time = now;
 	}
+};
 
-	//
+// Plays the packets of the dump once, returns the number of frames
+static unsigned long _GSreplayPackets(GSDumpFile* file, vector<uint8>& buff, uint8* regs, GSReplayStats& replay_stats, int loop)
+{
+	unsigned long frame_number = 0;
 
-	PostQuitMessage(0);
-}
+	GSDumpPacket p;
 
-#endif
+	// Path1 expects the data at the end of the 16KB VU1 memory, and may read all of it
+	vector<uint8> vu1(0x4000);
 
-#ifdef __linux__
+	while(file->NextPacket(p))
+	{
+		switch(p.type)
+		{
+			case 0:
 
-#include <sys/time.h>
-#include <sys/timeb.h>	// ftime(), struct timeb
-#include "GSLzma.h"
+				switch(p.param)
+				{
+					case 0:
+						memset(&vu1[0], 0, 0x4000 - p.size);
+						memcpy(&vu1[0x4000 - p.size], p.data, p.size);
+						GSgifTransfer1(&vu1[0], 0x4000 - p.size);
+						break;
+					case 1: GSgifTransfer2(const_cast<uint8*>(p.data), p.size / 16); break;
+					case 2: GSgifTransfer3(const_cast<uint8*>(p.data), p.size / 16); break;
+					case 3: GSgifTransfer(const_cast<uint8*>(p.data), p.size / 16); break;
+				}
 
-inline unsigned long timeGetTime()
+				break;
+
+			case 1:
+
+				GSvsync(p.param);
+				replay_stats.Frame(s_gs->m_perfmon, loop, frame_number);
+				frame_number++;
+
+				break;
+
+			case 2:
+
+				if(buff.size() < p.size) buff.resize(p.size);
+
+				GSreadFIFO2(&buff[0], p.size / 16);
+
+				break;
+
+			case 3:
+
+				memcpy(regs, p.data, 0x2000);
+
+				break;
+		}
+	}
+
+	return frame_number;
+}
+
+// Replays the dump with the software renderer and 0, 1, 2, 4... up to max_threads extra
+// rendering threads, each time from the initial state, and prints how the frame time scales.
+static void _GSreplayScaling(GSDumpFile* file, uint32 crc, const vector<uint8>& state, const uint8* initial_regs, uint8* regs, int max_threads)
 {
-	timeb t;
-	ftime(&t);
+	vector<uint8> buff;
+	vector<int> threads;
 
-	return (unsigned long)(t.time*1000 + t.millitm);
+	threads.push_back(0);
+
+	for(int i = 1; i < max_threads; i *= 2)
+	{
+		threads.push_back(i);
+	}
+
+	threads.push_back(max_threads);
+
+	GSReplayStats replay_stats(GSReplayStats::StatsNone, "", 0);
+
+	float base = 0;
+
+	fprintf(stderr, "\nthreads, ms/frame, speedup\n");
+
+	for(auto i = threads.begin(); i != threads.end(); i++)
+	{
+		if(_GSopenHeadless(theApp.GetConfig("ModeWidth", 0), theApp.GetConfig("ModeHeight", 0), *i) != 0)
+		{
+			fprintf(stderr, "Error failed to GSopen\n");
+
+			return;
+		}
+
+		GSsetGameCRC(crc, 0);
+
+		GSFreezeData fd;
+		fd.size = state.size();
+		fd.data = const_cast<uint8*>(state.data());
+
+		GSfreeze(FREEZE_LOAD, &fd);
+
+		memcpy(regs, initial_regs, 0x2000);
+
+		GSvsync(1);
+
+		// one pass to warm up the caches and the JIT, then the measured one
+
+		for(int pass = 0; pass < 2; pass++)
+		{
+			file->Rewind();
+
+			unsigned long start = timeGetTime();
+			unsigned long frame_number = std::max(1ul, _GSreplayPackets(file, buff, regs, replay_stats, pass));
+			unsigned long end = timeGetTime();
+
+			if(pass == 0) continue;
+
+			float ms = (float)(end - start) / (float)frame_number;
+
+			if(base == 0) base = ms;
+
+			fprintf(stderr, "%d, %f, %.2fx\n", *i, ms, ms > 0 ? base / ms : 0.0f);
+		}
+	}
 }
 
 // Note
@@ -1522,15 +1846,15 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 	// alternatively:
 	// m_renderer = static_cast<GSRendererType>(renderer);
 
-	if (m_renderer != GSRendererType::OGL_HW && m_renderer != GSRendererType::OGL_SW)
+	bool headless = !!theApp.GetConfig("linux_replay_headless", 0);
+
+	if (!headless && m_renderer != GSRendererType::OGL_HW && m_renderer != GSRendererType::OGL_SW)
 	{
 		fprintf(stderr, "wrong renderer selected %d\n", static_cast<int>(m_renderer));
 		return;
 	}
 
-	struct Packet {uint8 type, param; uint32 size, addr; vector<uint8> buff;};
-
-	list<Packet*> packets;
+	GSDumpFile* file = NULL;
 	vector<uint8> buff;
 	vector<float> stats;
 	stats.clear();
@@ -1544,94 +1868,57 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 
 	void* hWnd = NULL;
 
-	int err = _GSopen((void**)&hWnd, "", m_renderer);
+	int err = headless
+		? _GSopenHeadless(theApp.GetConfig("ModeWidth", 0), theApp.GetConfig("ModeHeight", 0), theApp.GetConfig("extrathreads", DEFAULT_EXTRA_RENDERING_THREADS))
+		: _GSopen((void**)&hWnd, "", m_renderer);
 	if (err != 0) {
 		fprintf(stderr, "Error failed to GSopen\n");
 		return;
 	}
 	if (s_gs->m_wnd == NULL) return;
 
-	{ // Read .gs content
+	uint32 crc;
+	vector<uint8> state;
+	uint8 initial_regs[0x2000];
+
+	{ // Read .gs header, packets are streamed during the replay
 		std::string f(lpszCmdLine);
 #ifdef LZMA_SUPPORTED
-		GSDumpFile* file = (f.size() >= 4) && (f.compare(f.size()-3, 3, ".xz") == 0)
+		file = (f.size() >= 4) && (f.compare(f.size()-3, 3, ".xz") == 0)
 			? (GSDumpFile*) new GSDumpLzma(lpszCmdLine)
 			: (GSDumpFile*) new GSDumpRaw(lpszCmdLine);
 #else
-		GSDumpFile* file = new GSDumpRaw(lpszCmdLine);
+		file = new GSDumpRaw(lpszCmdLine);
 #endif
 
-		uint32 crc;
 		file->Read(&crc, 4);
 		GSsetGameCRC(crc, 0);
 
 		GSFreezeData fd;
 		file->Read(&fd.size, 4);
-		fd.data = new uint8[fd.size];
+		state.resize(fd.size);
+		fd.data = state.data();
 		file->Read(fd.data, fd.size);
 
 		GSfreeze(FREEZE_LOAD, &fd);
-		delete [] fd.data;
 
 		file->Read(regs, 0x2000);
+		memcpy(initial_regs, regs, 0x2000);
 
 		GSvsync(1);
+	}
 
+	int scaling = theApp.GetConfig("linux_replay_scaling", 0);
 
-		while(!file->IsEof())
-		{
-			uint8 type;
-			file->Read(&type, 1);
-
-			Packet* p = new Packet();
-
-			p->type = type;
-
-			switch(type)
-			{
-			case 0:
-				file->Read(&p->param, 1);
-				file->Read(&p->size, 4);
-
-				switch(p->param)
-				{
-				case 0:
-					p->buff.resize(0x4000);
-					p->addr = 0x4000 - p->size;
-					file->Read(&p->buff[p->addr], p->size);
-					break;
-				case 1:
-				case 2:
-				case 3:
-					p->buff.resize(p->size);
-					file->Read(&p->buff[0], p->size);
-					break;
-				}
-
-				break;
-
-			case 1:
-				file->Read(&p->param, 1);
-
-				break;
-
-			case 2:
-				file->Read(&p->size, 4);
-
-				break;
-
-			case 3:
-				p->buff.resize(0x2000);
+	if (headless && scaling > 0) {
+		_GSreplayScaling(file, crc, state, initial_regs, regs, scaling);
 
-				file->Read(&p->buff[0], 0x2000);
-
-				break;
-			}
+		delete file;
 
-			packets.push_back(p);
-		}
+		GSclose();
+		GSshutdown();
 
-		delete file;
+		return;
 	}
 
 	sleep(1);
@@ -1645,53 +1932,29 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 	}
 	unsigned long frame_number = 0;
 	unsigned long total_frame_nb = 0;
+	int loop = 0;
+	bool replayed = false;
+
+	GSReplayStats replay_stats(theApp.GetConfig("linux_replay_stats", 0), theApp.GetConfig("linux_replay_stats_file", ""),
+		theApp.GetConfig("extrathreads", DEFAULT_EXTRA_RENDERING_THREADS));
+
 	while(finished > 0)
 	{
-		frame_number = 0;
 		unsigned long start = timeGetTime();
-		for(auto i = packets.begin(); i != packets.end(); i++)
-		{
-			Packet* p = *i;
-
-			switch(p->type)
-			{
-				case 0:
-
-					switch(p->param)
-					{
-						case 0: GSgifTransfer1(&p->buff[0], p->addr); break;
-						case 1: GSgifTransfer2(&p->buff[0], p->size / 16); break;
-						case 2: GSgifTransfer3(&p->buff[0], p->size / 16); break;
-						case 3: GSgifTransfer(&p->buff[0], p->size / 16); break;
-					}
-
-					break;
-
-				case 1:
-
-					GSvsync(p->param);
-					frame_number++;
-
-					break;
-
-				case 2:
 
-					if(buff.size() < p->size) buff.resize(p->size);
+		replay_stats.Begin(s_gs->m_perfmon);
 
-					GSreadFIFO2(&buff[0], p->size / 16);
+		if (replayed)
+			file->Rewind();
 
-					break;
+		replayed = true;
 
-				case 3:
-
-					memcpy(regs, &p->buff[0], 0x2000);
-
-					break;
-			}
-		}
+		frame_number = _GSreplayPackets(file, buff, regs, replay_stats, loop);
 
 		// Ensure the rendering is complete to measure correctly the time.
-		glFinish();
+		// (the software renderer already waits for its workers on each vsync)
+		if (!headless)
+			glFinish();
 
 		if (finished > 90) {
 			sleep(1);
@@ -1706,6 +1969,7 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 
 			finished--;
 			total_frame_nb += frame_number;
+			loop++;
 		}
 	}
 
@@ -1739,17 +2003,17 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 		   );
 #endif
 
-	for(auto i = packets.begin(); i != packets.end(); i++)
-	{
-		delete *i;
-	}
-
-	packets.clear();
+	delete file;
 
 	sleep(1);
 
 	GSclose();
 	GSshutdown();
 }
+
+EXPORT_C GSBenchmark(char* lpszCmdLine)
+{
+	GSBenchmarkLocalMemory();
+}
 #endif
 
@@ -330,6 +330,39 @@ public:
 
 		// TODO: pshufb
 
+		#if _M_SSE >= 0x501
+
+		// the same swaps as below, rows 0 and 1 in v0, rows 2 and 3 in v1
+
+		GSVector4i v4 = GSVector4i::load<alignment != 0>(&src[srcpitch * 0]);
+		GSVector4i v5 = GSVector4i::load<alignment != 0>(&src[srcpitch * 1]);
+		GSVector4i v6 = GSVector4i::load<alignment != 0>(&src[srcpitch * 2]);
+		GSVector4i v7 = GSVector4i::load<alignment != 0>(&src[srcpitch * 3]);
+
+		GSVector8i v0(v4, v5);
+		GSVector8i v1(v6, v7);
+
+		if((i & 1) == 0)
+		{
+			v1 = v1.yxwzlh();
+		}
+		else
+		{
+			v0 = v0.yxwzlh();
+		}
+
+		GSVector8i::sw4(v0, v1);
+		GSVector8i::sw8(v0, v1);
+		GSVector8i::sw8(v0, v1);
+
+		v0 = v0.acbd();
+		v1 = v1.acbd();
+
+		((GSVector8i*)dst)[i * 2 + 0] = v0;
+		((GSVector8i*)dst)[i * 2 + 1] = v1;
+
+		#else
+
 		GSVector4i v0 = GSVector4i::load<alignment != 0>(&src[srcpitch * 0]);
 		GSVector4i v1 = GSVector4i::load<alignment != 0>(&src[srcpitch * 1]);
 		GSVector4i v2 = GSVector4i::load<alignment != 0>(&src[srcpitch * 2]);
@@ -355,6 +388,8 @@ public:
 		((GSVector4i*)dst)[i * 4 + 1] = v1;
 		((GSVector4i*)dst)[i * 4 + 2] = v2;
 		((GSVector4i*)dst)[i * 4 + 3] = v3;
+
+		#endif
 	}
 
 	template<int alignment, uint32 mask> static void WriteColumn32(int y, uint8* RESTRICT dst, const uint8* RESTRICT src, int srcpitch)
@@ -554,29 +589,42 @@ public:
 	{
 		//for(int j = 0; j < 64; j++) ((uint8*)src)[j] = (uint8)j;
 
-		#if 0//_M_SSE >= 0x501
+		#if _M_SSE >= 0x501
+
+		// the same swaps as below, two registers per vector
 
 		const GSVector8i* s = (const GSVector8i*)src;
-		
-		GSVector8i v0 = s[i * 2 + 0];
-		GSVector8i v1 = s[i * 2 + 1];
 
-		GSVector8i::sw8(v0, v1);
-		GSVector8i::sw16(v0, v1);
-		GSVector8i::sw8(v0, v1);
+		GSVector8i v0, v1;
+
+		if((i & 1) == 0)
+		{
+			v0 = s[i * 2 + 0];
+			v1 = s[i * 2 + 1];
+		}
+		else
+		{
+			v0 = s[i * 2 + 1];
+			v1 = s[i * 2 + 0];
+		}
+
+		GSVector8i mask(m_r8mask, m_r8mask);
+
+		v0 = v0.shuffle8(mask);
+		v1 = v1.shuffle8(mask);
+
 		GSVector8i::sw128(v0, v1);
 		GSVector8i::sw16(v0, v1);
 
-		v0 = v0.acbd();
-		v1 = v1.acbd();
-		v1 = v1.yxwz();
+		GSVector8i v2 = v0.ad(v1);
+		GSVector8i v3 = v0.bc(v1);
 
-		GSVector8i::storel(&dst[dstpitch * 0], v0);
-		GSVector8i::storeh(&dst[dstpitch * 1], v0);
-		GSVector8i::storel(&dst[dstpitch * 2], v1);
-		GSVector8i::storeh(&dst[dstpitch * 3], v1);
+		GSVector8i::sw32(v2, v3);
 
-		// TODO: not sure if this is worth it, not in this form, there should be a shorter path
+		GSVector8i::storel(&dst[dstpitch * 0], v2);
+		GSVector8i::storel(&dst[dstpitch * 1], v3);
+		GSVector8i::storeh(&dst[dstpitch * 2], v2);
+		GSVector8i::storeh(&dst[dstpitch * 3], v3);
 
 		#elif _M_SSE >= 0x301
 
@@ -649,7 +697,42 @@ public:
 	{
 		//printf("ReadColumn4\n");
 
-		#if _M_SSE >= 0x301
+		#if _M_SSE >= 0x501
+
+		// the same swaps as below, two registers per vector
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i v0 = s[i * 2 + 0].xzyw();
+		GSVector8i v1 = s[i * 2 + 1].xzyw();
+
+		GSVector8i::sw128(v0, v1);
+		GSVector8i::sw64(v0, v1);
+		GSVector8i::sw4(v0, v1);
+		GSVector8i::sw8(v0, v1);
+
+		GSVector8i mask(m_r4mask, m_r4mask);
+
+		v0 = v0.shuffle8(mask);
+		v1 = v1.shuffle8(mask);
+
+		GSVector8i::sw128(v0, v1);
+
+		if((i & 1) == 0)
+		{
+			GSVector8i::sw16rh(v0, v1);
+		}
+		else
+		{
+			GSVector8i::sw16rl(v0, v1);
+		}
+
+		GSVector8i::storel(&dst[dstpitch * 0], v0);
+		GSVector8i::storeh(&dst[dstpitch * 1], v0);
+		GSVector8i::storel(&dst[dstpitch * 2], v1);
+		GSVector8i::storeh(&dst[dstpitch * 3], v1);
+
+		#elif _M_SSE >= 0x301
 
 		const GSVector4i* s = (const GSVector4i*)src;
 
@@ -1191,6 +1274,17 @@ public:
 		#endif
 	}
 
+	#if _M_SSE >= 0x501
+
+	// 16 entry palette lookup, the low 3 bits of idx select the entry from lo and hi, and hi is taken where sel is negative
+
+	__forceinline static GSVector8i Lookup16(const GSVector8i& idx, const GSVector8i& sel, const GSVector8i& lo, const GSVector8i& hi)
+	{
+		return lo.permute32(idx).blend8(hi.permute32(idx), sel.sra32(31));
+	}
+
+	#endif
+
 	__forceinline static void ExpandBlock8_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
 	{
 		for(int j = 0; j < 16; j++, dst += dstpitch)
@@ -1225,6 +1319,17 @@ public:
 
 	__forceinline static void ExpandBlock8H_32(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
 	{
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		for(int j = 0; j < 8; j++, dst += dstpitch)
+		{
+			GSVector8i::store<false>(dst, (s[j] >> 24).gather32_32(pal));
+		}
+
+		#else
+
 		for(int j = 0; j < 8; j++, dst += dstpitch)
 		{
 			const GSVector4i* s = (const GSVector4i*)src;
@@ -1232,6 +1337,8 @@ public:
 			((GSVector4i*)dst)[0] = (s[j * 2 + 0] >> 24).gather32_32<>(pal);
 			((GSVector4i*)dst)[1] = (s[j * 2 + 1] >> 24).gather32_32<>(pal);
 		}
+
+		#endif
 	}
 
 	__forceinline static void ExpandBlock8H_16(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
@@ -1260,6 +1367,20 @@ public:
 
 	__forceinline static void ExpandBlock4HL_32(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
 	{
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i lo = GSVector8i::load<false>(&pal[0]);
+		GSVector8i hi = GSVector8i::load<false>(&pal[8]);
+
+		for(int j = 0; j < 8; j++, dst += dstpitch)
+		{
+			GSVector8i::store<false>(dst, Lookup16(s[j] >> 24, s[j] << 4, lo, hi));
+		}
+
+		#else
+
 		for(int j = 0; j < 8; j++, dst += dstpitch)
 		{
 			const GSVector4i* s = (const GSVector4i*)src;
@@ -1267,6 +1388,8 @@ public:
 			((GSVector4i*)dst)[0] = ((s[j * 2 + 0] >> 24) & 0xf).gather32_32<>(pal);
 			((GSVector4i*)dst)[1] = ((s[j * 2 + 1] >> 24) & 0xf).gather32_32<>(pal);
 		}
+
+		#endif
 	}
 
 	__forceinline static void ExpandBlock4HL_16(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
@@ -1295,6 +1418,20 @@ public:
 
 	__forceinline static void ExpandBlock4HH_32(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
 	{
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i lo = GSVector8i::load<false>(&pal[0]);
+		GSVector8i hi = GSVector8i::load<false>(&pal[8]);
+
+		for(int j = 0; j < 8; j++, dst += dstpitch)
+		{
+			GSVector8i::store<false>(dst, Lookup16(s[j] >> 28, s[j], lo, hi));
+		}
+
+		#else
+
 		for(int j = 0; j < 8; j++, dst += dstpitch)
 		{
 			const GSVector4i* s = (const GSVector4i*)src;
@@ -1302,6 +1439,8 @@ public:
 			((GSVector4i*)dst)[0] = (s[j * 2 + 0] >> 28).gather32_32<>(pal);
 			((GSVector4i*)dst)[1] = (s[j * 2 + 1] >> 28).gather32_32<>(pal);
 		}
+
+		#endif
 	}
 
 	__forceinline static void ExpandBlock4HH_16(uint32* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
@@ -2068,7 +2207,30 @@ public:
 	{
 		//printf("ReadAndExpandBlock8H_32\n");
 
-		#if _M_SSE >= 0x401
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i v0, v1;
+
+		for(int i = 0; i < 4; i++)
+		{
+			v0 = s[i * 2 + 0];
+			v1 = s[i * 2 + 1];
+
+			GSVector8i::sw128(v0, v1);
+			GSVector8i::sw64(v0, v1);
+
+			GSVector8i::store<false>(dst, (v0 >> 24).gather32_32(pal));
+
+			dst += dstpitch;
+
+			GSVector8i::store<false>(dst, (v1 >> 24).gather32_32(pal));
+
+			dst += dstpitch;
+		}
+
+		#elif _M_SSE >= 0x401
 
 		const GSVector4i* s = (const GSVector4i*)src;
 
@@ -2111,7 +2273,33 @@ public:
 	{
 		//printf("ReadAndExpandBlock4HL_32\n");
 
-		#if _M_SSE >= 0x401
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i v0, v1;
+
+		GSVector8i lo = GSVector8i::load<false>(&pal[0]);
+		GSVector8i hi = GSVector8i::load<false>(&pal[8]);
+
+		for(int i = 0; i < 4; i++)
+		{
+			v0 = s[i * 2 + 0];
+			v1 = s[i * 2 + 1];
+
+			GSVector8i::sw128(v0, v1);
+			GSVector8i::sw64(v0, v1);
+
+			GSVector8i::store<false>(dst, Lookup16(v0 >> 24, v0 << 4, lo, hi));
+
+			dst += dstpitch;
+
+			GSVector8i::store<false>(dst, Lookup16(v1 >> 24, v1 << 4, lo, hi));
+
+			dst += dstpitch;
+		}
+
+		#elif _M_SSE >= 0x401
 
 		const GSVector4i* s = (const GSVector4i*)src;
 
@@ -2154,7 +2342,33 @@ public:
 	{
 		//printf("ReadAndExpandBlock4HH_32\n");
 
-		#if _M_SSE >= 0x401
+		#if _M_SSE >= 0x501
+
+		const GSVector8i* s = (const GSVector8i*)src;
+
+		GSVector8i v0, v1;
+
+		GSVector8i lo = GSVector8i::load<false>(&pal[0]);
+		GSVector8i hi = GSVector8i::load<false>(&pal[8]);
+
+		for(int i = 0; i < 4; i++)
+		{
+			v0 = s[i * 2 + 0];
+			v1 = s[i * 2 + 1];
+
+			GSVector8i::sw128(v0, v1);
+			GSVector8i::sw64(v0, v1);
+
+			GSVector8i::store<false>(dst, Lookup16(v0 >> 28, v0, lo, hi));
+
+			dst += dstpitch;
+
+			GSVector8i::store<false>(dst, Lookup16(v1 >> 28, v1, lo, hi));
+
+			dst += dstpitch;
+		}
+
+		#elif _M_SSE >= 0x401
 
 		const GSVector4i* s = (const GSVector4i*)src;
 
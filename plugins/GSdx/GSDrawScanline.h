@@ -86,5 +86,9 @@ public:
 
 #endif
 
-	void PrintStats() {m_ds_map.PrintStats();}
+	void PrintStats() {m_sp_map.PrintStats(); m_ds_map.PrintStats();}
+
+	void GetSelectors(vector<uint64>& sp, vector<uint64>& ds) {m_sp_map.GetActiveKeys(sp); m_ds_map.GetActiveKeys(ds);}
+	void PrecompileSetupPrim(uint64 key) {m_sp_map.Precompile(key);}
+	void PrecompileDrawScanline(uint64 key) {m_ds_map.Precompile(key);}
 };
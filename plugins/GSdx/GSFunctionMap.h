@@ -84,6 +84,14 @@ public:
 		return m_active->f;
 	}
 
+	void GetActiveKeys(vector<KEY>& keys) const
+	{
+		for(typename hash_map<KEY, ActivePtr*>::const_iterator i = m_map_active.begin(); i != m_map_active.end(); i++)
+		{
+			keys.push_back(i->first);
+		}
+	}
+
 	void UpdateStats(uint64 frame, uint64 ticks, int actual, int total)
 	{
 		if(m_active)
@@ -162,80 +170,114 @@ class GSCodeGeneratorFunctionMap : public GSFunctionMap<KEY, VALUE>
 	hash_map<uint64, VALUE> m_cgmap;
 	GSCodeBuffer m_cb;
 
+	// Precompile may run on another thread, while the drawing thread looks up new keys.
+	std::mutex m_lock;
+
+	uint64 m_cold; // generated when first drawn with, this is the stutter
+	uint64 m_warm; // found already precompiled
+
 	enum {MAX_SIZE = 8192};
 
-public:
-	GSCodeGeneratorFunctionMap(const char* name, void* param)
-		: m_name(name)
-		, m_param(param)
+	VALUE Generate(KEY key)
 	{
-	}
+		CG* cg = new CG(m_param, key, m_cb.GetBuffer(MAX_SIZE), MAX_SIZE);
 
-	VALUE GetDefaultFunction(KEY key)
-	{
-		VALUE ret = NULL;
+		ASSERT(cg->getSize() < MAX_SIZE);
 
-		typename hash_map<uint64, VALUE>::iterator i = m_cgmap.find(key);
+		m_cb.ReleaseBuffer(cg->getSize());
 
-		if(i != m_cgmap.end())
-		{
-			ret = i->second;
-		}
-		else
-		{
-			CG* cg = new CG(m_param, key, m_cb.GetBuffer(MAX_SIZE), MAX_SIZE);
+		VALUE ret = (VALUE)cg->getCode();
+
+		m_cgmap[key] = ret;
+
+		#ifdef ENABLE_VTUNE
 
-			ASSERT(cg->getSize() < MAX_SIZE);
+		// vtune method registration
 
-			m_cb.ReleaseBuffer(cg->getSize());
+		// if(iJIT_IsProfilingActive()) // always > 0
+		{
+			string name = format("%s<%016llx>()", m_name.c_str(), (uint64)key);
 
-			ret = (VALUE)cg->getCode();
+			iJIT_Method_Load ml;
 
-			m_cgmap[key] = ret;
+			memset(&ml, 0, sizeof(ml));
 
-			#ifdef ENABLE_VTUNE
+			ml.method_id = iJIT_GetNewMethodID();
+			ml.method_name = (char*)name.c_str();
+			ml.method_load_address = (void*)cg->getCode();
+			ml.method_size = (unsigned int)cg->getSize();
 
-			// vtune method registration
+			iJIT_NotifyEvent(iJVM_EVENT_TYPE_METHOD_LOAD_FINISHED, &ml);
+/*
+			name = format("c:/temp1/%s_%016llx.bin", m_name.c_str(), (uint64)key);
 
-			// if(iJIT_IsProfilingActive()) // always > 0
+			if(FILE* fp = fopen(name.c_str(), "wb"))
 			{
-				string name = format("%s<%016llx>()", m_name.c_str(), (uint64)key);
+				fputc(0x0F, fp); fputc(0x0B, fp);
+				fputc(0xBB, fp); fputc(0x6F, fp); fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp);
+				fputc(0x64, fp); fputc(0x67, fp); fputc(0x90, fp);
 
-				iJIT_Method_Load ml;
+				fwrite(cg->getCode(), cg->getSize(), 1, fp);
 
-				memset(&ml, 0, sizeof(ml));
+				fputc(0xBB, fp); fputc(0xDE, fp); fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp);
+				fputc(0x64, fp); fputc(0x67, fp); fputc(0x90, fp);
+				fputc(0x0F, fp); fputc(0x0B, fp);
 
-				ml.method_id = iJIT_GetNewMethodID();
-				ml.method_name = (char*)name.c_str();
-				ml.method_load_address = (void*)cg->getCode();
-				ml.method_size = (unsigned int)cg->getSize();
+				fclose(fp);
+			}
+*/
+		}
 
-				iJIT_NotifyEvent(iJVM_EVENT_TYPE_METHOD_LOAD_FINISHED, &ml);
-/*
-				name = format("c:/temp1/%s_%016llx.bin", m_name.c_str(), (uint64)key);
+		#endif
 
-				if(FILE* fp = fopen(name.c_str(), "wb"))
-				{
-					fputc(0x0F, fp); fputc(0x0B, fp);
-					fputc(0xBB, fp); fputc(0x6F, fp); fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp);
-					fputc(0x64, fp); fputc(0x67, fp); fputc(0x90, fp);
+		delete cg;
 
-					fwrite(cg->getCode(), cg->getSize(), 1, fp);
+		return ret;
+	}
+
+public:
+	GSCodeGeneratorFunctionMap(const char* name, void* param)
+		: m_name(name)
+		, m_param(param)
+		, m_cold(0)
+		, m_warm(0)
+	{
+	}
 
-					fputc(0xBB, fp); fputc(0xDE, fp); fputc(0x00, fp); fputc(0x00, fp); fputc(0x00, fp);
-					fputc(0x64, fp); fputc(0x67, fp); fputc(0x90, fp);
-					fputc(0x0F, fp); fputc(0x0B, fp);
+	VALUE GetDefaultFunction(KEY key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
 
-					fclose(fp);
-				}
-*/
-			}
+		typename hash_map<uint64, VALUE>::iterator i = m_cgmap.find(key);
+
+		if(i != m_cgmap.end())
+		{
+			m_warm++;
+
+			return i->second;
+		}
+
+		m_cold++;
+
+		return Generate(key);
+	}
 
-			#endif
+	// Generates the code of a key before it's drawn with, it's picked up by the first lookup.
 
-			delete cg;
+	void Precompile(KEY key)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		if(this->m_map.find(key) == this->m_map.end() && m_cgmap.find(key) == m_cgmap.end())
+		{
+			Generate(key);
 		}
+	}
 
-		return ret;
+	void PrintStats()
+	{
+		GSFunctionMap<KEY, VALUE>::PrintStats();
+
+		printf("%s: %llu generated while drawing, %llu precompiled\n", m_name.c_str(), m_cold, m_warm);
 	}
 };
@@ -23,6 +23,9 @@
 
 #ifdef __linux__
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 GSDumpFile::GSDumpFile(char* filename) {
 	m_fp = fopen(filename, "rb");
 	if (m_fp == NULL) {
@@ -36,11 +39,67 @@ GSDumpFile::~GSDumpFile() {
 		fclose(m_fp);
 }
 
+bool GSDumpFile::ReadPacketPayload(GSDumpPacket& p, vector<uint8>& buff) {
+	p.param = 0;
+	p.size  = 0;
+	p.data  = NULL;
+
+	switch (p.type) {
+		case 0:
+			Read(&p.param, 1);
+			Read(&p.size, 4);
+			break;
+		case 1:
+			Read(&p.param, 1);
+			break;
+		case 2:
+			Read(&p.size, 4);
+			return true; // size of the FIFO read back, no payload
+		case 3:
+			p.size = 0x2000;
+			break;
+		default:
+			fprintf(stderr, "GSDumpFile:: unknown packet type %d\n", p.type);
+			return false;
+	}
+
+	if (p.size) {
+		if (buff.size() < p.size) buff.resize(p.size);
+		Read(&buff[0], p.size);
+		p.data = &buff[0];
+	}
+
+	return true;
+}
+
 /******************************************************************/
 #ifdef LZMA_SUPPORTED
 
 GSDumpLzma::GSDumpLzma(char* filename) : GSDumpFile(filename) {
 
+	m_buff_size = 1024*1024;
+	m_area      = (uint8_t*)_aligned_malloc(m_buff_size, 32);
+	m_inbuf     = (uint8_t*)_aligned_malloc(BUFSIZ, 32);
+
+	m_packet_start = 0;
+
+	m_head   = 0;
+	m_tail   = 0;
+	m_count  = 0;
+	m_bytes  = 0;
+	m_held   = false;
+	m_done   = false;
+	m_exit   = false;
+	m_thread = NULL;
+
+	memset(&m_strm, 0, sizeof(lzma_stream));
+
+	InitDecoder();
+}
+
+void GSDumpLzma::InitDecoder() {
+	lzma_end(&m_strm);
+
 	memset(&m_strm, 0, sizeof(lzma_stream));
 
 	lzma_ret ret = lzma_stream_decoder(&m_strm, UINT32_MAX, 0);
@@ -50,11 +109,9 @@ GSDumpLzma::GSDumpLzma(char* filename) : GSDumpFile(filename) {
 		throw "BAD"; // Just exit the program
 	}
 
-	m_buff_size = 1024*1024;
-	m_area      = (uint8_t*)_aligned_malloc(m_buff_size, 32);
-	m_inbuf     = (uint8_t*)_aligned_malloc(BUFSIZ, 32);
 	m_avail     = 0;
 	m_start     = 0;
+	m_pos       = 0;
 
 	m_strm.avail_in  = 0;
 	m_strm.next_in   = m_inbuf;
@@ -102,6 +159,9 @@ bool GSDumpLzma::IsEof() {
 void GSDumpLzma::Read(void* ptr, size_t size) {
 	size_t off = 0;
 	uint8_t* dst = (uint8_t*)ptr;
+
+	m_pos += size;
+
 	while (size) {
 		if (m_avail == 0) {
 			Decompress();
@@ -116,7 +176,135 @@ void GSDumpLzma::Read(void* ptr, size_t size) {
 	}
 }
 
+void GSDumpLzma::ThreadProc() {
+	try {
+		while (!IsEof()) {
+			std::unique_lock<std::mutex> l(m_lock);
+
+			while (!m_exit && (m_count == RING_SLOTS || (m_count > 0 && m_bytes >= RING_BUDGET)))
+				m_notfull.wait(l);
+
+			if (m_exit)
+				return;
+
+			// The slot at m_head is neither queued nor held by the consumer
+			Slot& slot = m_slots[m_head];
+
+			l.unlock();
+
+			Read(&slot.packet.type, 1);
+
+			if (!ReadPacketPayload(slot.packet, slot.buff))
+				break;
+
+			l.lock();
+
+			m_head = (m_head + 1) % RING_SLOTS;
+			m_count++;
+			m_bytes += slot.packet.size;
+
+			m_notempty.notify_one();
+		}
+	} catch (...) {
+		fprintf(stderr, "GSDumpLzma:: failed to decode packet\n");
+	}
+
+	std::lock_guard<std::mutex> l(m_lock);
+
+	m_done = true;
+
+	m_notempty.notify_one();
+}
+
+void GSDumpLzma::StartThread() {
+	m_head  = 0;
+	m_tail  = 0;
+	m_count = 0;
+	m_bytes = 0;
+	m_held  = false;
+	m_done  = false;
+	m_exit  = false;
+
+	m_thread = new std::thread(&GSDumpLzma::ThreadProc, this);
+}
+
+void GSDumpLzma::StopThread() {
+	if (m_thread == NULL)
+		return;
+
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+
+		m_exit = true;
+
+		m_notfull.notify_one();
+	}
+
+	m_thread->join();
+
+	delete m_thread;
+
+	m_thread = NULL;
+}
+
+bool GSDumpLzma::NextPacket(GSDumpPacket& p) {
+	if (m_thread == NULL) {
+		if (m_packet_start == 0)
+			m_packet_start = m_pos;
+
+		StartThread();
+	}
+
+	std::unique_lock<std::mutex> l(m_lock);
+
+	if (m_held) {
+		// Release the previous packet, the decoder can reuse its slot
+		Slot& slot = m_slots[m_tail];
+
+		m_bytes -= slot.packet.size;
+
+		if (slot.buff.capacity() > SLOT_KEEP)
+			vector<uint8>().swap(slot.buff);
+
+		m_tail = (m_tail + 1) % RING_SLOTS;
+		m_count--;
+		m_held = false;
+
+		m_notfull.notify_one();
+	}
+
+	while (m_count == 0 && !m_done)
+		m_notempty.wait(l);
+
+	if (m_count == 0)
+		return false;
+
+	p = m_slots[m_tail].packet;
+	m_held = true;
+
+	return true;
+}
+
+void GSDumpLzma::Rewind() {
+	StopThread();
+
+	// xz streams can't be seeked, restart the decoder and skip the header
+	InitDecoder();
+
+	rewind(m_fp);
+
+	vector<uint8> skip(64 * 1024);
+
+	for (uint64 left = m_packet_start; left > 0; ) {
+		size_t l = (size_t)std::min<uint64>(left, skip.size());
+		Read(&skip[0], l);
+		left -= l;
+	}
+}
+
 GSDumpLzma::~GSDumpLzma() {
+	StopThread();
+
 	lzma_end(&m_strm);
 
 	if (m_inbuf)
@@ -130,32 +318,101 @@ GSDumpLzma::~GSDumpLzma() {
 /******************************************************************/
 
 GSDumpRaw::GSDumpRaw(char* filename) : GSDumpFile(filename) {
-	m_buff_size = 0;
-	m_area      = NULL;
-	m_inbuf     = NULL;
-	m_avail     = 0;
-	m_start     = 0;
+	struct stat st;
+
+	if (fstat(fileno(m_fp), &st) != 0 || st.st_size == 0) {
+		fprintf(stderr, "GSDumpRaw:: failed to stat %s\n", filename);
+		throw "BAD"; // Just exit the program
+	}
+
+	m_size = (size_t)st.st_size;
+	m_pos  = 0;
+	m_packet_start = 0;
+
+	m_area = (uint8*)mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fileno(m_fp), 0);
+
+	if (m_area == MAP_FAILED) {
+		fprintf(stderr, "GSDumpRaw:: failed to map %s: %s\n", filename, strerror(errno));
+		throw "BAD"; // Just exit the program
+	}
+
+	madvise(m_area, m_size, MADV_SEQUENTIAL);
 }
 
 GSDumpRaw::~GSDumpRaw() {
+	munmap(m_area, m_size);
 }
 
 bool GSDumpRaw::IsEof() {
-	return feof(m_fp);
+	return m_pos >= m_size;
 }
 
 void GSDumpRaw::Read(void* ptr, size_t size) {
-	if (size == 1) {
-		// I don't know why but read of size 1 is not happy
-		int v = fgetc(m_fp);
-		memcpy(ptr, &v, 1);
-	} else {
-		size_t ret = fread(ptr, 1, size, m_fp);
-		if (ret != size) {
-			fprintf(stderr, "GSDumpRaw:: Read error\n");
-			throw "BAD"; // Just exit the program
-		}
+	if (size > m_size - m_pos) {
+		fprintf(stderr, "GSDumpRaw:: Read error\n");
+		throw "BAD"; // Just exit the program
+	}
+
+	memcpy(ptr, m_area + m_pos, size);
+	m_pos += size;
+}
+
+bool GSDumpRaw::NextPacket(GSDumpPacket& p) {
+	if (m_packet_start == 0)
+		m_packet_start = m_pos;
+
+	if (IsEof())
+		return false;
+
+	const uint8* header = m_area + m_pos;
+	size_t left = m_size - m_pos;
+
+	p.type  = header[0];
+	p.param = 0;
+	p.size  = 0;
+	p.data  = NULL;
+
+	size_t len;
+
+	switch (p.type) {
+		case 0:
+			if (left < 6) return false;
+			p.param = header[1];
+			memcpy(&p.size, &header[2], 4);
+			len = 6;
+			break;
+		case 1:
+			if (left < 2) return false;
+			p.param = header[1];
+			len = 2;
+			break;
+		case 2:
+			if (left < 5) return false;
+			memcpy(&p.size, &header[1], 4);
+			m_pos += 5;
+			return true; // size of the FIFO read back, no payload
+		case 3:
+			p.size = 0x2000;
+			len = 1;
+			break;
+		default:
+			fprintf(stderr, "GSDumpRaw:: unknown packet type %d\n", p.type);
+			return false;
 	}
+
+	if (p.size > left - len) {
+		fprintf(stderr, "GSDumpRaw:: truncated packet\n");
+		return false;
+	}
+
+	p.data = header + len;
+	m_pos += len + p.size;
+
+	return true;
+}
+
+void GSDumpRaw::Rewind() {
+	m_pos = m_packet_start;
 }
 
 #endif
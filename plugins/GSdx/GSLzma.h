@@ -24,22 +24,49 @@
 #include <lzma.h>
 #endif
 
+// A packet of the dump. data stays valid until the next call of NextPacket/Rewind
+struct GSDumpPacket {
+	uint8 type, param;
+	uint32 size;
+	const uint8* data;
+};
+
 class GSDumpFile {
 	protected:
 	FILE*		m_fp;
 
+	// Reads the payload of a packet whose type was already read
+	bool ReadPacketPayload(GSDumpPacket& p, vector<uint8>& buff);
 
 	public:
 	virtual bool IsEof() = 0;
 	virtual void Read(void* ptr, size_t size) = 0;
 
+	// Packets are streamed after the header (crc, freeze data and regs) was read.
+	// Rewind goes back to the first packet.
+	virtual bool NextPacket(GSDumpPacket& p) = 0;
+	virtual void Rewind() = 0;
+
 	GSDumpFile(char* filename);
 	virtual ~GSDumpFile();
 };
 
 #ifdef LZMA_SUPPORTED
+// The stream is decoded by a background thread into a bounded ring of packets,
+// so memory usage doesn't depend on the dump length.
 class GSDumpLzma : public GSDumpFile {
 
+	enum {
+		RING_SLOTS = 256,
+		RING_BUDGET = 64 * 1024 * 1024, // bytes of queued packet data
+		SLOT_KEEP = 256 * 1024, // larger slot buffers are freed once released, so idle slots stay small
+	};
+
+	struct Slot {
+		GSDumpPacket packet;
+		vector<uint8> buff;
+	};
+
 	lzma_stream m_strm;
 
 	size_t		m_buff_size;
@@ -48,8 +75,28 @@ class GSDumpLzma : public GSDumpFile {
 
 	size_t		m_avail;
 	size_t		m_start;
+	uint64		m_pos;
+	uint64		m_packet_start;
+
+	Slot		m_slots[RING_SLOTS];
+	int			m_head;
+	int			m_tail;
+	int			m_count;
+	size_t		m_bytes;
+	bool		m_held;
+	bool		m_done;
+	bool		m_exit;
+
+	std::thread* m_thread;
+	std::mutex m_lock;
+	std::condition_variable m_notempty;
+	std::condition_variable m_notfull;
 
 	void Decompress();
+	void InitDecoder();
+	void StartThread();
+	void StopThread();
+	void ThreadProc();
 
 	public:
 
@@ -58,19 +105,19 @@ class GSDumpLzma : public GSDumpFile {
 
 	bool IsEof();
 	void Read(void* ptr, size_t size);
+
+	bool NextPacket(GSDumpPacket& p);
+	void Rewind();
 };
 #endif
 
+// The file is memory mapped, packets point directly into the mapping.
 class GSDumpRaw : public GSDumpFile {
 
-	size_t		m_buff_size;
-	uint8_t*	m_area;
-	uint8_t*	m_inbuf;
-
-	size_t		m_avail;
-	size_t		m_start;
-
-	void Decompress();
+	uint8*		m_area;
+	size_t		m_size;
+	size_t		m_pos;
+	size_t		m_packet_start;
 
 	public:
 
@@ -79,6 +126,9 @@ class GSDumpRaw : public GSDumpFile {
 
 	bool IsEof();
 	void Read(void* ptr, size_t size);
+
+	bool NextPacket(GSDumpPacket& p);
+	void Rewind();
 };
 
 #endif
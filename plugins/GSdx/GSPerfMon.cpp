@@ -29,8 +29,11 @@ GSPerfMon::GSPerfMon()
 {
 	memset(m_counters, 0, sizeof(m_counters));
 	memset(m_stats, 0, sizeof(m_stats));
+	memset(m_totals, 0, sizeof(m_totals));
 	memset(m_total, 0, sizeof(m_total));
 	memset(m_begin, 0, sizeof(m_begin));
+	memset(m_start, 0, sizeof(m_start));
+	memset(m_ticks, 0, sizeof(m_ticks));
 }
 
 void GSPerfMon::Put(counter_t c, double val)
@@ -50,7 +53,10 @@ void GSPerfMon::Put(counter_t c, double val)
 
 		if(m_lastframe != 0)
 		{
-			m_counters[c] += (now - m_lastframe) * 1000 / CLOCKS_PER_SEC;
+			double ms = (now - m_lastframe) * 1000 / CLOCKS_PER_SEC;
+
+			m_counters[c] += ms;
+			m_totals[c] += ms;
 		}
 
 		m_lastframe = now;
@@ -60,6 +66,7 @@ void GSPerfMon::Put(counter_t c, double val)
 	else
 	{
 		m_counters[c] += val;
+		m_totals[c] += val;
 	}
 #endif
 }
@@ -98,7 +105,10 @@ void GSPerfMon::Stop(int timer)
 #ifndef DISABLE_PERF_MON
 	if(m_start[timer] > 0)
 	{
-		m_total[timer] += __rdtsc() - m_start[timer];
+		uint64 ticks = __rdtsc() - m_start[timer];
+
+		m_total[timer] += ticks;
+		m_ticks[timer] += ticks;
 		m_start[timer] = 0;
 	}
 #endif
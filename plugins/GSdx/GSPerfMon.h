@@ -35,14 +35,20 @@ public:
 	
 	enum counter_t 
 	{
-		Frame, Prim, Draw, Swizzle, Unswizzle, Fillrate, Quad, SyncPoint,
+		Frame, Prim, Draw, Swizzle, Unswizzle, Fillrate, Quad, SyncPoint, 
+		Wakeup, Park, // rendering threads woken up by the producer, going to sleep
+		SyncReason0, SyncReason1, SyncReason2, SyncReason3, SyncReason4, SyncReason5, SyncReason6, SyncReason7, // GSRendererSW::Sync(reason)
+		PageWait, // waiting for the draws of some pages only
+		UnswizzleJobs, // part of Unswizzle decoded as tasks shared with the rendering threads
 		CounterLast,
 	};
 
 protected:
 	double m_counters[CounterLast];
 	double m_stats[CounterLast];
+	double m_totals[CounterLast]; // never reset by Update, for per-frame deltas
 	uint64 m_begin[TimerLast], m_total[TimerLast], m_start[TimerLast];
+	uint64 m_ticks[TimerLast]; // never reset by CPU
 	uint64 m_frame;
 	clock_t m_lastframe;
 	int m_count;
@@ -57,6 +63,8 @@ public:
 
 	void Put(counter_t c, double val = 0);
 	double Get(counter_t c) {return m_stats[c];}
+	double GetTotal(counter_t c) {return m_totals[c];}
+	uint64 GetTicks(int timer) {return m_ticks[timer];}
 	void Update();
 
 	void Start(int timer = Main);
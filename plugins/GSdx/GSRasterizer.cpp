@@ -27,6 +27,7 @@
 // - for more threads screen segments should be smaller to better distribute the pixels
 // - but not too small to keep the threading overhead low
 // - ideal value between 3 and 5, or log2(64 / number of threads)
+// - GSRasterizerList bins primitives into bands of this height, a band is a unit of work
 
 #define THREAD_HEIGHT 4
 
@@ -122,6 +123,14 @@ int GSRasterizer::GetPixels(bool reset)
 }
 
 void GSRasterizer::Draw(GSRasterizerData* data)
+{
+	Draw(data, data->scissor, NULL, 0);
+}
+
+// only draws the pixels inside scissor (which must be inside data->scissor) and, if prims isn't NULL, 
+// only the listed primitives
+
+void GSRasterizer::Draw(GSRasterizerData* data, const GSVector4i& scissor, const uint32* prims, int prim_count)
 {
 	GSPerfMonAutoTimer pmat(m_perfmon, GSPerfMon::WorkerDraw0 + m_id);
 
@@ -130,7 +139,7 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 	m_pixels.actual = 0;
 	m_pixels.total = 0;
 
-	data->start = __rdtsc();
+	uint64 start = __rdtsc();
 
 	m_ds->BeginDraw(data);
 
@@ -142,13 +151,17 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 
 	uint32 tmp_index[] = {0, 1, 2};
 
-	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(data->scissor));
+	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(scissor));
 
-	m_scissor = data->scissor;
-	m_fscissor_x = GSVector4(data->scissor).xzxz();
-	m_fscissor_y = GSVector4(data->scissor).ywyw();
+	m_scissor = scissor;
+	m_fscissor_x = GSVector4(scissor).xzxz();
+	m_fscissor_y = GSVector4(scissor).ywyw();
 
-	switch(data->primclass)
+	if(prims != NULL)
+	{
+		DrawPrims(data, prims, prim_count, scissor_test);
+	}
+	else switch(data->primclass)
 	{
 	case GS_POINT_CLASS:
 
@@ -216,15 +229,59 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 	_mm256_zeroupper();
 	#endif
 
-	data->pixels = m_pixels.actual;
+	uint64 ticks = __rdtsc() - start;
 
-	uint64 ticks = __rdtsc() - data->start;
+	data->ticks += ticks;
+	data->pixels += m_pixels.actual;
 
 	m_pixels.sum += m_pixels.actual;
 
 	m_ds->EndDraw(data->frame, ticks, m_pixels.actual, m_pixels.total);
 }
 
+void GSRasterizer::DrawPrims(const GSRasterizerData* data, const uint32* prims, int prim_count, bool scissor_test)
+{
+	const GSVertexSW* vertex = data->vertex;
+	const uint32* index = data->index;
+
+	uint32 tmp_index[] = {0, 1, 2};
+
+	for(int i = 0; i < prim_count; i++)
+	{
+		uint32 prim = prims[i];
+
+		switch(data->primclass)
+		{
+		case GS_POINT_CLASS:
+			if(index != NULL) 
+			{
+				if(scissor_test) DrawPoint<true>(vertex, data->vertex_count, &index[prim], 1);
+				else DrawPoint<false>(vertex, data->vertex_count, &index[prim], 1);
+			}
+			else
+			{
+				if(scissor_test) DrawPoint<true>(&vertex[prim], 1, NULL, 0);
+				else DrawPoint<false>(&vertex[prim], 1, NULL, 0);
+			}
+			break;
+		case GS_LINE_CLASS:
+			if(index != NULL) DrawLine(vertex, &index[prim * 2]);
+			else DrawLine(&vertex[prim * 2], tmp_index);
+			break;
+		case GS_TRIANGLE_CLASS:
+			if(index != NULL) DrawTriangle(vertex, &index[prim * 3]);
+			else DrawTriangle(&vertex[prim * 3], tmp_index);
+			break;
+		case GS_SPRITE_CLASS:
+			if(index != NULL) DrawSprite(vertex, &index[prim * 2]);
+			else DrawSprite(&vertex[prim * 2], tmp_index);
+			break;
+		default:
+			__assume(0);
+		}
+	}
+}
+
 template<bool scissor_test>
 void GSRasterizer::DrawPoint(const GSVertexSW* vertex, int vertex_count, const uint32* index, int index_count)
 {
@@ -1131,17 +1188,16 @@ void GSRasterizer::DrawEdge(int pixels, int left, int top, const GSVertexSW& sca
 
 GSRasterizerList::GSRasterizerList(int threads, GSPerfMon* perfmon)
 	: m_perfmon(perfmon)
+	, m_job_id(0)
+	, m_next_worker(0)
 {
-	m_scanline = (uint8*)_aligned_malloc((2048 >> THREAD_HEIGHT) + 16, 64);
+	m_band_last = new uint32[2048 >> THREAD_HEIGHT];
+	m_band_done = new std::atomic<uint32>[2048 >> THREAD_HEIGHT];
 
-	int row = 0;
-
-	while(row < (2048 >> THREAD_HEIGHT))
+	for(int i = 0; i < (2048 >> THREAD_HEIGHT); i++)
 	{
-		for(int i = 0; i < threads; i++, row++)
-		{
-			m_scanline[row] = (uint8)i;
-		}
+		m_band_last[i] = 0;
+		m_band_done[i] = 0;
 	}
 }
 
@@ -1152,7 +1208,111 @@ GSRasterizerList::~GSRasterizerList()
 		delete *i;
 	}
 
-	_aligned_free(m_scanline);
+	delete [] m_band_last;
+	delete [] m_band_done;
+}
+
+void GSRasterizerList::Bin(Job* job, const GSVector4i& r)
+{
+	const GSRasterizerData* data = job->data.get();
+
+	int top = r.top >> THREAD_HEIGHT;
+	int bottom = (r.bottom - 1) >> THREAD_HEIGHT;
+
+	int n;
+
+	switch(data->primclass)
+	{
+	case GS_POINT_CLASS: n = 1; break;
+	case GS_LINE_CLASS: n = 2; break;
+	case GS_TRIANGLE_CLASS: n = 3; break;
+	case GS_SPRITE_CLASS: n = 2; break;
+	default: __assume(0);
+	}
+
+	int count = (data->index != NULL ? data->index_count : data->vertex_count) / n;
+
+	if(top == bottom || count <= 1)
+	{
+		// nothing to sort, all the primitives in every band
+
+		for(int i = top; i <= bottom; i++)
+		{
+			Band b;
+
+			b.index = i;
+			b.first = 0;
+			b.count = -1;
+
+			job->bands.push_back(b);
+		}
+
+		return;
+	}
+
+	// vertical extent of each primitive, one more scanline on both sides for the rounding
+
+	GSVector4 rmin((float)r.top);
+	GSVector4 rmax((float)(r.bottom - 1));
+
+	m_prim_bands.resize(count * 2);
+
+	vector<int> band_count(bottom - top + 2, 0);
+
+	for(int i = 0; i < count; i++)
+	{
+		GSVector4 ymin = GSVector4(FLT_MAX);
+		GSVector4 ymax = GSVector4(-FLT_MAX);
+
+		for(int j = 0; j < n; j++)
+		{
+			const GSVertexSW& v = data->vertex[data->index != NULL ? data->index[i * n + j] : i * n + j];
+
+			ymin = ymin.min(v.p.yyyy());
+			ymax = ymax.max(v.p.yyyy());
+		}
+
+		int t = GSVector4i((ymin - GSVector4(1.0f)).max(rmin).min(rmax)).extract32<0>() >> THREAD_HEIGHT;
+		int b = GSVector4i((ymax + GSVector4(1.0f)).max(rmin).min(rmax)).extract32<0>() >> THREAD_HEIGHT;
+
+		m_prim_bands[i * 2 + 0] = t;
+		m_prim_bands[i * 2 + 1] = b;
+
+		for(int k = t; k <= b; k++)
+		{
+			band_count[k - top + 1]++;
+		}
+	}
+
+	// primitives of each band stored after each other, in drawing order
+
+	for(int i = top; i <= bottom; i++)
+	{
+		int first = band_count[i - top];
+
+		if(band_count[i - top + 1] > 0)
+		{
+			Band b;
+
+			b.index = i;
+			b.first = first;
+			b.count = band_count[i - top + 1];
+
+			job->bands.push_back(b);
+		}
+
+		band_count[i - top + 1] += first;
+	}
+
+	job->prims.resize(band_count[bottom - top + 1]);
+
+	for(int i = 0; i < count; i++)
+	{
+		for(int k = m_prim_bands[i * 2 + 0]; k <= (int)m_prim_bands[i * 2 + 1]; k++)
+		{
+			job->prims[band_count[k - top]++] = i;
+		}
+	}
 }
 
 void GSRasterizerList::Queue(const shared_ptr<GSRasterizerData>& data)
@@ -1161,12 +1321,77 @@ void GSRasterizerList::Queue(const shared_ptr<GSRasterizerData>& data)
 
 	ASSERT(r.top >= 0 && r.top < 2048 && r.bottom >= 0 && r.bottom < 2048);
 
-	int top = r.top >> THREAD_HEIGHT;
-	int bottom = std::min<int>((r.bottom + (1 << THREAD_HEIGHT) - 1) >> THREAD_HEIGHT, top + m_workers.size());
+	if(r.top >= r.bottom) return;
 
-	while(top < bottom)
+	shared_ptr<Job> job = std::make_shared<Job>();
+
+	job->data = data;
+	job->id = ++m_job_id;
+
+	Bin(job.get(), r);
+
+	for(auto i = job->bands.begin(); i != job->bands.end(); i++)
+	{
+		i->prev = m_band_last[i->index];
+
+		m_band_last[i->index] = job->id;
+	}
+
+	// as many workers as bands, the bands go to whoever is free first
+
+	int workers = std::min<int>(job->bands.size(), m_workers.size());
+
+	for(int i = 0; i < workers; i++)
+	{
+		m_workers[m_next_worker]->Push(job);
+
+		m_next_worker = (m_next_worker + 1) % m_workers.size();
+	}
+}
+
+void GSRasterizerList::Run(int count, const std::function<void(int)>& task)
+{
+	if(count <= 1)
+	{
+		if(count == 1) task(0);
+
+		return;
+	}
+
+	shared_ptr<Job> job = std::make_shared<Job>();
+
+	job->task = task;
+	job->tasks = count;
+
+	// the caller takes tasks too, the late workers find nothing left
+
+	int workers = std::min<int>(count - 1, m_workers.size());
+
+	for(int i = 0; i < workers; i++)
+	{
+		m_workers[m_next_worker]->Push(job);
+
+		m_next_worker = (m_next_worker + 1) % m_workers.size();
+	}
+
+	job->RunTasks();
+
+	// only the tasks already taken by a worker are left
+
+	for(int spin = 0; job->done.load(memory_order_acquire) < count; spin++)
+	{
+		if(spin < 256) _mm_pause();
+		else std::this_thread::yield();
+	}
+}
+
+void GSRasterizerList::Job::RunTasks()
+{
+	for(int i = next++; i < tasks; i = next++)
 	{
-		m_workers[m_scanline[top++]]->Push(data);
+		task(i);
+
+		done.fetch_add(1, memory_order_release);
 	}
 }
 
@@ -1181,6 +1406,16 @@ void GSRasterizerList::Sync()
 
 		m_perfmon->Put(GSPerfMon::SyncPoint, 1);
 	}
+
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		int wakeups, parks;
+
+		m_workers[i]->GetWakeStats(wakeups, parks);
+
+		m_perfmon->Put(GSPerfMon::Wakeup, wakeups);
+		m_perfmon->Put(GSPerfMon::Park, parks);
+	}
 }
 
 bool GSRasterizerList::IsSynced() const
@@ -1208,10 +1443,53 @@ int GSRasterizerList::GetPixels(bool reset)
 	return pixels;
 }
 
+void GSRasterizerList::PrintStats()
+{
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->GetRasterizer()->PrintStats();
+	}
+}
+
+void GSRasterizerList::GetSelectors(vector<uint64>& sp, vector<uint64>& ds)
+{
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->GetRasterizer()->GetSelectors(sp, ds);
+	}
+
+	// every worker draws with most of the same selectors
+
+	std::sort(sp.begin(), sp.end());
+	sp.erase(std::unique(sp.begin(), sp.end()), sp.end());
+
+	std::sort(ds.begin(), ds.end());
+	ds.erase(std::unique(ds.begin(), ds.end()), ds.end());
+}
+
+void GSRasterizerList::PrecompileSetupPrim(uint64 key)
+{
+	// each worker has its own code, it refers to the worker's local data
+
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->GetRasterizer()->PrecompileSetupPrim(key);
+	}
+}
+
+void GSRasterizerList::PrecompileDrawScanline(uint64 key)
+{
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->GetRasterizer()->PrecompileDrawScanline(key);
+	}
+}
+
 // GSRasterizerList::GSWorker
 
-GSRasterizerList::GSWorker::GSWorker(GSRasterizer* r)
-	: GSJobQueue<shared_ptr<GSRasterizerData>, 256>()
+GSRasterizerList::GSWorker::GSWorker(GSRasterizerList* parent, GSRasterizer* r)
+	: GSJobQueue<shared_ptr<Job>, 256>()
+	, m_parent(parent)
 	, m_r(r)
 {
 }
@@ -1228,7 +1506,41 @@ int GSRasterizerList::GSWorker::GetPixels(bool reset)
 	return m_r->GetPixels(reset);
 }
 
-void GSRasterizerList::GSWorker::Process(shared_ptr<GSRasterizerData>& item)
+void GSRasterizerList::GSWorker::Process(shared_ptr<Job>& item)
 {
-	m_r->Draw(item.get());
+	Job* job = item.get();
+
+	if(job->tasks > 0)
+	{
+		job->RunTasks();
+
+		return;
+	}
+
+	GSRasterizerData* data = job->data.get();
+
+	GSVector4i scissor = data->scissor;
+
+	for(int i = job->next++; i < (int)job->bands.size(); i = job->next++)
+	{
+		const Band& b = job->bands[i];
+
+		// the previous job drawing to this band was queued earlier, every worker takes 
+		// the jobs in the same order, so the one which took that band is already at it
+
+		std::atomic<uint32>& done = m_parent->m_band_done[b.index];
+
+		for(int spin = 0; done.load(memory_order_acquire) != b.prev; spin++)
+		{
+			if(spin < 256) _mm_pause();
+			else std::this_thread::yield();
+		}
+
+		scissor.top = std::max<int>(data->scissor.top, b.index << THREAD_HEIGHT);
+		scissor.bottom = std::min<int>(data->scissor.bottom, (b.index + 1) << THREAD_HEIGHT);
+
+		m_r->Draw(data, scissor, b.count >= 0 ? &job->prims[b.first] : NULL, b.count);
+
+		done.store(job->id, memory_order_release);
+	}
 }
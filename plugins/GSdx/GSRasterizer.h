@@ -42,8 +42,8 @@ public:
 	uint32* index;
 	int index_count;
 	uint64 frame;
-	uint64 start;
-	int pixels;
+	std::atomic<uint64> ticks; // summed over the workers drawing the bands of the draw
+	std::atomic<int> pixels;
 	int counter;
 
 	GSRasterizerData() 
@@ -56,7 +56,7 @@ public:
 		, index(NULL)
 		, index_count(0)
 		, frame(0)
-		, start(0)
+		, ticks(0)
 		, pixels(0)
 	{
 		counter = s_counter++;
@@ -106,6 +106,12 @@ public:
 
 	virtual void PrintStats() = 0;
 
+	// Selectors drawn with so far, and generating code for selectors ahead of time (from any thread)
+
+	virtual void GetSelectors(vector<uint64>& sp, vector<uint64>& ds) {}
+	virtual void PrecompileSetupPrim(uint64 key) {}
+	virtual void PrecompileDrawScanline(uint64 key) {}
+
 	__forceinline bool HasEdge() const {return m_de != NULL;}
 	__forceinline bool IsSolidRect() const {return m_dr != NULL;}
 };
@@ -116,10 +122,17 @@ public:
 	virtual ~IRasterizer() {}
 
 	virtual void Queue(const shared_ptr<GSRasterizerData>& data) = 0;
+	virtual void Run(int count, const std::function<void(int)>& task) = 0; // task(0) ... task(count - 1), returns when all are done
 	virtual void Sync() = 0;
 	virtual bool IsSynced() const = 0;
 	virtual int GetPixels(bool reset = true) = 0;
 	virtual void PrintStats() = 0;
+
+	// Must be synced for GetSelectors, Precompile can be called from another thread while drawing
+
+	virtual void GetSelectors(vector<uint64>& sp, vector<uint64>& ds) = 0;
+	virtual void PrecompileSetupPrim(uint64 key) = 0;
+	virtual void PrecompileDrawScanline(uint64 key) = 0;
 };
 
 __aligned(class, 32) GSRasterizer : public IRasterizer
@@ -138,6 +151,8 @@ protected:
 
 	typedef void (GSRasterizer::*DrawPrimPtr)(const GSVertexSW* v, int count);
 
+	void DrawPrims(const GSRasterizerData* data, const uint32* prims, int prim_count, bool scissor_test);
+
 	template<bool scissor_test> 
 	void DrawPoint(const GSVertexSW* vertex, int vertex_count, const uint32* index, int index_count);
 	void DrawLine(const GSVertexSW* vertex, const uint32* index);
@@ -167,40 +182,89 @@ public:
 	__forceinline int FindMyNextScanline(int top) const;
 
 	void Draw(GSRasterizerData* data);
+	void Draw(GSRasterizerData* data, const GSVector4i& scissor, const uint32* prims, int prim_count);
 
 	// IRasterizer
 
 	void Queue(const shared_ptr<GSRasterizerData>& data);
+	void Run(int count, const std::function<void(int)>& task) {for(int i = 0; i < count; i++) task(i);}
 	void Sync() {}
 	bool IsSynced() const {return true;}
 	int GetPixels(bool reset);
 	void PrintStats() {m_ds->PrintStats();}
+	void GetSelectors(vector<uint64>& sp, vector<uint64>& ds) {m_ds->GetSelectors(sp, ds);}
+	void PrecompileSetupPrim(uint64 key) {m_ds->PrecompileSetupPrim(key);}
+	void PrecompileDrawScanline(uint64 key) {m_ds->PrecompileDrawScanline(key);}
 };
 
+// The screen is cut into bands of scanlines, and the primitives of each draw are
+// binned into the bands they cover once, when queued. The workers which received
+// the draw then take its bands one by one, so a draw covering a few bands is done
+// by as many threads, and those which are done move on to the next draws. A band
+// of a draw waits for the same band of the previous draw covering it, that's the
+// only ordering needed since the bands don't share any pixel.
+//
+// Run() queues a job of independent tasks the same way, the workers and the caller
+// take them one by one. The caller doesn't wait for the draws queued before, if the
+// workers are busy it ends up doing the tasks by itself.
+
 class GSRasterizerList : public IRasterizer
 {
 protected:
-	class GSWorker : public GSJobQueue<shared_ptr<GSRasterizerData>, 256 >
+	struct Band
 	{
+		int index; // band number, scanlines [index << THREAD_HEIGHT, (index + 1) << THREAD_HEIGHT)
+		uint32 prev; // job which must be done with this band first
+		int first, count; // primitives in Job::prims, count < 0 draws all of them
+	};
+
+	class Job
+	{
+	public:
+		shared_ptr<GSRasterizerData> data;
+		uint32 id;
+		vector<Band> bands;
+		vector<uint32> prims;
+		std::atomic<int> next; // next band (or task) to take
+
+		std::function<void(int)> task; // set for the jobs of Run, they have no draw
+		int tasks;
+		std::atomic<int> done; // tasks finished
+
+		Job() : id(0), next(0), tasks(0), done(0) {}
+
+		void RunTasks();
+	};
+
+	class GSWorker : public GSJobQueue<shared_ptr<Job>, 256 >
+	{
+		GSRasterizerList* m_parent;
 		GSRasterizer* m_r;
 
 	public:
-		GSWorker(GSRasterizer* r);
+		GSWorker(GSRasterizerList* parent, GSRasterizer* r);
 		virtual ~GSWorker();
 
 		int GetPixels(bool reset);
+		GSRasterizer* GetRasterizer() {return m_r;}
 
 		// GSJobQueue
 
-		void Process(shared_ptr<GSRasterizerData>& item);
+		void Process(shared_ptr<Job>& item);
 	};
 
 	GSPerfMon* m_perfmon;
 	vector<GSWorker*> m_workers;
-	uint8* m_scanline;
+	uint32 m_job_id;
+	int m_next_worker;
+	uint32* m_band_last; // last job queued for each band
+	std::atomic<uint32>* m_band_done; // last job done with each band
+	vector<uint32> m_prim_bands; // first/last band of each primitive, temporary of Queue
 
 	GSRasterizerList(int threads, GSPerfMon* perfmon);
 
+	void Bin(Job* job, const GSVector4i& r);
+
 public:
 	virtual ~GSRasterizerList();
 
@@ -218,7 +282,9 @@ public:
 
 			for(int i = 0; i < threads; i++)
 			{
-				rl->m_workers.push_back(new GSWorker(new GSRasterizer(new DS(), i, threads, perfmon)));
+				// each band is drawn by a single thread, all of its scanlines
+
+				rl->m_workers.push_back(new GSWorker(rl, new GSRasterizer(new DS(), i, 1, perfmon)));
 			}
 
 			return rl;
@@ -228,8 +294,12 @@ public:
 	// IRasterizer
 
 	void Queue(const shared_ptr<GSRasterizerData>& data);
+	void Run(int count, const std::function<void(int)>& task);
 	void Sync();
 	bool IsSynced() const;
 	int GetPixels(bool reset);
-	void PrintStats() {}
+	void PrintStats();
+	void GetSelectors(vector<uint64>& sp, vector<uint64>& ds);
+	void PrecompileSetupPrim(uint64 key);
+	void PrecompileDrawScanline(uint64 key);
 };
@@ -43,6 +43,11 @@ GSRendererSW::GSRendererSW(int threads)
 
 	m_rl = GSRasterizerList::Create<GSDrawScanline>(threads, &m_perfmon);
 
+	m_jit.enabled = !!theApp.GetConfig("jit_cache", 1);
+	m_jit.crc = 0;
+	m_jit.thread = NULL;
+	m_jit.abort = false;
+
 	m_output = (uint8*)_aligned_malloc(1024 * 1024 * sizeof(uint32), 32);
 
 	for (uint32 i = 0; i < countof(m_fzb_pages); i++) {
@@ -66,6 +71,10 @@ GSRendererSW::GSRendererSW(int threads)
 
 GSRendererSW::~GSRendererSW()
 {
+	StopPrecompile();
+
+	SaveSelectors();
+
 	delete m_tc;
 
 	for(size_t i = 0; i < countof(m_texture); i++)
@@ -87,6 +96,160 @@ void GSRendererSW::Reset()
 	GSRenderer::Reset();
 }
 
+void GSRendererSW::SetGameCRC(uint32 crc, int options)
+{
+	if(m_jit.enabled && crc != m_jit.crc)
+	{
+		StopPrecompile();
+
+		SaveSelectors();
+
+		m_jit.crc = crc;
+
+		LoadSelectors();
+
+		StartPrecompile();
+	}
+
+	GSRenderer::SetGameCRC(crc, options);
+}
+
+string GSRendererSW::GetSelectorLogPath(uint32 crc)
+{
+	return theApp.GetConfigPath(format("GSdx_jit_%08X.txt", crc).c_str());
+}
+
+void GSRendererSW::LoadSelectors()
+{
+	m_jit.sp.clear();
+	m_jit.ds.clear();
+
+	if(m_jit.crc == 0)
+	{
+		return;
+	}
+
+	FILE* fp = fopen(GetSelectorLogPath(m_jit.crc).c_str(), "r");
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	// the selectors of another instruction set don't generate the same code, start over
+
+	int sse = 0;
+
+	if(fscanf(fp, "GSdx JIT selectors %x\n", &sse) == 1 && sse == _M_SSE)
+	{
+		char type[4];
+		unsigned long long key;
+
+		while(fscanf(fp, "%3s %llx\n", type, &key) == 2)
+		{
+			if(strcmp(type, "sp") == 0) m_jit.sp.push_back(key);
+			else if(strcmp(type, "ds") == 0) m_jit.ds.push_back(key);
+		}
+	}
+
+	fclose(fp);
+}
+
+void GSRendererSW::SaveSelectors()
+{
+	if(m_jit.crc == 0)
+	{
+		return;
+	}
+
+	m_rl->Sync();
+
+	// keep the logged selectors which this session hasn't drawn with (yet)
+
+	vector<uint64> sp = m_jit.sp;
+	vector<uint64> ds = m_jit.ds;
+
+	m_rl->GetSelectors(sp, ds);
+
+	std::sort(sp.begin(), sp.end());
+	sp.erase(std::unique(sp.begin(), sp.end()), sp.end());
+
+	std::sort(ds.begin(), ds.end());
+	ds.erase(std::unique(ds.begin(), ds.end()), ds.end());
+
+	if(sp.size() == m_jit.sp.size() && ds.size() == m_jit.ds.size())
+	{
+		return; // nothing new
+	}
+
+	FILE* fp = fopen(GetSelectorLogPath(m_jit.crc).c_str(), "w");
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	fprintf(fp, "GSdx JIT selectors %x\n", _M_SSE);
+
+	for(size_t i = 0; i < sp.size(); i++)
+	{
+		fprintf(fp, "sp %016llx\n", (unsigned long long)sp[i]);
+	}
+
+	for(size_t i = 0; i < ds.size(); i++)
+	{
+		fprintf(fp, "ds %016llx\n", (unsigned long long)ds[i]);
+	}
+
+	fclose(fp);
+
+	m_jit.sp = sp;
+	m_jit.ds = ds;
+}
+
+void GSRendererSW::StartPrecompile()
+{
+	if(m_jit.sp.empty() && m_jit.ds.empty())
+	{
+		return;
+	}
+
+	m_jit.abort = false;
+
+	m_jit.thread = new std::thread(&GSRendererSW::PrecompileThreadProc, this);
+}
+
+void GSRendererSW::StopPrecompile()
+{
+	if(m_jit.thread == NULL)
+	{
+		return;
+	}
+
+	m_jit.abort = true;
+
+	m_jit.thread->join();
+
+	delete m_jit.thread;
+
+	m_jit.thread = NULL;
+}
+
+void GSRendererSW::PrecompileThreadProc()
+{
+	// setup-prim functions first, there are fewer of them and every draw needs one
+
+	for(size_t i = 0; i < m_jit.sp.size() && !m_jit.abort; i++)
+	{
+		m_rl->PrecompileSetupPrim(m_jit.sp[i]);
+	}
+
+	for(size_t i = 0; i < m_jit.ds.size() && !m_jit.abort; i++)
+	{
+		m_rl->PrecompileDrawScanline(m_jit.ds[i]);
+	}
+}
+
 void GSRendererSW::VSync(int field)
 {
 	Sync(0); // IncAge might delete a cached texture in use
@@ -495,19 +658,13 @@ void GSRendererSW::Draw()
 		zb_pages = m_context->offset.zb->GetPages(r);
 	}
 
-	// check if there is an overlap between this and previous targets
+	// wait for the previous targets this one overlaps with
 
-	if(CheckTargetPages(fb_pages, zb_pages, r))
-	{
-		sd->m_syncpoint = SharedData::SyncTarget;
-	}
+	CheckTargetPages(fb_pages, zb_pages, r);
 
-	// check if the texture is not part of a target currently in use
+	// wait if the texture is part of a target currently in use
 
-	if(CheckSourcePages(sd))
-	{
-		sd->m_syncpoint = SharedData::SyncSource;
-	}
+	CheckSourcePages(sd);
 
 	// addref source and target pages
 
@@ -622,20 +779,10 @@ void GSRendererSW::Queue(shared_ptr<GSRasterizerData>& item)
 {
 	SharedData* sd = (SharedData*)item.get();
 
-	if(sd->m_syncpoint == SharedData::SyncSource) 
-	{
-		Sync(4);
-	}
-
-	// update previously invalidated parts
+	// update previously invalidated parts (CheckSourcePages already waited for the draws using them)
 
 	sd->UpdateSource();
 
-	if(sd->m_syncpoint == SharedData::SyncTarget)
-	{
-		Sync(5);
-	}
-
 	if(LOG)
 	{
 		GSScanlineGlobalData& gd = ((SharedData*)item.get())->global;
@@ -673,6 +820,11 @@ void GSRendererSW::Sync(int reason)
 
 	uint64 t = __rdtsc();
 
+	if(reason >= 0 && reason < 8 && !m_rl->IsSynced())
+	{
+		m_perfmon.Put((GSPerfMon::counter_t)(GSPerfMon::SyncReason0 + reason), 1);
+	}
+
 	m_rl->Sync();
 
 	if(0) if(LOG)
@@ -717,15 +869,7 @@ void GSRendererSW::InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 
 	if(!m_rl->IsSynced())
 	{
-		for(uint32* RESTRICT p = m_tmp_pages; *p != GSOffset::EOP; p++)
-		{
-			if(m_fzb_pages[*p] | m_tex_pages[*p])
-			{
-				Sync(6);
-
-				break;
-			}
-		}
+		WaitPages(m_tmp_pages, 0xffffffff, true);
 	}
 
 	m_tc->InvalidatePages(m_tmp_pages, off->psm); // if texture update runs on a thread and Sync(5) happens then this must come later
@@ -741,15 +885,7 @@ void GSRendererSW::InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 
 		off->GetPages(r, m_tmp_pages);
 
-		for(uint32* RESTRICT p = m_tmp_pages; *p != GSOffset::EOP; p++)
-		{
-			if(m_fzb_pages[*p])
-			{
-				Sync(7);
-
-				break;
-			}
-		}
+		WaitPages(m_tmp_pages, 0xffffffff, false);
 	}
 }
 
@@ -795,14 +931,57 @@ void GSRendererSW::ReleasePages(const uint32* pages, const int type)
 	}
 }
 
-bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pages, const GSVector4i& r)
+// Waits until the queued draws using the pages as frame (fzb_mask 0x0000ffff), z-buffer (0xffff0000) 
+// or texture are done with them. The draws of other pages go on, unlike Sync. The caller mustn't queue 
+// anything which uses the pages in the meantime, the counts only go down while it waits.
+
+void GSRendererSW::WaitPages(const uint32* pages, uint32 fzb_mask, bool tex)
+{
+	const uint32* p = pages;
+
+	while(*p != GSOffset::EOP && (m_fzb_pages[*p] & fzb_mask) == 0 && (!tex || m_tex_pages[*p] == 0))
+	{
+		p++;
+	}
+
+	if(*p == GSOffset::EOP)
+	{
+		return;
+	}
+
+	GSPerfMonAutoTimer pmat(&m_perfmon, GSPerfMon::Sync);
+
+	m_perfmon.Put(GSPerfMon::PageWait, 1);
+
+	for(int spin = 0; *p != GSOffset::EOP; )
+	{
+		if((m_fzb_pages[*p] & fzb_mask) == 0 && (!tex || m_tex_pages[*p] == 0))
+		{
+			p++;
+		}
+		else if(m_rl->IsSynced())
+		{
+			break; // the pages are released after the draw leaves the queue, shouldn't happen
+		}
+		else if(spin++ < 1000)
+		{
+			_mm_pause();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pages, const GSVector4i& r)
 {
 	bool synced = m_rl->IsSynced();
 	
 	bool fb = fb_pages != NULL;
 	bool zb = zb_pages != NULL;
 
-	bool res = false;
+	uint32* used = m_tmp_pages; // pages of the target in use by the queued draws
 
 	if(m_fzb != m_context->offset.fzb4)
 	{
@@ -816,8 +995,6 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 
 		memset(m_fzb_cur_pages, 0, sizeof(m_fzb_cur_pages));
 
-		uint32 used = 0;
-
 		for(const uint32* p = fb_pages; *p != GSOffset::EOP; p++)
 		{
 			uint32 i = *p;
@@ -825,9 +1002,12 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 			uint32 row = i >> 5;
 			uint32 col = 1 << (i & 31);
 			
-			m_fzb_cur_pages[row] |= col;
+			if((m_fzb_cur_pages[row] & col) == 0)
+			{
+				m_fzb_cur_pages[row] |= col;
 
-			used |= m_fzb_pages[i];
+				if(m_fzb_pages[i]) *used++ = i;
+			}
 		}
 
 		for(const uint32* p = zb_pages; *p != GSOffset::EOP; p++)
@@ -837,18 +1017,19 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 			uint32 row = i >> 5;
 			uint32 col = 1 << (i & 31);
 			
-			m_fzb_cur_pages[row] |= col;
+			if((m_fzb_cur_pages[row] & col) == 0)
+			{
+				m_fzb_cur_pages[row] |= col;
 
-			used |= m_fzb_pages[i];
+				if(m_fzb_pages[i]) *used++ = i;
+			}
 		}
 
 		if(!synced)
 		{
-			if(used)
+			if(used > m_tmp_pages)
 			{
 				if(LOG) {fprintf(s_fp, "syncpoint 0\n"); fflush(s_fp);}
-
-				res = true;
 			}
 
 			//if(LOG) {fprintf(s_fp, "no syncpoint *\n"); fflush(s_fp);}
@@ -871,8 +1052,6 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 			if(fb_pages == NULL) fb_pages = m_context->offset.fb->GetPages(r);
 			if(zb_pages == NULL) zb_pages = m_context->offset.zb->GetPages(r);
 
-			uint32 used = 0;
-
 			for(const uint32* p = fb_pages; *p != GSOffset::EOP; p++)
 			{
 				uint32 i = *p;
@@ -884,7 +1063,7 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 				{
 					m_fzb_cur_pages[row] |= col;
 
-					used |= m_fzb_pages[i];
+					if(m_fzb_pages[i]) *used++ = i;
 				}
 			}
 
@@ -899,17 +1078,15 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 				{
 					m_fzb_cur_pages[row] |= col;
 
-					used |= m_fzb_pages[i];
+					if(m_fzb_pages[i]) *used++ = i;
 				}
 			}
 
 			if(!synced)
 			{
-				if(used)
+				if(used > m_tmp_pages)
 				{
 					if(LOG) {fprintf(s_fp, "syncpoint 1\n"); fflush(s_fp);}
-
-					res = true;
 				}
 			}
 		}
@@ -919,45 +1096,30 @@ bool GSRendererSW::CheckTargetPages(const uint32* fb_pages, const uint32* zb_pag
 			// chross-check frame and z-buffer pages, they cannot overlap with eachother and with previous batches in queue,
 			// have to be careful when the two buffers are mutually enabled/disabled and alternating (Bully FBP/ZBP = 0x2300)
 
-			if(fb && !res)
+			if(fb)
 			{
-				for(const uint32* p = fb_pages; *p != GSOffset::EOP; p++)
-				{
-					if(m_fzb_pages[*p] & 0xffff0000)
-					{
-						if(LOG) {fprintf(s_fp, "syncpoint 2\n"); fflush(s_fp);}
-
-						res = true;
-
-						break;
-					}
-				}
+				WaitPages(fb_pages, 0xffff0000, false);
 			}
 
-			if(zb && !res)
+			if(zb)
 			{
-				for(const uint32* p = zb_pages; *p != GSOffset::EOP; p++)
-				{
-					if(m_fzb_pages[*p] & 0x0000ffff)
-					{
-						if(LOG) {fprintf(s_fp, "syncpoint 3\n"); fflush(s_fp);}
-
-						res = true;
-
-						break;
-					}
-				}
+				WaitPages(zb_pages, 0x0000ffff, false);
 			}
 		}
 	}
 
+	*used = GSOffset::EOP;
+
+	if(!synced)
+	{
+		WaitPages(m_tmp_pages, 0xffffffff, false);
+	}
+
 	if(!fb && fb_pages != NULL) delete [] fb_pages;
 	if(!zb && zb_pages != NULL) delete [] zb_pages;
-
-	return res;
 }
 
-bool GSRendererSW::CheckSourcePages(SharedData* sd)
+void GSRendererSW::CheckSourcePages(SharedData* sd)
 {
 	if(!m_rl->IsSynced())
 	{
@@ -965,21 +1127,22 @@ bool GSRendererSW::CheckSourcePages(SharedData* sd)
 		{
 			sd->m_tex[i].t->m_offset->GetPages(sd->m_tex[i].r, m_tmp_pages); 
 
-			uint32* pages = m_tmp_pages; // sd->m_tex[i].t->m_pages.n;
+			// TODO: 8H 4HL 4HH texture at the same place as the render target (24 bit, or 32-bit where the alpha channel is masked, Valkyrie Profile 2)
 
-			for(const uint32* p = pages; *p != GSOffset::EOP; p++)
-			{
-				// TODO: 8H 4HL 4HH texture at the same place as the render target (24 bit, or 32-bit where the alpha channel is masked, Valkyrie Profile 2)
+			// currently being drawn to? => wait, and for the draws still reading the texture, 
+			// its invalidated parts are about to be updated
 
-				if(m_fzb_pages[*p]) // currently being drawn to? => sync
+			for(const uint32* p = m_tmp_pages; *p != GSOffset::EOP; p++)
+			{
+				if(m_fzb_pages[*p])
 				{
-					return true;
+					WaitPages(m_tmp_pages, 0xffffffff, true);
+
+					break;
 				}
 			}
 		}
 	}
-
-	return false;
 }
 
 #include "GSTextureSW.h"
@@ -1524,7 +1687,6 @@ GSRendererSW::SharedData::SharedData(GSRendererSW* parent)
 	, m_fpsm(0)
 	, m_zpsm(0)
 	, m_using_pages(false)
-	, m_syncpoint(SyncNone)
 {
 	m_tex[0].t = NULL;
 
@@ -1629,7 +1791,7 @@ void GSRendererSW::SharedData::UpdateSource()
 {
 	for(size_t i = 0; m_tex[i].t != NULL; i++)
 	{
-		if(m_tex[i].t->Update(m_tex[i].r))
+		if(m_tex[i].t->Update(m_tex[i].r, m_parent->m_rl))
 		{
 			global.tex[i] = m_tex[i].t->m_buff;
 		}
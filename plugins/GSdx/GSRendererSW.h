@@ -43,7 +43,6 @@ class GSRendererSW : public GSRenderer
 		int m_zpsm;
 		bool m_using_pages;
 		TextureLevel m_tex[7 + 1]; // NULL terminated
-		enum {SyncNone, SyncSource, SyncTarget} m_syncpoint;
 
 	public:
 		SharedData(GSRendererSW* parent);
@@ -88,13 +87,35 @@ protected:
 
 	void UsePages(const uint32* pages, const int type);
 	void ReleasePages(const uint32* pages, const int type);
+	void WaitPages(const uint32* pages, uint32 fzb_mask, bool tex);
 
-	bool CheckTargetPages(const uint32* fb_pages, const uint32* zb_pages, const GSVector4i& r);
-	bool CheckSourcePages(SharedData* sd);
+	void CheckTargetPages(const uint32* fb_pages, const uint32* zb_pages, const GSVector4i& r);
+	void CheckSourcePages(SharedData* sd);
 
 	bool GetScanlineGlobalData(SharedData* data);
 
+	// Selectors drawn with are logged per game, and their code is generated on a
+	// background thread the next time the game starts, before it is drawn with.
+
+	struct
+	{
+		bool enabled;
+		uint32 crc;
+		vector<uint64> sp, ds;
+		std::thread* thread;
+		std::atomic<bool> abort;
+	} m_jit;
+
+	string GetSelectorLogPath(uint32 crc);
+	void LoadSelectors();
+	void SaveSelectors();
+	void StartPrecompile();
+	void StopPrecompile();
+	void PrecompileThreadProc();
+
 public:
 	GSRendererSW(int threads);
 	virtual ~GSRendererSW();
+
+	void SetGameCRC(uint32 crc, int options);
 };
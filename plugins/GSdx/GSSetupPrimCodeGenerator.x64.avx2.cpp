@@ -0,0 +1,380 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "GSSetupPrimCodeGenerator.h"
+#include "GSVertexSW.h"
+
+#if _M_SSE >= 0x501 && (defined(_M_AMD64) || defined(_WIN64))
+
+using namespace Xbyak;
+
+void GSSetupPrimCodeGenerator::Generate()
+{
+	// r9 = vertex
+	// r10 = index
+	// rdx = &dscan
+	// r8 = &m_shift[0]
+	// r11 = &m_local
+
+	#ifdef _WIN64
+
+	sub(rsp, 8 + 2 * 16);
+
+	vmovdqa(ptr[rsp + 0], xmm6);
+	vmovdqa(ptr[rsp + 16], xmm7);
+
+	mov(r9, rcx);
+	mov(r10, rdx);
+	mov(rdx, r8);
+
+	#else
+
+	mov(r9, rdi);
+	mov(r10, rsi);
+
+	#endif
+
+	mov(r8, (size_t)&m_shift[0]);
+	mov(r11, (size_t)&m_local);
+
+	if((m_en.z || m_en.f) && m_sel.prim != GS_SPRITE_CLASS || m_en.t || m_en.c && m_sel.iip)
+	{
+		for(int i = 0; i < (m_sel.notest ? 2 : 5); i++)
+		{
+			vmovaps(Ymm(3 + i), ptr[r8 + i * sizeof(GSVector8)]);
+		}
+	}
+
+	Depth();
+
+	Texture();
+
+	Color();
+
+	#ifdef _WIN64
+
+	vmovdqa(xmm6, ptr[rsp + 0]);
+	vmovdqa(xmm7, ptr[rsp + 16]);
+
+	add(rsp, 8 + 2 * 16);
+
+	#endif
+
+	ret();
+}
+
+void GSSetupPrimCodeGenerator::Depth()
+{
+	if(!m_en.z && !m_en.f)
+	{
+		return;
+	}
+
+	if(m_sel.prim != GS_SPRITE_CLASS)
+	{
+		// GSVector4 dp8 = dscan.p * GSVector4::broadcast32(&shift[0]);
+
+		vbroadcastf128(ymm0, ptr[rdx + offsetof(GSVertexSW, p)]);
+
+		vmulps(ymm1, ymm0, ymm3);
+
+		if(m_en.z)
+		{
+			// m_local.d8.p.z = dp8.extract32<2>();
+
+			vextractps(ptr[r11 + offsetof(GSScanlineLocalData, d8.p.z)], xmm1, 2);
+		}
+		
+		if(m_en.f)
+		{
+			// m_local.d8.p.f = GSVector4i(dp8).extract32<3>();
+
+			vcvtps2dq(ymm2, ymm1);
+			vpextrd(ptr[r11 + offsetof(GSScanlineLocalData, d8.p.f)], xmm2, 3);
+		}
+
+		if(m_en.z)
+		{
+			// GSVector8 dz = GSVector8(dscan.p).zzzz();
+
+			vshufps(ymm2, ymm0, ymm0, _MM_SHUFFLE(2, 2, 2, 2));
+		}
+
+		if(m_en.f)
+		{
+			// GSVector8 df = GSVector8(dscan.p).wwww();
+
+			vshufps(ymm1, ymm0, ymm0, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+
+		for(int i = 0; i < (m_sel.notest ? 1 : 8); i++)
+		{
+			if(m_en.z)
+			{
+				// m_local.d[i].z = dz * shift[1 + i];
+
+				if(i < 4) vmulps(ymm0, ymm2, Ymm(4 + i));
+				else vmulps(ymm0, ymm2, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+				vmovaps(ptr[r11 + offsetof(GSScanlineLocalData, d[0].z) + i * sizeof(GSScanlineLocalData::skip)], ymm0);
+			}
+
+			if(m_en.f)
+			{
+				// m_local.d[i].f = GSVector8i(df * m_shift[i]).xxzzlh();
+
+				if(i < 4) vmulps(ymm0, ymm1, Ymm(4 + i));
+				else vmulps(ymm0, ymm1, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+				vcvttps2dq(ymm0, ymm0);
+				vpshuflw(ymm0, ymm0, _MM_SHUFFLE(2, 2, 0, 0));
+				vpshufhw(ymm0, ymm0, _MM_SHUFFLE(2, 2, 0, 0));
+				vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d[0].f) + i * sizeof(GSScanlineLocalData::skip)], ymm0);
+			}
+		}
+	}
+	else
+	{
+		// GSVector4 p = vertex[index[1]].p;
+
+		mov(ecx, ptr[r10 + sizeof(uint32) * 1]);
+		shl(ecx, 6); // * sizeof(GSVertexSW)
+		add(rcx, r9);
+
+		if(m_en.f)
+		{
+			// m_local.p.f = GSVector4i(vertex[index[1]].p).extract32<3>();
+
+			vmovaps(xmm0, ptr[rcx + offsetof(GSVertexSW, p)]);
+			vcvttps2dq(xmm0, xmm0);
+			vpextrd(ptr[r11 + offsetof(GSScanlineLocalData, p.f)], xmm0, 3);
+		}
+
+		if(m_en.z)
+		{
+			// m_local.p.z = vertex[index[1]].t.u32[3]; // uint32 z is bypassed in t.w
+
+			mov(eax, ptr[rcx + offsetof(GSVertexSW, t.w)]);
+			mov(ptr[r11 + offsetof(GSScanlineLocalData, p.z)], eax);
+		}
+	}
+}
+
+void GSSetupPrimCodeGenerator::Texture()
+{
+	if(!m_en.t)
+	{
+		return;
+	}
+
+	// GSVector8 dt(dscan.t);
+
+	vbroadcastf128(ymm0, ptr[rdx + offsetof(GSVertexSW, t)]);
+
+	// GSVector8 dt8 = dt * shift[0];
+
+	vmulps(ymm1, ymm0, ymm3);
+
+	if(m_sel.fst)
+	{
+		// m_local.d8.stq = GSVector8::cast(GSVector8i(dt8));
+
+		vcvttps2dq(ymm1, ymm1);
+
+		vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d8.stq)], xmm1);
+	}
+	else
+	{
+		// m_local.d8.stq = dt8;
+
+		vmovaps(ptr[r11 + offsetof(GSScanlineLocalData, d8.stq)], xmm1);
+	}
+
+	for(int j = 0, k = m_sel.fst ? 2 : 3; j < k; j++)
+	{
+		// GSVector8 dstq = dt.xxxx/yyyy/zzzz();
+
+		vshufps(ymm1, ymm0, ymm0, (uint8)_MM_SHUFFLE(j, j, j, j));
+
+		for(int i = 0; i < (m_sel.notest ? 1 : 8); i++)
+		{
+			// GSVector8 v = dstq * shift[1 + i];
+
+			if(i < 4) vmulps(ymm2, ymm1, Ymm(4 + i));
+			else vmulps(ymm2, ymm1, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+
+			if(m_sel.fst)
+			{
+				// m_local.d[i].s/t = GSVector8::cast(GSVector8i(v));
+
+				vcvttps2dq(ymm2, ymm2);
+
+				switch(j)
+				{
+				case 0: vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d[0].s) + i * sizeof(GSScanlineLocalData::skip)], ymm2); break;
+				case 1: vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d[0].t) + i * sizeof(GSScanlineLocalData::skip)], ymm2); break;
+				}
+			}
+			else
+			{
+				// m_local.d[i].s/t/q = v;
+
+				switch(j)
+				{
+				case 0: vmovaps(ptr[r11 + offsetof(GSScanlineLocalData, d[0].s) + i * sizeof(GSScanlineLocalData::skip)], ymm2); break;
+				case 1: vmovaps(ptr[r11 + offsetof(GSScanlineLocalData, d[0].t) + i * sizeof(GSScanlineLocalData::skip)], ymm2); break;
+				case 2: vmovaps(ptr[r11 + offsetof(GSScanlineLocalData, d[0].q) + i * sizeof(GSScanlineLocalData::skip)], ymm2); break;
+				}
+			}
+		}
+	}
+}
+
+void GSSetupPrimCodeGenerator::Color()
+{
+	if(!m_en.c)
+	{
+		return;
+	}
+
+	if(m_sel.iip)
+	{
+		// GSVector8 dc(dscan.c);
+
+		vbroadcastf128(ymm0, ptr[rdx + offsetof(GSVertexSW, c)]);
+
+		// m_local.d8.c = GSVector8i(dc * shift[0]).xzyw().ps32();
+
+		vmulps(ymm1, ymm0, ymm3);
+		vcvttps2dq(ymm1, ymm1);
+		vpshufd(ymm1, ymm1, _MM_SHUFFLE(3, 1, 2, 0));
+		vpackssdw(ymm1, ymm1);
+		vmovq(ptr[r11 + offsetof(GSScanlineLocalData, d8.c)], xmm1);
+
+		// ymm3 is not needed anymore
+
+		// GSVector8 dr = dc.xxxx();
+		// GSVector8 db = dc.zzzz();
+
+		vshufps(ymm2, ymm0, ymm0, _MM_SHUFFLE(0, 0, 0, 0));
+		vshufps(ymm3, ymm0, ymm0, _MM_SHUFFLE(2, 2, 2, 2));
+
+		for(int i = 0; i < (m_sel.notest ? 1 : 8); i++)
+		{
+			// GSVector8i r = GSVector8i(dr * shift[1 + i]).ps32();
+
+			if(i < 4) vmulps(ymm0, ymm2, Ymm(4 + i));
+			else vmulps(ymm0, ymm2, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+			vcvttps2dq(ymm0, ymm0);
+			vpackssdw(ymm0, ymm0);
+
+			// GSVector4i b = GSVector8i(db * shift[1 + i]).ps32();
+
+			if(i < 4) vmulps(ymm1, ymm3, Ymm(4 + i));
+			else vmulps(ymm1, ymm3, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+			vcvttps2dq(ymm1, ymm1);
+			vpackssdw(ymm1, ymm1);
+
+			// m_local.d[i].rb = r.upl16(b);
+
+			vpunpcklwd(ymm0, ymm1);
+			vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d[0].rb) + i * sizeof(GSScanlineLocalData::skip)], ymm0);
+		}
+
+		// GSVector8 dc(dscan.c);
+
+		vbroadcastf128(ymm0, ptr[rdx + offsetof(GSVertexSW, c)]); // not enough regs, have to reload it
+
+		// GSVector8 dg = dc.yyyy();
+		// GSVector8 da = dc.wwww();
+
+		vshufps(ymm2, ymm0, ymm0, _MM_SHUFFLE(1, 1, 1, 1));
+		vshufps(ymm3, ymm0, ymm0, _MM_SHUFFLE(3, 3, 3, 3));
+
+		for(int i = 0; i < (m_sel.notest ? 1 : 8); i++)
+		{
+			// GSVector8i g = GSVector8i(dg * shift[1 + i]).ps32();
+
+			if(i < 4) vmulps(ymm0, ymm2, Ymm(4 + i));
+			else vmulps(ymm0, ymm2, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+			vcvttps2dq(ymm0, ymm0);
+			vpackssdw(ymm0, ymm0);
+
+			// GSVector8i a = GSVector8i(da * shift[1 + i]).ps32();
+
+			if(i < 4) vmulps(ymm1, ymm3, Ymm(4 + i));
+			else vmulps(ymm1, ymm3, ptr[r8 + (i + 1) * sizeof(GSVector8)]);
+			vcvttps2dq(ymm1, ymm1);
+			vpackssdw(ymm1, ymm1);
+
+			// m_local.d[i].ga = g.upl16(a);
+
+			vpunpcklwd(ymm0, ymm1);
+			vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, d[0].ga) + i * sizeof(GSScanlineLocalData::skip)], ymm0);
+		}
+	}
+	else
+	{
+		// GSVector8i c = GSVector8i(GSVector8(vertex[index[last]].c));
+
+		int last = 0;
+
+		switch(m_sel.prim)
+		{
+		case GS_POINT_CLASS: last = 0; break;
+		case GS_LINE_CLASS: last = 1; break;
+		case GS_TRIANGLE_CLASS: last = 2; break;
+		case GS_SPRITE_CLASS: last = 1; break;
+		}
+
+		if(!(m_sel.prim == GS_SPRITE_CLASS && (m_en.z || m_en.f))) // if this is a sprite, the last vertex was already loaded in Depth()
+		{
+			mov(ecx, ptr[r10 + sizeof(uint32) * last]);
+			shl(ecx, 6); // * sizeof(GSVertexSW)
+			add(rcx, r9);
+		}
+
+		vbroadcasti128(ymm0, ptr[rcx + offsetof(GSVertexSW, c)]);
+		vcvttps2dq(ymm0, ymm0);
+
+		// c = c.upl16(c.zwxy());
+
+		vpshufd(ymm1, ymm0, _MM_SHUFFLE(1, 0, 3, 2));
+		vpunpcklwd(ymm0, ymm1);
+
+		// if(!tme) c = c.srl16(7);
+
+		if(m_sel.tfx == TFX_NONE)
+		{
+			vpsrlw(ymm0, 7);
+		}
+
+		// m_local.c.rb = c.xxxx();
+		// m_local.c.ga = c.zzzz();
+
+		vpshufd(ymm1, ymm0, _MM_SHUFFLE(0, 0, 0, 0));
+		vpshufd(ymm2, ymm0, _MM_SHUFFLE(2, 2, 2, 2));
+
+		vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, c.rb)], ymm1);
+		vmovdqa(ptr[r11 + offsetof(GSScanlineLocalData, c.ga)], ymm2);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include "stdafx.h"
 #include "GSTextureCacheSW.h"
+#include "GSRasterizer.h"
 
 GSTextureCacheSW::GSTextureCacheSW(GSState* state)
 	: m_state(state)
@@ -38,83 +39,167 @@ GSTextureCacheSW::Texture* GSTextureCacheSW::Lookup(const GIFRegTEX0& TEX0, cons
 
 	Texture* t = NULL;
 
-	list<Texture*>& m = m_map[TEX0.TBP0 >> 5];
+	const vector<uint32>& m = m_map[TEX0.TBP0 >> 5];
 
-	for(list<Texture*>::iterator i = m.begin(); i != m.end(); i++)
+	for(size_t i = 0; i < m.size() && t == NULL; i++)
 	{
-		Texture* t2 = *i;
+		unsigned long j;
 
-		if(((TEX0.u32[0] ^ t2->m_TEX0.u32[0]) | ((TEX0.u32[1] ^ t2->m_TEX0.u32[1]) & 3)) != 0) // TBP0 TBW PSM TW TH
+		for(uint32 p = m[i]; _BitScanForward(&j, p); p ^= 1 << j)
 		{
-			continue;
-		}
+			Texture* t2 = m_slots[(i << 5) + j];
 
-		if((psm.trbpp == 16 || psm.trbpp == 24) && TEX0.TCC && TEXA != t2->m_TEXA)
-		{
-			continue;
-		}
+			if(((TEX0.u32[0] ^ t2->m_TEX0.u32[0]) | ((TEX0.u32[1] ^ t2->m_TEX0.u32[1]) & 3)) != 0) // TBP0 TBW PSM TW TH
+			{
+				continue;
+			}
 
-		if(tw0 != 0 && t2->m_tw != tw0)
-		{
-			continue;
-		}
+			if((psm.trbpp == 16 || psm.trbpp == 24) && TEX0.TCC && TEXA != t2->m_TEXA)
+			{
+				continue;
+			}
 
-		m.splice(m.begin(), m, i);
+			if(tw0 != 0 && t2->m_tw != tw0)
+			{
+				continue;
+			}
 
-		t = t2;
+			t = t2;
 
-		t->m_age = 0;
+			t->m_age = 0;
 
-		break;
+			break;
+		}
 	}
 
 	if(t == NULL)
 	{
 		t = new Texture(m_state, tw0, TEX0, TEXA);
 
-		m_textures.insert(t);
+		Add(t);
+	}
+
+	return t;
+}
+
+void GSTextureCacheSW::Add(Texture* t)
+{
+	if(m_free_slots.empty())
+	{
+		m_free_slots.push_back(m_slots.size());
+
+		m_slots.push_back(NULL);
+	}
+
+	t->m_slot = m_free_slots.back();
+
+	m_free_slots.pop_back();
+
+	m_slots[t->m_slot] = t;
 
-		for(const uint32* p = t->m_pages.n; *p != GSOffset::EOP; p++)
+	m_textures.insert(t);
+
+	uint32 row = t->m_slot >> 5;
+	uint32 col = 1 << (t->m_slot & 31);
+
+	for(const uint32* p = t->m_pages.n; *p != GSOffset::EOP; p++)
+	{
+		vector<uint32>& m = m_map[*p];
+
+		if(m.size() <= row)
 		{
-			m_map[*p].push_front(t);
+			m.resize(row + 1, 0);
 		}
+
+		m[row] |= col;
+	}
+}
+
+void GSTextureCacheSW::Remove(Texture* t)
+{
+	uint32 row = t->m_slot >> 5;
+	uint32 col = 1 << (t->m_slot & 31);
+
+	for(const uint32* p = t->m_pages.n; *p != GSOffset::EOP; p++)
+	{
+		m_map[*p][row] &= ~col;
 	}
 
-	return t;
+	m_slots[t->m_slot] = NULL;
+
+	m_free_slots.push_back(t->m_slot);
+
+	m_textures.erase(t);
+
+	delete t;
 }
 
 void GSTextureCacheSW::InvalidatePages(const uint32* pages, uint32 psm)
 {
+	// the textures covering any of the pages, and the pages as a bitmap
+
+	uint32 bm[16];
+
+	memset(bm, 0, sizeof(bm));
+
+	m_hit.assign((m_slots.size() + 31) >> 5, 0);
+
 	for(const uint32* p = pages; *p != GSOffset::EOP; p++)
 	{
 		uint32 page = *p;
 
-		const list<Texture*>& map = m_map[page];
+		bm[page >> 5] |= 1 << (page & 31);
+
+		const vector<uint32>& m = m_map[page];
 
-		for(list<Texture*>::const_iterator i = map.begin(); i != map.end(); i++)
+		for(size_t i = 0; i < m.size(); i++)
 		{
-			Texture* t = *i;
+			m_hit[i] |= m[i];
+		}
+	}
+
+	// then the pages of each of them, from its own page bitmap
 
-			if(GSUtil::HasSharedBits(psm, t->m_sharedbits))
+	for(size_t i = 0; i < m_hit.size(); i++)
+	{
+		unsigned long j;
+
+		for(uint32 h = m_hit[i]; _BitScanForward(&j, h); h ^= 1 << j)
+		{
+			Texture* t = m_slots[(i << 5) + j];
+
+			if(!GSUtil::HasSharedBits(psm, t->m_sharedbits))
+			{
+				continue;
+			}
+
+			uint32* RESTRICT valid = t->m_valid;
+
+			for(int k = 0; k < 16; k++)
 			{
-				uint32* RESTRICT valid = t->m_valid;
+				unsigned long l;
 
-				if(t->m_repeating)
+				for(uint32 p = bm[k] & t->m_pages.bm[k]; _BitScanForward(&l, p); p ^= 1 << l)
 				{
-					vector<GSVector2i>& l = t->m_p2t[page];
+					uint32 page = (k << 5) + l;
 
-					for(vector<GSVector2i>::iterator j = l.begin(); j != l.end(); j++)
+					if(t->m_repeating)
 					{
-						valid[j->x] &= j->y;
+						vector<GSVector2i>& v = t->m_p2t[page];
+
+						for(vector<GSVector2i>::iterator n = v.begin(); n != v.end(); n++)
+						{
+							valid[n->x] &= n->y;
+						}
+					}
+					else
+					{
+						valid[page] = 0;
 					}
 				}
-				else
-				{
-					valid[page] = 0;
-				}
-
-				t->m_complete = false;
 			}
+
+			t->m_complete = false;
 		}
 	}
 }
@@ -125,6 +210,9 @@ void GSTextureCacheSW::RemoveAll()
 
 	m_textures.clear();
 
+	m_slots.clear();
+	m_free_slots.clear();
+
 	for(int i = 0; i < MAX_PAGES; i++)
 	{
 		m_map[i].clear();
@@ -135,27 +223,11 @@ void GSTextureCacheSW::IncAge()
 {
 	for(hash_set<Texture*>::iterator i = m_textures.begin(); i != m_textures.end(); )
 	{
-		hash_set<Texture*>::iterator j = i++;
-
-		Texture* t = *j;
+		Texture* t = *i++;
 
 		if(++t->m_age > 10)
 		{
-			m_textures.erase(j);
-
-			for(const uint32* p = t->m_pages.n; *p != GSOffset::EOP; p++)
-			{
-				list<Texture*>& m = m_map[*p];
-
-				for(list<Texture*>::iterator i = m.begin(); i != m.end(); )
-				{
-					list<Texture*>::iterator j = i++;
-
-					if(*j == t) {m.erase(j); break;}
-				}
-			}
-
-			delete t;
+			Remove(t);
 		}
 	}
 }
@@ -167,6 +239,7 @@ GSTextureCacheSW::Texture::Texture(GSState* state, uint32 tw0, const GIFRegTEX0&
 	, m_buff(NULL)
 	, m_tw(tw0)
 	, m_age(0)
+	, m_slot(0)
 	, m_complete(false)
 	, m_p2t(NULL)
 {
@@ -212,7 +285,7 @@ GSTextureCacheSW::Texture::~Texture()
 	}
 }
 
-bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
+bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect, IRasterizer* rl)
 {
 	if(m_complete)
 	{
@@ -253,13 +326,19 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 
 	const GSOffset* RESTRICT off = m_offset;
 
-	uint32 blocks = 0;
-
 	GSLocalMemory::readTextureBlock rtxbP = psm.rtxbP;
 
 	uint32 pitch = (1 << m_tw) << shift;
 
-	uint8* dst = (uint8*)m_buff + pitch * r.top;
+	uint8* base_dst = (uint8*)m_buff;
+
+	uint8* dst = base_dst + pitch * r.top;
+
+	// the invalid blocks are listed first (block, offset in m_buff), then decoded
+
+	static vector<GSVector2i> dirty; // only used by the thread queueing the draws
+
+	dirty.clear();
 
 	int block_pitch = pitch * bs.y;
 
@@ -289,9 +368,7 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 					{
 						m_valid[row] |= col;
 
-						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
-
-						blocks++;
+						dirty.push_back(GSVector2i((int)block, (int)(dst - base_dst) + (x << shift)));
 					}
 				}
 			}
@@ -316,17 +393,42 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 					{
 						m_valid[row] |= col;
 
-						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
-
-						blocks++;
+						dirty.push_back(GSVector2i((int)block, (int)(dst - base_dst) + (x << shift)));
 					}
 				}
 			}
 		}
 	}
 
+	int blocks = (int)dirty.size();
+
 	if(blocks > 0)
 	{
+		// a chunk is a few microseconds of work, the rendering threads only get the larger updates
+
+		const int chunk = 64;
+
+		GIFRegTEXA TEXA = m_TEXA;
+
+		auto decode = [&](int first, int last)
+		{
+			for(int i = first; i < last; i++)
+			{
+				(mem.*rtxbP)(dirty[i].x, &base_dst[dirty[i].y], pitch, TEXA);
+			}
+		};
+
+		if(rl != NULL && blocks >= chunk * 2)
+		{
+			rl->Run((blocks + chunk - 1) / chunk, [&](int i) {decode(i * chunk, std::min<int>((i + 1) * chunk, blocks));});
+
+			m_state->m_perfmon.Put(GSPerfMon::UnswizzleJobs, bs.x * bs.y * blocks << shift);
+		}
+		else
+		{
+			decode(0, blocks);
+		}
+
 		m_state->m_perfmon.Put(GSPerfMon::Unswizzle, bs.x * bs.y * blocks << shift);
 	}
 
@@ -23,6 +23,8 @@
 
 #include "GSRenderer.h"
 
+class IRasterizer;
+
 class GSTextureCacheSW
 {
 public:
@@ -36,6 +38,7 @@ public:
 		void* m_buff;
 		uint32 m_tw;
 		uint32 m_age;
+		uint32 m_slot;
 		bool m_complete;
 		bool m_repeating;
 		vector<GSVector2i>* m_p2t;
@@ -50,14 +53,20 @@ public:
 		Texture(GSState* state, uint32 tw0, const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA);
 		virtual ~Texture();
 
-		bool Update(const GSVector4i& r);
+		bool Update(const GSVector4i& r, IRasterizer* rl = NULL);
 		bool Save(const string& fn, bool dds = false) const;
 	};
 
 protected:
 	GSState* m_state;
 	hash_set<Texture*> m_textures;
-	list<Texture*> m_map[MAX_PAGES];
+	vector<Texture*> m_slots; // NULL when free
+	vector<uint32> m_free_slots;
+	vector<uint32> m_map[MAX_PAGES]; // bitset of the slots of the textures covering each page
+	vector<uint32> m_hit; // temporary of InvalidatePages
+
+	void Add(Texture* t);
+	void Remove(Texture* t);
 
 public:
 	GSTextureCacheSW(GSState* state);
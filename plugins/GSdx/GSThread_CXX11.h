@@ -96,11 +96,21 @@ public:
 	virtual int GetPixels(bool reset) = 0;
 };
 
+// The queue count is atomic, the lock and the condition variables are only used to
+// sleep. The worker spins a little before it parks, the draws come in bursts, and the
+// producer only takes the lock to wake it up when it's actually parked. Same for Wait.
+
 template<class T, int CAPACITY> class GSJobQueue : public IGSJobQueue<T>
 {
 protected:
+	enum {SPIN_COUNT = 1000}; // _mm_pause is 10-140 cycles depending on the cpu
+
 	std::atomic<int16_t> m_count;
 	std::atomic<bool> m_exit;
+	std::atomic<bool> m_parked; // worker sleeps on m_notempty
+	std::atomic<bool> m_waiting; // Wait sleeps on m_empty
+	std::atomic<int> m_wakeups;
+	std::atomic<int> m_parks;
 	ringbuffer_base<T, CAPACITY> m_queue;
 
 	std::mutex m_lock;
@@ -108,16 +118,24 @@ protected:
 	std::condition_variable m_notempty;
 
 	void ThreadProc() {
-		std::unique_lock<std::mutex> l(m_lock);
-
 		while (true) {
 
-			while (m_count == 0) {
-				if (m_exit.load(memory_order_acquire)) return;
-				m_notempty.wait(l);
-			}
+			for (int spin = 0; spin < SPIN_COUNT && m_count == 0; spin++)
+				_mm_pause();
 
-			l.unlock();
+			if (m_count == 0) {
+				std::unique_lock<std::mutex> l(m_lock);
+
+				m_parked = true;
+
+				while (m_count == 0) {
+					if (m_exit.load(memory_order_acquire)) return;
+					m_parks++;
+					m_notempty.wait(l);
+				}
+
+				m_parked.store(false, memory_order_relaxed);
+			}
 
 			int16_t consumed = 0;
 			for (int16_t nb = m_count; nb >= 0; nb--) {
@@ -125,27 +143,32 @@ protected:
 					consumed++;
 			}
 
-			l.lock();
+			if (m_count.fetch_sub(consumed) == consumed && m_waiting) {
+				std::unique_lock<std::mutex> l(m_lock);
 
-			m_count -= consumed;
-
-			if (m_count <= 0)
 				m_empty.notify_one();
-
+			}
 		}
 	}
 
 public:
 	GSJobQueue() :
 		m_count(0),
-		m_exit(false)
+		m_exit(false),
+		m_parked(false),
+		m_waiting(false),
+		m_wakeups(0),
+		m_parks(0)
 	{
 		this->CreateThread();
 	}
 
 	virtual ~GSJobQueue() {
 		m_exit.store(true, memory_order_release);
-		m_notempty.notify_one();
+		{
+			std::unique_lock<std::mutex> l(m_lock);
+			m_notempty.notify_one();
+		}
 		this->CloseThread();
 	}
 
@@ -159,26 +182,48 @@ public:
 		while(!m_queue.push(item))
 			std::this_thread::yield();
 
-		std::unique_lock<std::mutex> l(m_lock);
-
 		m_count++;
 
-		l.unlock();
+		// the worker sets m_parked before it checks m_count for the last time, and
+		// holds the lock until it waits, either it sees the new item or it gets notified
+
+		if (m_parked) {
+			std::unique_lock<std::mutex> l(m_lock);
+
+			m_wakeups++;
 
-		m_notempty.notify_one();
+			l.unlock();
+
+			m_notempty.notify_one();
+		}
 	}
 
 	void Wait() {
+		for (int spin = 0; spin < SPIN_COUNT && m_count > 0; spin++)
+			_mm_pause();
+
 		if (m_count > 0) {
 			std::unique_lock<std::mutex> l(m_lock);
+
+			m_waiting = true;
+
 			while (m_count > 0) {
 				m_empty.wait(l);
 			}
+
+			m_waiting = false;
 		}
 
 		ASSERT(m_count == 0);
 	}
 
+	// number of times the worker was woken up and went to sleep since the last call
+
+	void GetWakeStats(int& wakeups, int& parks) {
+		wakeups = m_wakeups.exchange(0);
+		parks = m_parks.exchange(0);
+	}
+
 	void operator() (T& item) {
 		this->Process(item);
 	}
@@ -4502,6 +4502,19 @@ public:
 
 	// TODO: swizzling
 
+	__forceinline static void sw4(GSVector8i& a, GSVector8i& b)
+	{
+		const __m256i epi32_0f0f0f0f = _mm256_set1_epi32(0x0f0f0f0f);
+
+		GSVector8i mask(epi32_0f0f0f0f);
+
+		GSVector8i c = (b << 4).blend(a, mask);
+		GSVector8i d = b.blend(a >> 4, mask);
+
+		a = c.upl8(d);
+		b = c.uph8(d);
+	}
+
 	__forceinline static void sw8(GSVector8i& a, GSVector8i& b)
 	{
 		GSVector8i c = a;
@@ -4520,6 +4533,24 @@ public:
 		b = c.uph16(d);
 	}
 
+	__forceinline static void sw16rl(GSVector8i& a, GSVector8i& b)
+	{
+		GSVector8i c = a;
+		GSVector8i d = b;
+
+		a = d.upl16(c);
+		b = c.uph16(d);
+	}
+
+	__forceinline static void sw16rh(GSVector8i& a, GSVector8i& b)
+	{
+		GSVector8i c = a;
+		GSVector8i d = b;
+
+		a = c.upl16(d);
+		b = d.uph16(c);
+	}
+
 	__forceinline static void sw32(GSVector8i& a, GSVector8i& b)
 	{
 		GSVector8i c = a;
@@ -0,0 +1,57 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#pragma once
+
+#include "GSWnd.h"
+
+// Window-less surface for headless replay (no X display, no GL context).
+// It only reports a client rect so GSDevice::Present has something to fit into.
+
+class GSWndNull : public GSWnd
+{
+	int m_w;
+	int m_h;
+
+public:
+	GSWndNull() : m_w(640), m_h(480) {}
+	virtual ~GSWndNull() {}
+
+	bool Create(const string& title, int w, int h)
+	{
+		if(w > 0) m_w = w;
+		if(h > 0) m_h = h;
+
+		return true;
+	}
+
+	bool Attach(void* handle, bool managed = true) {m_managed = managed; return true;}
+	void Detach() {}
+
+	void* GetDisplay() {return NULL;}
+	void* GetHandle() {return NULL;}
+	GSVector4i GetClientRect() {return GSVector4i(0, 0, m_w, m_h);}
+	bool SetWindowText(const char* title) {return true;}
+
+	void Show() {}
+	void Hide() {}
+	void HideFrame() {}
+};
@@ -299,6 +299,15 @@ void GSdxApp::SetConfigDir(const char* dir)
 	}
 }
 
+string GSdxApp::GetConfigPath(const char* name)
+{
+	// next to the ini, "inis/GSdx.ini" has a '/' on windows too
+
+	size_t i = m_ini.find_last_of("/\\");
+
+	return (i != string::npos ? m_ini.substr(0, i + 1) : string()) + name;
+}
+
 string GSdxApp::GetConfig(const char* entry, const char* value)
 {
 	char buff[4096] = {0};
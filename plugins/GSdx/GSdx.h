@@ -57,6 +57,7 @@ public:
 	void SetConfig(const char* entry, int value);
 
 	void SetConfigDir(const char* dir);
+	string GetConfigPath(const char* name);
 
 	vector<GSSetting> m_gs_renderers;
 	vector<GSSetting> m_gs_interlace;
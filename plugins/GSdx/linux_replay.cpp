@@ -29,6 +29,13 @@ void help()
 	fprintf(stderr, "ARG1 GSdx plugin\n");
 	fprintf(stderr, "ARG2 .gs file\n");
 	fprintf(stderr, "ARG3 Ini directory\n");
+	fprintf(stderr, "\nWith --benchmark as ARG2, times the GS memory transfers and texture reads instead\n");
+	fprintf(stderr, "\nGSdx.ini replay options:\n");
+	fprintf(stderr, "linux_replay = N              replay the dump N times\n");
+	fprintf(stderr, "linux_replay_headless = 1     software renderer without window nor GPU\n");
+	fprintf(stderr, "linux_replay_stats = 1|2      per frame stats as CSV (1) or JSON (2)\n");
+	fprintf(stderr, "linux_replay_stats_file = f   write stats to f instead of stdout\n");
+	fprintf(stderr, "linux_replay_scaling = N      headless, compare 0 to N extra rendering threads\n");
 	if (handle) {
 		dlclose(handle);
 	}
@@ -66,9 +73,21 @@ int main ( int argc, char *argv[] )
 
 	__attribute__((stdcall)) void (*GSsetSettingsDir_ptr)(const char*);
 	__attribute__((stdcall)) void (*GSReplay_ptr)(char*, int);
+	__attribute__((stdcall)) void (*GSBenchmark_ptr)(char*);
 
 	*(void**)(&GSsetSettingsDir_ptr) = dlsym(handle, "GSsetSettingsDir");
 	*(void**)(&GSReplay_ptr) = dlsym(handle, "GSReplay");
+	*(void**)(&GSBenchmark_ptr) = dlsym(handle, "GSBenchmark");
+
+	if (gs && strcmp(gs, "--benchmark") == 0) {
+		if (!GSBenchmark_ptr) {
+			fprintf(stderr, "Failed to find GSBenchmark in %s\n", plugin);
+			help();
+		}
+		GSBenchmark_ptr(gs);
+		dlclose(handle);
+		return 0;
+	}
 
 	if (argc == 2) {
 		char *ini = read_env("GSDUMP_CONF");
@@ -101,6 +101,7 @@ typedef int64 sint64;
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 
 using namespace std;
 
@@ -276,7 +277,9 @@ using namespace stdext;
 #endif
 
 // sse
-#if defined(__GNUC__) && !defined(__x86_64__)
+// x64 only has an AVX2 code generator, the narrower builds keep the SSE2 level there.
+// It's still experimental, so it also needs to be asked for (cmake -DGSDX_X64_AVX2=TRUE).
+#if defined(__GNUC__) && (!defined(__x86_64__) || defined(__AVX2__) && defined(GSDX_X64_AVX2))
 // Convert gcc see define into GSdx (windows) define
 #if defined(__AVX2__)
 	#define _M_SSE 0x501
@@ -17,6 +17,11 @@
 
 #include "Global.h"
 
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#	include <smmintrin.h>
+#endif
+
 // Games have turned out to be surprisingly sensitive to whether a parked, silent voice is being fully emulated.
 // With Silent Hill: Shattered Memories requiring full processing for no obvious reason, we've decided to
 // disable the optimisation until we can tie it to the game database.
@@ -285,18 +290,20 @@ static s32 rotl(u32 x, u32 s)
 }
 #endif
 
+// Noise generator state, saved and restored by the replay compare mode.
+static s32 NoiseSeed = 0x41595321;
+
 static s32 __forceinline GetNoiseValues()
 {
-	static s32 Seed = 0x41595321;
 	s32 retval = 0x8000;
 	
-	if( Seed&0x100 )
-		retval = (Seed&0xff) << 8;
-	else if( Seed&0xffff )
+	if( NoiseSeed&0x100 )
+		retval = (NoiseSeed&0xff) << 8;
+	else if( NoiseSeed&0xffff )
 		retval = 0x7fff;
 #ifdef _WIN32
 	__asm {
-		MOV eax,Seed
+		MOV eax,NoiseSeed
 		ROR eax,5
 		XOR eax,0x9a
 		MOV ebx,eax
@@ -304,7 +311,7 @@ static s32 __forceinline GetNoiseValues()
 		ADD eax,ebx
 		XOR eax,ebx
 		ROR eax,3
-		MOV Seed,eax
+		MOV NoiseSeed,eax
 	}
 #elif !defined(__clang__) // Linux with GCC
 	__asm__ (
@@ -318,17 +325,17 @@ static s32 __forceinline GetNoiseValues()
 		"XOR %%eax,%%esi\n"
 		"ROR %%eax,3\n"
 		"MOV %0,%%eax\n"
-		".att_syntax\n" : "=r"(Seed) :"r"(Seed)
+		".att_syntax\n" : "=r"(NoiseSeed) :"r"(NoiseSeed)
 		: "%eax", "%esi"
 		);
 #else // Clang and others
-	s32 s = rotr(Seed,5);
+	s32 s = rotr(NoiseSeed,5);
 	s ^= 0x9a;
 	s32 k = rotl(s,2);
 	k+=s;
 	k^=s;
 	k = rotr(k,3);
-	Seed=k;
+	NoiseSeed=k;
 #endif
 	return retval;
 }
@@ -401,41 +408,124 @@ static __forceinline void CalculateADSR( V_Core& thiscore, uint voiceidx )
 	jASSUME( vc.ADSR.Value >= 0 );	// ADSR should never be negative...
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                     //
+
+// The voices of a core are mixed in two passes.  AdvanceVoice runs through the voices in
+// order and does everything which touches SPU2 memory, IRQs or the state read by the next
+// voice (ADPCM fetch, pitch modulation, ADSR, crest and the raw output writes), leaving the
+// samples and gains of each voice in a VoiceLanes block.  MixVoiceLanes then interpolates,
+// applies the envelope and volume, and gates 4 voices at a time with SSE.
+//
+// The vector ops are the same integer ops as the scalar ones (wrapping 32 bit multiplies,
+// arithmetic shifts, 64 bit MulShr32), so the output is bit for bit the same as mixing the
+// voices one at a time.  The replay compare mode (see s2r_compare) checks this against the
+// scalar reference mixer below.
+
+struct VoiceLanes
+{
+	__aligned16 s32 PV1[V_Core::NumVoices];
+	__aligned16 s32 PV2[V_Core::NumVoices];
+	__aligned16 s32 PV3[V_Core::NumVoices];
+	__aligned16 s32 PV4[V_Core::NumVoices];
+	__aligned16 s32 SP[V_Core::NumVoices];
+
+	__aligned16 s32 Noise[V_Core::NumVoices];		// noise source value
+	__aligned16 s32 NoiseMask[V_Core::NumVoices];	// -1 for noise voices
+	__aligned16 s32 Envelope[V_Core::NumVoices];	// ADSR value, 0 for voices which are off
+	__aligned16 s32 VolL[V_Core::NumVoices];
+	__aligned16 s32 VolR[V_Core::NumVoices];
+};
+
+// Low 32 bits of the products, like a s32 multiply.
+static __forceinline __m128i MulLo32x4( const __m128i& a, const __m128i& b )
+{
+#if defined(__SSE4_1__) || defined(__AVX__)
+	return _mm_mullo_epi32( a, b );
+#else
+	const __m128i even	= _mm_mul_epu32( a, b );
+	const __m128i odd	= _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE(0,0,2,0) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE(0,0,2,0) ) );
+#endif
+}
+
+// Vector MulShr32: high 32 bits of the signed 64 bit products.
+static __forceinline __m128i MulShr32x4( const __m128i& a, const __m128i& b )
+{
+#if defined(__SSE4_1__) || defined(__AVX__)
+	const __m128i even	= _mm_mul_epi32( a, b );
+	const __m128i odd	= _mm_mul_epi32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE(0,0,3,1) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE(0,0,3,1) ) );
+#else
+	// Unsigned products, then the high words are corrected for the negative inputs.
+	const __m128i even	= _mm_mul_epu32( a, b );
+	const __m128i odd	= _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+
+	__m128i hi = _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE(0,0,3,1) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE(0,0,3,1) ) );
+	hi = _mm_sub_epi32( hi, _mm_and_si128( _mm_srai_epi32( a, 31 ), b ) );
+	hi = _mm_sub_epi32( hi, _mm_and_si128( _mm_srai_epi32( b, 31 ), a ) );
+	return hi;
+#endif
+}
+
+static __forceinline __m128i MulShr12x4( const __m128i& a, const __m128i& mu )
+{
+	return _mm_srai_epi32( MulLo32x4( a, mu ), 12 );
+}
+
 /*
    Tension: 65535 is high, 32768 is normal, 0 is low
 */
 template<s32 i_tension>
  __forceinline
-static s32 HermiteInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
+static __m128i HermiteInterpolate(
+	const __m128i& y0, // 16.0
+	const __m128i& y1, // 16.0
+	const __m128i& y2, // 16.0
+	const __m128i& y3, // 16.0
+	const __m128i& mu  //  0.12
 	)
 {
-	s32 m00 = ((y1-y0)*i_tension) >> 16; // 16.0
-	s32 m01 = ((y2-y1)*i_tension) >> 16; // 16.0
-	s32 m0  = m00 + m01;
+	const __m128i tension = _mm_set1_epi32( i_tension );
 
-	s32 m10 = ((y2-y1)*i_tension) >> 16; // 16.0
-	s32 m11 = ((y3-y2)*i_tension) >> 16; // 16.0
-	s32 m1  = m10 + m11;
+	__m128i m00 = _mm_srai_epi32( MulLo32x4( _mm_sub_epi32( y1, y0 ), tension ), 16 ); // 16.0
+	__m128i m01 = _mm_srai_epi32( MulLo32x4( _mm_sub_epi32( y2, y1 ), tension ), 16 ); // 16.0
+	__m128i m0  = _mm_add_epi32( m00, m01 );
 
-	s32 val = ((  2*y1 +   m0 + m1 - 2*y2) * mu) >> 12; // 16.0
-	val = ((val - 3*y1 - 2*m0 - m1 + 3*y2) * mu) >> 12; // 16.0
-	val = ((val        +   m0            ) * mu) >> 11; // 16.0
+	__m128i m10 = m01; // 16.0
+	__m128i m11 = _mm_srai_epi32( MulLo32x4( _mm_sub_epi32( y3, y2 ), tension ), 16 ); // 16.0
+	__m128i m1  = _mm_add_epi32( m10, m11 );
 
-	return(val + (y1<<1));
+	const __m128i y1x2 = _mm_slli_epi32( y1, 1 );
+	const __m128i y2x2 = _mm_slli_epi32( y2, 1 );
+
+	// ((  2*y1 +   m0 + m1 - 2*y2) * mu) >> 12
+	__m128i val = _mm_sub_epi32( _mm_add_epi32( _mm_add_epi32( y1x2, m0 ), m1 ), y2x2 );
+	val = MulShr12x4( val, mu );
+
+	// ((val - 3*y1 - 2*m0 - m1 + 3*y2) * mu) >> 12
+	val = _mm_sub_epi32( val, _mm_add_epi32( y1x2, y1 ) );
+	val = _mm_sub_epi32( val, _mm_slli_epi32( m0, 1 ) );
+	val = _mm_sub_epi32( val, m1 );
+	val = _mm_add_epi32( val, _mm_add_epi32( y2x2, y2 ) );
+	val = MulShr12x4( val, mu );
+
+	// ((val        +   m0            ) * mu) >> 11
+	val = _mm_srai_epi32( MulLo32x4( _mm_add_epi32( val, m0 ), mu ), 11 );
+
+	return _mm_add_epi32( val, y1x2 );
 }
 
 __forceinline
-static s32 CatmullRomInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
+static __m128i CatmullRomInterpolate(
+	const __m128i& y0, // 16.0
+	const __m128i& y1, // 16.0
+	const __m128i& y2, // 16.0
+	const __m128i& y3, // 16.0
+	const __m128i& mu  //  0.12
 	)
 {
 	//q(t) = 0.5 *(    	(2 * P1) +
@@ -443,43 +533,46 @@ static s32 CatmullRomInterpolate(
 	//	(2*P0 - 5*P1 + 4*P2 - P3) * t2 +
 	//	(-P0 + 3*P1- 3*P2 + P3) * t3)
 
-	s32 a3 = (-  y0 + 3*y1 - 3*y2 + y3);
-	s32 a2 = ( 2*y0 - 5*y1 + 4*y2 - y3);
-	s32 a1 = (-  y0        +   y2     );
-	s32 a0 = (        2*y1            );
+	const __m128i y1x3 = _mm_add_epi32( _mm_slli_epi32( y1, 1 ), y1 );
+	const __m128i y2x3 = _mm_add_epi32( _mm_slli_epi32( y2, 1 ), y2 );
 
-	s32 val = ((a3  ) * mu) >> 12;
-	val = ((a2 + val) * mu) >> 12;
-	val = ((a1 + val) * mu) >> 12;
+	__m128i a3 = _mm_add_epi32( _mm_sub_epi32( _mm_sub_epi32( y1x3, y0 ), y2x3 ), y3 );	// (-  y0 + 3*y1 - 3*y2 + y3)
+	__m128i a2 = _mm_sub_epi32( _mm_slli_epi32( y0, 1 ), _mm_add_epi32( _mm_slli_epi32( y1, 2 ), y1 ) );
+	a2 = _mm_sub_epi32( _mm_add_epi32( a2, _mm_slli_epi32( y2, 2 ) ), y3 );				// ( 2*y0 - 5*y1 + 4*y2 - y3)
+	__m128i a1 = _mm_sub_epi32( y2, y0 );												// (-  y0        +   y2     )
+	__m128i a0 = _mm_slli_epi32( y1, 1 );												// (        2*y1            )
 
-	return (a0 + val);
+	__m128i val = MulShr12x4( a3, mu );
+	val = MulShr12x4( _mm_add_epi32( a2, val ), mu );
+	val = MulShr12x4( _mm_add_epi32( a1, val ), mu );
+
+	return _mm_add_epi32( a0, val );
 }
 
 __forceinline
-static s32 CubicInterpolate(
-	s32 y0, // 16.0
-	s32 y1, // 16.0
-	s32 y2, // 16.0
-	s32 y3, // 16.0
-	s32 mu  //  0.12
+static __m128i CubicInterpolate(
+	const __m128i& y0, // 16.0
+	const __m128i& y1, // 16.0
+	const __m128i& y2, // 16.0
+	const __m128i& y3, // 16.0
+	const __m128i& mu  //  0.12
 	)
 {
-	const s32 a0 = y3 - y2 - y0 + y1;
-	const s32 a1 = y0 - y1 - a0;
-	const s32 a2 = y2 - y0;
+	const __m128i a0 = _mm_add_epi32( _mm_sub_epi32( _mm_sub_epi32( y3, y2 ), y0 ), y1 );	// y3 - y2 - y0 + y1
+	const __m128i a1 = _mm_sub_epi32( _mm_sub_epi32( y0, y1 ), a0 );						// y0 - y1 - a0
+	const __m128i a2 = _mm_sub_epi32( y2, y0 );
 
-	s32 val = ((  a0) * mu) >> 12;
-	val = ((val + a1) * mu) >> 12;
-	val = ((val + a2) * mu) >> 11;
+	__m128i val = MulShr12x4( a0, mu );
+	val = MulShr12x4( _mm_add_epi32( val, a1 ), mu );
+	val = _mm_srai_epi32( MulLo32x4( _mm_add_epi32( val, a2 ), mu ), 11 );
 
-	return(val + (y1<<1));
+	return _mm_add_epi32( val, _mm_slli_epi32( y1, 1 ) );
 }
 
-// Returns a 16 bit result in Value.
-// Uses standard template-style optimization techniques to statically generate five different
-// versions of this function (one for each type of interpolation).
+// Fetches the voice's samples up to its current position.  Only the cubic style
+// interpolators need PV3 and PV4.
 template< int InterpType >
-static __forceinline s32 GetVoiceValues( V_Core& thiscore, uint voiceidx )
+static __forceinline void FetchVoiceValues( V_Core& thiscore, uint voiceidx )
 {
 	V_Voice& vc( thiscore.Voices[voiceidx] );
 
@@ -494,22 +587,39 @@ static __forceinline s32 GetVoiceValues( V_Core& thiscore, uint voiceidx )
 		vc.PV1 = GetNextDataBuffered( thiscore, voiceidx );
 		vc.SP -= 4096;
 	}
+}
 
-	const s32 mu = vc.SP + 4096;
+// Returns 16 bit results for 4 voices starting at voiceidx.
+// Uses standard template-style optimization techniques to statically generate five different
+// versions of this function (one for each type of interpolation).
+template< int InterpType >
+static __forceinline __m128i GetVoiceValues( const VoiceLanes& lanes, uint voiceidx )
+{
+	const __m128i PV1	= _mm_load_si128( (const __m128i*)&lanes.PV1[voiceidx] );
+	const __m128i SP	= _mm_load_si128( (const __m128i*)&lanes.SP[voiceidx] );
+
+	if( InterpType == 0 )
+		return _mm_slli_epi32( PV1, 1 );
+
+	const __m128i PV2	= _mm_load_si128( (const __m128i*)&lanes.PV2[voiceidx] );
+
+	if( InterpType == 1 )
+		return _mm_sub_epi32( _mm_slli_epi32( PV1, 1 ), _mm_srai_epi32( MulLo32x4( _mm_sub_epi32( PV2, PV1 ), SP ), 11 ) );
+
+	const __m128i PV3	= _mm_load_si128( (const __m128i*)&lanes.PV3[voiceidx] );
+	const __m128i PV4	= _mm_load_si128( (const __m128i*)&lanes.PV4[voiceidx] );
+	const __m128i mu	= _mm_add_epi32( SP, _mm_set1_epi32( 4096 ) );
 
 	switch( InterpType )
 	{
-		case 0: return vc.PV1<<1;
-		case 1: return (vc.PV1<<1) - (( (vc.PV2 - vc.PV1) * vc.SP)>>11);
-
-		case 2: return CubicInterpolate				(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
-		case 3: return HermiteInterpolate<16384>	(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
-		case 4: return CatmullRomInterpolate		(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
+		case 2: return CubicInterpolate				(PV4, PV3, PV2, PV1, mu);
+		case 3: return HermiteInterpolate<16384>	(PV4, PV3, PV2, PV1, mu);
+		case 4: return CatmullRomInterpolate		(PV4, PV3, PV2, PV1, mu);
 
 		jNO_DEFAULT;
 	}
 
-	return 0;		// technically unreachable!
+	return _mm_setzero_si128();		// technically unreachable!
 }
 
 // Noise values need to be mixed without going through interpolation, since it
@@ -560,7 +670,9 @@ static __forceinline void spu2M_WriteFast( u32 addr, s16 value )
 }
 
 
-static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
+// Advances the voice by one sample and stores what's needed to mix it into lanes.
+template< int InterpType >
+static __forceinline void AdvanceVoice( uint coreidx, uint voiceidx, VoiceLanes& lanes )
 {
 	V_Core& thiscore( Cores[coreidx] );
 	V_Voice& vc( thiscore.Voices[voiceidx] );
@@ -575,6 +687,10 @@ static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
 
 	vc.Volume.Update();
 
+	// Voices which are off are mixed with a null envelope.
+	s32 Envelope = 0;
+	s32 Noise = 0;
+
 	// SPU2 Note: The spu2 continues to process voices for eternity, always, so we
 	// have to run through all the motions of updating the voice regardless of it's
 	// audible status.  Otherwise IRQs might not trigger and emulation might fail.
@@ -583,36 +699,20 @@ static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
 	{
 		UpdatePitch( coreidx, voiceidx );
 
-		s32 Value = 0;
-
 		if( vc.Noise )
-			Value = GetNoiseValues( thiscore, voiceidx );
+			Noise = GetNoiseValues( thiscore, voiceidx );
 		else
-		{
-			// Optimization : Forceinline'd Templated Dispatch Table.  Any halfwit compiler will
-			// turn this into a clever jump dispatch table (no call/rets, no compares, uber-efficient!)
-
-			switch( Interpolation )
-			{
-				case 0: Value = GetVoiceValues<0>( thiscore, voiceidx ); break;
-				case 1: Value = GetVoiceValues<1>( thiscore, voiceidx ); break;
-				case 2: Value = GetVoiceValues<2>( thiscore, voiceidx ); break;
-				case 3: Value = GetVoiceValues<3>( thiscore, voiceidx ); break;
-				case 4: Value = GetVoiceValues<4>( thiscore, voiceidx ); break;
-
-				jNO_DEFAULT;
-			}
-		}
+			FetchVoiceValues<InterpType>( thiscore, voiceidx );
 
-		// Update and Apply ADSR  (applies to normal and noise sources)
+		// Update ADSR  (applies to normal and noise sources, in MixVoiceLanes)
 		//
 		// Note!  It's very important that ADSR stay as accurate as possible.  By the way
 		// it is used, various sound effects can end prematurely if we truncate more than
 		// one or two bits.  Best result comes from no truncation at all, which is why we
-		// use a full 64-bit multiply/result here.
+		// use a full 64-bit multiply/result there.
 
 		CalculateADSR( thiscore, voiceidx );
-		Value	= MulShr32( Value, vc.ADSR.Value );
+		Envelope = vc.ADSR.Value;
 		
 		// Store Value for eventual modulation later
 		// Pseudonym's Crest calculation idea. Actually calculates a crest, unlike the old code which was just peak.
@@ -633,8 +733,6 @@ static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
 
 		if (voiceidx==1)      spu2M_WriteFast( ( (0==coreidx) ? 0x400 : 0xc00 ) + OutPos, vc.OutX );
 		else if (voiceidx==3) spu2M_WriteFast( ( (0==coreidx) ? 0x600 : 0xe00 ) + OutPos, vc.OutX );
-			
-		return ApplyVolume( StereoOut32( Value, Value ), vc.Volume );
 	}
 	else
 	{
@@ -654,28 +752,325 @@ static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
 		// Write-back of raw voice data (some zeros since the voice is "dead")
 		if (voiceidx==1)      spu2M_WriteFast( ( (0==coreidx) ? 0x400 : 0xc00 ) + OutPos, 0 );
 		else if (voiceidx==3) spu2M_WriteFast( ( (0==coreidx) ? 0x600 : 0xe00 ) + OutPos, 0 );
-
-		return StereoOut32( 0, 0 );
 	}
+
+	lanes.PV1[voiceidx]			= vc.PV1;
+	lanes.PV2[voiceidx]			= vc.PV2;
+	lanes.PV3[voiceidx]			= vc.PV3;
+	lanes.PV4[voiceidx]			= vc.PV4;
+	lanes.SP[voiceidx]			= vc.SP;
+	lanes.Noise[voiceidx]		= Noise;
+	lanes.NoiseMask[voiceidx]	= vc.Noise ? -1 : 0;
+	lanes.Envelope[voiceidx]	= Envelope;
+	lanes.VolL[voiceidx]		= vc.Volume.Left.Value;
+	lanes.VolR[voiceidx]		= vc.Volume.Right.Value;
 }
 
 const VoiceMixSet VoiceMixSet::Empty( (StereoOut32()), (StereoOut32()) );	// Don't use SteroOut32::Empty because C++ doesn't make any dep/order checks on global initializers.
 
-static __forceinline void MixCoreVoices( VoiceMixSet& dest, const uint coreidx )
+template< int InterpType >
+static __forceinline void MixVoiceLanes( VoiceMixSet& dest, const V_Core& thiscore, const VoiceLanes& lanes )
+{
+	__m128i DryL = _mm_setzero_si128();
+	__m128i DryR = _mm_setzero_si128();
+	__m128i WetL = _mm_setzero_si128();
+	__m128i WetR = _mm_setzero_si128();
+
+	for( uint voiceidx=0; voiceidx<V_Core::NumVoices; voiceidx+=4 )
+	{
+		// Noise sources skip the interpolation.
+		const __m128i noiseMask = _mm_load_si128( (const __m128i*)&lanes.NoiseMask[voiceidx] );
+		__m128i Value = GetVoiceValues<InterpType>( lanes, voiceidx );
+		Value = _mm_or_si128( _mm_andnot_si128( noiseMask, Value ), _mm_and_si128( noiseMask, _mm_load_si128( (const __m128i*)&lanes.Noise[voiceidx] ) ) );
+
+		// Apply ADSR and volume (see ApplyVolume).  Results are ranged at 16 bits.
+		Value = MulShr32x4( Value, _mm_load_si128( (const __m128i*)&lanes.Envelope[voiceidx] ) );
+		Value = _mm_slli_epi32( Value, 1 );
+
+		const __m128i Left	= MulShr32x4( Value, _mm_load_si128( (const __m128i*)&lanes.VolL[voiceidx] ) );
+		const __m128i Right	= MulShr32x4( Value, _mm_load_si128( (const __m128i*)&lanes.VolR[voiceidx] ) );
+
+		// Transpose the gates of the 4 voices (DryL, DryR, WetL, WetR each) into a lane per
+		// voice, and sign extend them to 32 bits masks.
+		const __m128i g01 = _mm_loadu_si128( (const __m128i*)&thiscore.VoiceGates[voiceidx] );
+		const __m128i g23 = _mm_loadu_si128( (const __m128i*)&thiscore.VoiceGates[voiceidx+2] );
+		const __m128i t0 = _mm_unpacklo_epi16( g01, g23 );
+		const __m128i t1 = _mm_unpackhi_epi16( g01, g23 );
+		const __m128i dry = _mm_unpacklo_epi16( t0, t1 );
+		const __m128i wet = _mm_unpackhi_epi16( t0, t1 );
+
+		DryL = _mm_add_epi32( DryL, _mm_and_si128( Left,  _mm_srai_epi32( _mm_unpacklo_epi16( dry, dry ), 16 ) ) );
+		DryR = _mm_add_epi32( DryR, _mm_and_si128( Right, _mm_srai_epi32( _mm_unpackhi_epi16( dry, dry ), 16 ) ) );
+		WetL = _mm_add_epi32( WetL, _mm_and_si128( Left,  _mm_srai_epi32( _mm_unpacklo_epi16( wet, wet ), 16 ) ) );
+		WetR = _mm_add_epi32( WetR, _mm_and_si128( Right, _mm_srai_epi32( _mm_unpackhi_epi16( wet, wet ), 16 ) ) );
+	}
+
+	// Sum the lanes: { DryL, DryR, WetL, WetR }
+	const __m128i dry = _mm_add_epi32( _mm_unpacklo_epi32( DryL, DryR ), _mm_unpackhi_epi32( DryL, DryR ) );
+	const __m128i wet = _mm_add_epi32( _mm_unpacklo_epi32( WetL, WetR ), _mm_unpackhi_epi32( WetL, WetR ) );
+
+	__aligned16 s32 sums[4];
+	_mm_store_si128( (__m128i*)sums, _mm_add_epi32( _mm_unpacklo_epi64( dry, wet ), _mm_unpackhi_epi64( dry, wet ) ) );
+
+	dest.Dry.Left	+= sums[0];
+	dest.Dry.Right	+= sums[1];
+	dest.Wet.Left	+= sums[2];
+	dest.Wet.Right	+= sums[3];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                     //
+
+// Scalar reference mixer, which mixes the voices one at a time like the mixer did before
+// MixVoiceLanes.  It's only run by the replay compare mode (see s2r_compare), to check the
+// SSE mixer against it on real logs.
+
+MixCompareState MixCompare;
+
+/*
+   Tension: 65535 is high, 32768 is normal, 0 is low
+*/
+template<s32 i_tension>
+ __forceinline
+static s32 HermiteInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+	)
+{
+	s32 m00 = ((y1-y0)*i_tension) >> 16; // 16.0
+	s32 m01 = ((y2-y1)*i_tension) >> 16; // 16.0
+	s32 m0  = m00 + m01;
+
+	s32 m10 = ((y2-y1)*i_tension) >> 16; // 16.0
+	s32 m11 = ((y3-y2)*i_tension) >> 16; // 16.0
+	s32 m1  = m10 + m11;
+
+	s32 val = ((  2*y1 +   m0 + m1 - 2*y2) * mu) >> 12; // 16.0
+	val = ((val - 3*y1 - 2*m0 - m1 + 3*y2) * mu) >> 12; // 16.0
+	val = ((val        +   m0            ) * mu) >> 11; // 16.0
+
+	return(val + (y1<<1));
+}
+
+__forceinline
+static s32 CatmullRomInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+	)
+{
+	s32 a3 = (-  y0 + 3*y1 - 3*y2 + y3);
+	s32 a2 = ( 2*y0 - 5*y1 + 4*y2 - y3);
+	s32 a1 = (-  y0        +   y2     );
+	s32 a0 = (        2*y1            );
+
+	s32 val = ((a3  ) * mu) >> 12;
+	val = ((a2 + val) * mu) >> 12;
+	val = ((a1 + val) * mu) >> 12;
+
+	return (a0 + val);
+}
+
+__forceinline
+static s32 CubicInterpolate(
+	s32 y0, // 16.0
+	s32 y1, // 16.0
+	s32 y2, // 16.0
+	s32 y3, // 16.0
+	s32 mu  //  0.12
+	)
+{
+	const s32 a0 = y3 - y2 - y0 + y1;
+	const s32 a1 = y0 - y1 - a0;
+	const s32 a2 = y2 - y0;
+
+	s32 val = ((  a0) * mu) >> 12;
+	val = ((val + a1) * mu) >> 12;
+	val = ((val + a2) * mu) >> 11;
+
+	return(val + (y1<<1));
+}
+
+// Returns a 16 bit result in Value.
+template< int InterpType >
+static __forceinline s32 GetVoiceValues( V_Core& thiscore, uint voiceidx )
+{
+	V_Voice& vc( thiscore.Voices[voiceidx] );
+
+	FetchVoiceValues<InterpType>( thiscore, voiceidx );
+
+	const s32 mu = vc.SP + 4096;
+
+	switch( InterpType )
+	{
+		case 0: return vc.PV1<<1;
+		case 1: return (vc.PV1<<1) - (( (vc.PV2 - vc.PV1) * vc.SP)>>11);
+
+		case 2: return CubicInterpolate				(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
+		case 3: return HermiteInterpolate<16384>	(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
+		case 4: return CatmullRomInterpolate		(vc.PV4, vc.PV3, vc.PV2, vc.PV1, mu);
+
+		jNO_DEFAULT;
+	}
+
+	return 0;		// technically unreachable!
+}
+
+template< int InterpType >
+static __forceinline StereoOut32 MixVoice( uint coreidx, uint voiceidx )
+{
+	V_Core& thiscore( Cores[coreidx] );
+	V_Voice& vc( thiscore.Voices[voiceidx] );
+
+	pxAssertMsg( (vc.SCurrent <= 28) && (vc.SCurrent != 0), "Current sample should always range from 1->28" );
+
+	vc.Volume.Update();
+
+	if( vc.ADSR.Phase > 0 )
+	{
+		UpdatePitch( coreidx, voiceidx );
+
+		s32 Value = 0;
+
+		if( vc.Noise )
+			Value = GetNoiseValues( thiscore, voiceidx );
+		else
+			Value = GetVoiceValues<InterpType>( thiscore, voiceidx );
+
+		CalculateADSR( thiscore, voiceidx );
+		Value	= MulShr32( Value, vc.ADSR.Value );
+
+		if(vc.PV1 < vc.NextCrest)
+		{
+			vc.OutX = MulShr32(vc.NextCrest, vc.ADSR.Value);
+			vc.NextCrest = -0x8000;
+		}
+		if(vc.PV1 > vc.PV2)
+		{
+			vc.NextCrest = vc.PV1;
+		}
+
+		if( IsDevBuild )
+			DebugCores[coreidx].Voices[voiceidx].displayPeak = std::max(DebugCores[coreidx].Voices[voiceidx].displayPeak,(s32)vc.OutX);
+
+		if (voiceidx==1)      spu2M_WriteFast( ( (0==coreidx) ? 0x400 : 0xc00 ) + OutPos, vc.OutX );
+		else if (voiceidx==3) spu2M_WriteFast( ( (0==coreidx) ? 0x600 : 0xe00 ) + OutPos, vc.OutX );
+
+		return ApplyVolume( StereoOut32( Value, Value ), vc.Volume );
+	}
+	else
+	{
+		if (NEVER_SKIP_VOICES
+			|| (*GetMemPtr(vc.NextA & 0xFFFF8) >> 8 & 3) != 3 || vc.LoopStartA != (vc.NextA & ~7)		// not in a tight loop
+			|| (Cores[0].IRQEnable && (Cores[0].IRQA & ~7) == vc.LoopStartA)	// or should be interrupting regularly
+			|| (Cores[1].IRQEnable && (Cores[1].IRQA & ~7) == vc.LoopStartA)
+			|| !(thiscore.Regs.ENDX & 1 << voiceidx))						// or isn't currently flagged as having passed the endpoint
+		{
+			UpdatePitch(coreidx, voiceidx);
+
+			while (vc.SP > 0)
+				GetNextDataDummy(thiscore, voiceidx); // Dummy is enough
+		}
+
+		if (voiceidx==1)      spu2M_WriteFast( ( (0==coreidx) ? 0x400 : 0xc00 ) + OutPos, 0 );
+		else if (voiceidx==3) spu2M_WriteFast( ( (0==coreidx) ? 0x600 : 0xe00 ) + OutPos, 0 );
+
+		return StereoOut32( 0, 0 );
+	}
+}
+
+// Mixes the voices of the core with the scalar mixer and then again (from the same state)
+// with the SSE one, which is the mix kept.  Records the first tick where the sums or the
+// voice states left behind differ.  The SPU2 memory writes and PCM cache fills are the same
+// for both passes, so only the state below needs to be rewound in between.
+template< int InterpType >
+static void CompareCoreVoices( VoiceMixSet& dest, const uint coreidx )
 {
 	V_Core& thiscore( Cores[coreidx] );
 
+	static V_Voice SavedVoices[V_Core::NumVoices];
+	static V_Voice ScalarVoices[V_Core::NumVoices];
+
+	memcpy( SavedVoices, thiscore.Voices, sizeof(SavedVoices) );
+	const u32	SavedENDX	= thiscore.Regs.ENDX;
+	const u16	SavedInfo	= Spdif.Info;
+	const bool	SavedIrq	= has_to_call_irq;
+	const s32	SavedSeed	= NoiseSeed;
+
+	VoiceMixSet Scalar( VoiceMixSet::Empty );
+
 	for( uint voiceidx=0; voiceidx<V_Core::NumVoices; ++voiceidx )
 	{
-		StereoOut32 VVal( MixVoice( coreidx, voiceidx ) );
+		StereoOut32 VVal( MixVoice<InterpType>( coreidx, voiceidx ) );
 
-		// Note: Results from MixVoice are ranged at 16 bits.
+		Scalar.Dry.Left		+= VVal.Left	& thiscore.VoiceGates[voiceidx].DryL;
+		Scalar.Dry.Right	+= VVal.Right	& thiscore.VoiceGates[voiceidx].DryR;
+		Scalar.Wet.Left		+= VVal.Left	& thiscore.VoiceGates[voiceidx].WetL;
+		Scalar.Wet.Right	+= VVal.Right	& thiscore.VoiceGates[voiceidx].WetR;
+	}
+
+	memcpy( ScalarVoices, thiscore.Voices, sizeof(ScalarVoices) );
+	const u32	ScalarENDX	= thiscore.Regs.ENDX;
+
+	memcpy( thiscore.Voices, SavedVoices, sizeof(SavedVoices) );
+	thiscore.Regs.ENDX	= SavedENDX;
+	Spdif.Info			= SavedInfo;
+	has_to_call_irq		= SavedIrq;
+	NoiseSeed			= SavedSeed;
 
-		dest.Dry.Left	+= VVal.Left	& thiscore.VoiceGates[voiceidx].DryL;
-		dest.Dry.Right	+= VVal.Right	& thiscore.VoiceGates[voiceidx].DryR;
-		dest.Wet.Left	+= VVal.Left	& thiscore.VoiceGates[voiceidx].WetL;
-		dest.Wet.Right	+= VVal.Right	& thiscore.VoiceGates[voiceidx].WetR;
+	VoiceMixSet Lanes( VoiceMixSet::Empty );
+	VoiceLanes lanes;
+
+	for( uint voiceidx=0; voiceidx<V_Core::NumVoices; ++voiceidx )
+		AdvanceVoice<InterpType>( coreidx, voiceidx, lanes );
+
+	MixVoiceLanes<InterpType>( Lanes, thiscore, lanes );
+
+	const bool SameMix =
+		Scalar.Dry.Left == Lanes.Dry.Left && Scalar.Dry.Right == Lanes.Dry.Right &&
+		Scalar.Wet.Left == Lanes.Wet.Left && Scalar.Wet.Right == Lanes.Wet.Right;
+
+	const bool SameState =
+		ScalarENDX == thiscore.Regs.ENDX &&
+		memcmp( ScalarVoices, thiscore.Voices, sizeof(ScalarVoices) ) == 0;
+
+	if( !MixCompare.Failed && !(SameMix && SameState) )
+	{
+		MixCompare.Failed		= true;
+		MixCompare.Tick			= Cycles;
+		MixCompare.Core			= coreidx;
+		MixCompare.StateDiffers	= !SameState;
+		MixCompare.Scalar		= Scalar;
+		MixCompare.Lanes		= Lanes;
 	}
+
+	dest.Dry.Left	+= Lanes.Dry.Left;
+	dest.Dry.Right	+= Lanes.Dry.Right;
+	dest.Wet.Left	+= Lanes.Wet.Left;
+	dest.Wet.Right	+= Lanes.Wet.Right;
+}
+
+template< int InterpType >
+static __forceinline void MixCoreVoices( VoiceMixSet& dest, const uint coreidx )
+{
+	if( MixCompare.Enabled )
+	{
+		CompareCoreVoices<InterpType>( dest, coreidx );
+		return;
+	}
+
+	VoiceLanes lanes;
+
+	for( uint voiceidx=0; voiceidx<V_Core::NumVoices; ++voiceidx )
+		AdvanceVoice<InterpType>( coreidx, voiceidx, lanes );
+
+	MixVoiceLanes<InterpType>( dest, Cores[coreidx], lanes );
 }
 
 StereoOut32 V_Core::Mix( const VoiceMixSet& inVoices, const StereoOut32& Input, const StereoOut32& Ext )
@@ -839,12 +1234,14 @@ StereoOut32 Apply_Dealias_Filter(StereoOut32 &SoundStream)
 // used to throttle the output rate of cache stat reports
 static int p_cachestat_counter=0;
 
+// Mixes one sample (one tick) of both cores and returns the final output.
 // Gcc does not want to inline it when lto is enabled because some functions growth too much.
 // The function is big enought to see any speed impact. -- Gregory
+template< int InterpType >
 #ifndef __POSIX__
 __forceinline
 #endif
-void Mix()
+static StereoOut32 MixSample()
 {
 	// Note: Playmode 4 is SPDIF, which overrides other inputs.
 	StereoOut32 InputData[2] =
@@ -864,8 +1261,8 @@ void Mix()
 
 	// Todo: Replace me with memzero initializer!
 	VoiceMixSet VoiceData[2] = { VoiceMixSet::Empty, VoiceMixSet::Empty };	// mixed voice data for each core.
-	MixCoreVoices( VoiceData[0], 0 );
-	MixCoreVoices( VoiceData[1], 1 );
+	MixCoreVoices<InterpType>( VoiceData[0], 0 );
+	MixCoreVoices<InterpType>( VoiceData[1], 1 );
 
 	StereoOut32 Ext( Cores[0].Mix( VoiceData[0], InputData[0], StereoOut32::Empty ) );
 
@@ -924,8 +1321,6 @@ void Mix()
 	// Configurable output volume
 	Out.Left *= FinalVolume;
 	Out.Right *= FinalVolume;
-	
-	SndBuffer::Write( Out );
 
 	// Update AutoDMA output positioning
 	OutPos++;
@@ -947,6 +1342,52 @@ void Mix()
 			g_counter_cache_ignores = 0;
 		}
 	}
+
+	return Out;
+}
+
+template< int InterpType >
+static __forceinline uint MixSamples( uint count )
+{
+	StereoOut32 Out[MixBlockSize];
+	uint mixed = 0;
+
+	while( true )
+	{
+		Out[mixed++] = MixSample<InterpType>();
+
+		if( mixed == count || has_to_call_irq ) break;
+		Cycles++;
+	}
+
+	SndBuffer::Write( Out, mixed );
+	return mixed;
+}
+
+// Mixes up to count (at most MixBlockSize) samples and writes them to the output buffer.
+// The first sample is mixed at the current tick, and Cycles is advanced before each of the
+// others.  Mixing stops early after a sample which raised an IRQ, so it gets signaled before
+// the next tick as usual.  Returns the number of samples mixed.
+uint MixBlock( uint count )
+{
+	pxAssert( count > 0 && count <= MixBlockSize );
+
+	// Optimization : Forceinline'd Templated Dispatch Table.  Any halfwit compiler will
+	// turn this into a clever jump dispatch table (no call/rets, no compares, uber-efficient!)
+	// The whole block is mixed with the same interpolation.
+
+	switch( Interpolation )
+	{
+		case 0: return MixSamples<0>( count );
+		case 1: return MixSamples<1>( count );
+		case 2: return MixSamples<2>( count );
+		case 3: return MixSamples<3>( count );
+		case 4: return MixSamples<4>( count );
+
+		jNO_DEFAULT;
+	}
+
+	return 0;		// technically unreachable!
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
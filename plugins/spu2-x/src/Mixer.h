@@ -132,7 +132,10 @@ struct FrequencyResponseFilter
 
 };
 
-extern void	Mix();
+// Longest run of samples mixed by a MixBlock call.
+static const uint MixBlockSize = 64;
+
+extern uint	MixBlock( uint count );
 extern s32	clamp_mix( s32 x, u8 bitshift=0 );
 
 extern StereoOut32 clamp_mix( const StereoOut32& sample, u8 bitshift=0 );
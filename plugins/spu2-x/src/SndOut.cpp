@@ -445,22 +445,42 @@ void SndBuffer::ClearContents()
 	SndBuffer::ssFreeze = 256; //Delays sound output for about 1 second.
 }
 
-void SndBuffer::Write( const StereoOut32& Sample )
+void SndBuffer::Write( const StereoOut32* Samples, int nSamples )
 {
 	// Log final output to wavefile.
-	WaveDump::WriteCore( 1, CoreSrc_External, Sample.DownSample() );
+	if( IsDevBuild )
+	{
+		for( int i=0; i<nSamples; ++i )
+			WaveDump::WriteCore( 1, CoreSrc_External, Samples[i].DownSample() );
+	}
 
-	if( WavRecordEnabled ) RecordWrite( Sample.DownSample() );
+	if( WavRecordEnabled )
+	{
+		for( int i=0; i<nSamples; ++i )
+			RecordWrite( Samples[i].DownSample() );
+	}
 
 	if(mods[OutputModule] == &NullOut) // null output doesn't need buffering or stretching! :p
 		return;
 
-	sndTempBuffer[sndTempProgress++] = Sample;
+	while( nSamples > 0 )
+	{
+		const int count = std::min( nSamples, SndOutPacketSize - sndTempProgress );
+		memcpy( &sndTempBuffer[sndTempProgress], Samples, sizeof(StereoOut32) * count );
+		sndTempProgress += count;
+		Samples += count;
+		nSamples -= count;
+
+		// If we haven't accumulated a full packet yet, do nothing more:
+		if(sndTempProgress < SndOutPacketSize) return;
+		sndTempProgress = 0;
 
-	// If we haven't accumulated a full packet yet, do nothing more:
-	if(sndTempProgress < SndOutPacketSize) return;
-	sndTempProgress = 0;
+		_WritePacket();
+	}
+}
 
+void SndBuffer::_WritePacket()
+{
 	//Don't play anything directly after loading a savestate, avoids static killing your speakers.
 	if ( ssFreeze > 0 )
 	{
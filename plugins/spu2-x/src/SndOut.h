@@ -604,6 +604,7 @@ private:
 	static void UpdateTempoChangeSoundTouch();
 	static void UpdateTempoChangeSoundTouch2();
 
+	static void _WritePacket();
 	static void _WriteSamples(StereoOut32* bData, int nSamples);
 		
 	static void _WriteSamples_Safe(StereoOut32* bData, int nSamples);
@@ -619,7 +620,7 @@ public:
 	static void UpdateTempoChangeAsyncMixing();
 	static void Init();
 	static void Cleanup();
-	static void Write( const StereoOut32& Sample );
+	static void Write( const StereoOut32* Samples, int nSamples );
 	static s32 Test();
 	static void ClearContents();
 
@@ -212,7 +212,11 @@ BOOL WINAPI HandlerRoutine(DWORD dwCtrlType)
 #endif
 
 #include "Windows/Dialogs.h"
-EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdShow)
+
+// Plays the log in real time, or as fast as possible in compare mode, where the voices are
+// mixed by both the scalar and the SSE mixer (see MixCompareState) and the replay stops on
+// the first tick they disagree on.
+static void s2r_play(HWND hwnd, LPSTR filename, bool compare)
 {
 #ifndef ENABLE_NEW_IOPDMA_SPU2
 	int events=0;
@@ -223,7 +227,7 @@ EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdS
 	AllocConsole();
 	SetConsoleCtrlHandler(HandlerRoutine, TRUE);
 	
-	conprintf("Playing %s file on %x...",filename,hwnd);
+	conprintf("%s %s file on %x...",compare?"Comparing mixers on":"Playing",filename,hwnd);
 
 #endif
 
@@ -235,6 +239,10 @@ EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdS
 		conprintf("Could not open the replay file.");
 		return;
 	}
+
+	MixCompare = MixCompareState();
+	MixCompare.Enabled = compare;
+
 	// if successful, init the plugin
 
 #define TryRead(dest,size,count,file) if(fread(dest,size,count,file)<count) { conprintf("Error reading from file.");  goto Finish;  /* Need to exit the while() loop and maybe also the switch */ }
@@ -254,7 +262,7 @@ EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdS
 
 	SPU2async(0);
 
-	while(!feof(file) && Running)
+	while(!feof(file) && Running && !MixCompare.Failed)
 	{
 		u32 ccycle=0;
 		u32 evid=0;
@@ -271,7 +279,14 @@ EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdS
 
 		while(TargetCycle > CurrentIOPCycle)
 		{
-			u32 delta = WaitSync(TargetCycle);
+			u32 delta;
+			if(compare)
+			{
+				delta = TargetCycle - CurrentIOPCycle;
+				CurrentIOPCycle = TargetCycle;
+			}
+			else
+				delta = WaitSync(TargetCycle);
 			SPU2async(delta);
 		}
 		
@@ -309,11 +324,36 @@ Finish:
 
 	conprintf("Finished playing %s file (%d cycles, %d events).",filename,CurrentIOPCycle,events);
 
+	if(compare)
+	{
+		const MixCompareState& mc = MixCompare;
+
+		if(mc.Failed)
+			SysMessage("Mixers differ at tick %u on core %u%s:\n"
+				"scalar: dry %d,%d wet %d,%d\nsse: dry %d,%d wet %d,%d",
+				mc.Tick, mc.Core, mc.StateDiffers ? " (voice state)" : "",
+				mc.Scalar.Dry.Left, mc.Scalar.Dry.Right, mc.Scalar.Wet.Left, mc.Scalar.Wet.Right,
+				mc.Lanes.Dry.Left, mc.Lanes.Dry.Right, mc.Lanes.Wet.Left, mc.Lanes.Wet.Right);
+		else
+			SysMessage("Mixers match (%d events).", events);
+	}
+
 #ifdef _WIN32
 	FreeConsole();
 #endif
 
+	MixCompare.Enabled=false;
 	replay_mode=false;
 #endif
 }
+
+EXPORT_C_(void) s2r_replay(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdShow)
+{
+	s2r_play(hwnd, filename, false);
+}
+
+EXPORT_C_(void) s2r_compare(HWND hwnd, HINSTANCE hinst, LPSTR filename, int nCmdShow)
+{
+	s2r_play(hwnd, filename, true);
+}
 #endif
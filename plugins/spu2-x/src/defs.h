@@ -535,6 +535,24 @@ extern s16		OutPos;
 extern s16		InputPos;
 // SPU Mixing Cycles ("Ticks mixed" counter)
 extern u32		Cycles;
+// Set when an IRQ was raised, signaled before the next tick is mixed
+extern bool		has_to_call_irq;
+
+// Replay compare mode (see s2r_compare): when Enabled, the voices are also mixed by the
+// scalar reference mixer every tick, and the first tick where it disagrees with the SSE
+// mixer is recorded here.
+struct MixCompareState
+{
+	bool		Enabled;
+	bool		Failed;
+	bool		StateDiffers;	// the voice states differed (else only the mixed sums did)
+	uint		Core;
+	u32			Tick;			// Cycles of the failing tick
+	VoiceMixSet	Scalar;
+	VoiceMixSet	Lanes;
+};
+
+extern MixCompareState MixCompare;
 
 extern s16*		spu2regs;
 extern s16*		_spu2mem;
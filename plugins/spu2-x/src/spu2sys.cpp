@@ -438,10 +438,43 @@ __forceinline void TimeUpdate(u32 cClocks)
 						if (Cores[i].Voices[j].Start())
 							Cores[i].KeyOn &= ~(1 << j);
 
+		// The following ticks are mixed in the same block as long as nothing else happens
+		// on them: register writes always come with a new TimeUpdate, IRQs end the block
+		// in MixBlock, and ticks with a pending key on or a DMA interrupt are mixed alone.
+
+		uint ticks = 1 + std::min( dClocks / TickInterval, MixBlockSize - 1 );
+
+		if (Cores[0].KeyOn || Cores[1].KeyOn)
+			ticks = 1;
+
+#ifndef ENABLE_NEW_IOPDMA_SPU2
+		for (int i = 0; i < 2; i++)
+			if (Cores[i].DMAICounter > 0)
+				ticks = std::min( ticks, 1 + (uint)(Cores[i].DMAICounter - 1) / TickInterval );
+#endif
+
 		// Note: IOP does not use MMX regs, so no need to save them.
 		//SaveMMXRegs();
-		Mix();
+		const uint extra = MixBlock( ticks ) - 1;
 		//RestoreMMXRegs();
+
+		// Catch up with the ticks mixed after the first one (MixBlock advanced Cycles).
+		if (extra)
+		{
+			dClocks -= TickInterval * extra;
+			lClocks += TickInterval * extra;
+
+#ifndef ENABLE_NEW_IOPDMA_SPU2
+			for (int i = 0; i < 2; i++)
+			{
+				if (Cores[i].DMAICounter > 0)
+				{
+					Cores[i].DMAICounter -= TickInterval * extra;
+					Cores[i].MADR += (TickInterval * extra) << 1;
+				}
+			}
+#endif
+		}
 	}
 }
 